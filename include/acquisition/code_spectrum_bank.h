@@ -0,0 +1,49 @@
+#ifndef CODE_SPECTRUM_BANK_H
+#define CODE_SPECTRUM_BANK_H
+
+#include <memory>
+#include <vector>
+#include "utils/gps_constants.h"
+
+namespace gps {
+
+/**
+ * @brief Conjugated C/A code spectra for all PRNs at one sampling setup
+ *
+ * Each spectrum is the FFT of the code sampled at sample_rate over
+ * fft_size samples, conjugated so acquisition only has to multiply.
+ * Banks are immutable once built and shared by every acquisition engine
+ * and thread through get().
+ */
+class CodeSpectrumBank {
+public:
+    CodeSpectrumBank(double sample_rate, size_t fft_size);
+    ~CodeSpectrumBank() = default;
+
+    /**
+     * @brief Shared bank for a sampling setup, built on first use
+     * @param sample_rate Sampling rate in Hz
+     * @param fft_size Coherent correlation length in samples
+     * @return Bank holding spectra for PRN 1-32
+     */
+    static std::shared_ptr<const CodeSpectrumBank> get(double sample_rate, size_t fft_size);
+
+    /**
+     * @brief Conjugated code spectrum
+     * @param prn Satellite PRN number (1-32)
+     * @return fft_size bins
+     */
+    const IQSample* spectrum(int prn) const;
+
+    double sampleRate() const { return sample_rate_; }
+    size_t fftSize() const { return fft_size_; }
+
+private:
+    double sample_rate_;
+    size_t fft_size_;
+    IQBuffer spectra_;   // GPS_MAX_SATELLITES * fft_size_, PRN 1 first
+};
+
+}
+
+#endif
@@ -0,0 +1,105 @@
+#ifndef FILE_SOURCE_H
+#define FILE_SOURCE_H
+
+#include <chrono>
+#include <string>
+#include "acquisition/sample_source.h"
+#include "utils/iq_converter.h"
+
+namespace gps {
+
+// On-disk sample formats understood by FileSource
+enum class SampleFileFormat {
+    AUTO,       // Detect from the capture header, fall back to UINT8_IQ
+    UINT8_IQ,   // rtl_sdr output: interleaved unsigned 8-bit I/Q
+    COMPLEX64   // scripts/capture_raw_data.py output: header + complex64
+};
+
+/**
+ * @brief Replays a recorded sample file through a read-only memory mapping
+ *
+ * COMPLEX64 recordings are handed out as zero-copy views into the mapping;
+ * everything else is converted block by block into a staging buffer.
+ */
+class FileSource : public SampleSource {
+public:
+    FileSource();
+    ~FileSource() override;
+
+    /**
+     * @brief Map a recording
+     * @param path File to replay
+     * @param format Sample format, AUTO inspects the file header
+     * @param sample_rate Sample rate for formats that do not store it
+     * @param center_freq Center frequency for formats that do not store it
+     * @return True if the file was mapped successfully
+     */
+    bool open(const std::string& path,
+              SampleFileFormat format = SampleFileFormat::AUTO,
+              double sample_rate = DEFAULT_SAMPLE_RATE,
+              double center_freq = GPS_L1_FREQ_HZ);
+    void close();
+
+    void setReplayMode(ReplayMode mode) { replay_mode_ = mode; }
+    void setLooping(bool enable) { looping_ = enable; }
+
+    bool startCapture() override;
+    void stopCapture() override;
+
+    bool readSamples(SampleSpan<IQSample>& span, size_t num_samples) override;
+    bool readSamples(SampleSpan<IQSample8>& span, size_t num_samples) override;
+    void consumeSamples(size_t num_samples) override;
+
+    bool setSampleFormat(SampleFormat format) override;
+    SampleFormat getSampleFormat() const override { return sample_format_; }
+
+    double getSampleRate() const override { return sample_rate_; }
+    double getCenterFrequency() const override { return center_freq_; }
+    bool isFinished() const override;
+
+    SampleFileFormat getFormat() const { return format_; }
+    size_t getTotalSamples() const { return total_samples_; }
+    size_t getPosition() const { return position_; }
+
+    // Front-end corrections for UINT8_IQ recordings
+    IQConverter& getConverter() { return iq_converter_; }
+
+private:
+    bool detectCaptureHeader(double& sample_rate, double& center_freq) const;
+    void waitForRealtime(size_t end_position);
+
+    // Bounds, looping and pacing shared by both readSamples() overloads
+    bool prepareRead(size_t num_samples);
+
+    int fd_;
+    const uint8_t* map_;
+    size_t map_size_;
+
+    SampleFileFormat format_;
+    const uint8_t* payload_;
+    size_t total_samples_;
+    size_t position_;
+
+    double sample_rate_;
+    double center_freq_;
+
+    SampleFormat sample_format_;
+    ReplayMode replay_mode_;
+    bool looping_;
+    bool is_running_;
+
+    // Samples delivered before the current start, for realtime pacing
+    size_t pace_origin_;
+    std::chrono::steady_clock::time_point start_time_;
+
+    IQConverter iq_converter_;
+    IQBuffer staging_;
+    IQBuffer8 staging8_;
+
+    // scripts/capture_raw_data.py: uint32 count, double rate, double freq
+    static constexpr size_t CAPTURE_HEADER_SIZE = 4 + 8 + 8;
+};
+
+}
+
+#endif
\ No newline at end of file
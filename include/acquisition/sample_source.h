@@ -0,0 +1,82 @@
+#ifndef SAMPLE_SOURCE_H
+#define SAMPLE_SOURCE_H
+
+#include <cstdint>
+#include "utils/gps_constants.h"
+#include "utils/ring_buffer.h"
+
+namespace gps {
+
+// How fast a finite or synthetic source is fed to the consumer
+enum class ReplayMode {
+    MAX_SPEED,  // As fast as the consumer reads
+    REALTIME    // Paced to the source's sample rate
+};
+
+/**
+ * @brief Abstract producer of complex baseband samples
+ *
+ * Implemented by the RTL-SDR front end and by file replay, so the rest of
+ * the receiver does not care where samples come from.
+ */
+class SampleSource {
+public:
+    virtual ~SampleSource() = default;
+
+    virtual bool startCapture() = 0;
+    virtual void stopCapture() = 0;
+
+    /**
+     * @brief Zero-copy read of the next num_samples samples
+     * @param span Set to a contiguous view of the samples
+     * @param num_samples Number of samples requested
+     * @return False on timeout, end of stream or when capture stopped
+     *
+     * The view stays valid until consumeSamples() is called.
+     */
+    virtual bool readSamples(SampleSpan<IQSample>& span, size_t num_samples) = 0;
+    virtual void consumeSamples(size_t num_samples) = 0;
+
+    /**
+     * @brief Select the representation handed out by readSamples()
+     * @param format FLOAT32 or INT8, must be set before startCapture()
+     * @return False if the source does not support the format
+     */
+    virtual bool setSampleFormat(SampleFormat format) { return format == SampleFormat::FLOAT32; }
+    virtual SampleFormat getSampleFormat() const { return SampleFormat::FLOAT32; }
+
+    // Fixed-point counterpart of readSamples(), valid in INT8 format
+    virtual bool readSamples(SampleSpan<IQSample8>& span, size_t num_samples) {
+        (void)span;
+        (void)num_samples;
+        return false;
+    }
+
+    // Copying read, kept for callers that need an owned buffer
+    bool getSamples(IQBuffer& buffer, size_t num_samples) {
+        SampleSpan<IQSample> span;
+        if (!readSamples(span, num_samples)) {
+            return false;
+        }
+
+        buffer.assign(span.data, span.data + span.size);
+        consumeSamples(num_samples);
+        return true;
+    }
+
+    // Largest num_samples readSamples() can ever satisfy, 0 if unbounded
+    virtual size_t getMaxReadSize() const { return 0; }
+
+    virtual double getSampleRate() const = 0;
+    virtual double getCenterFrequency() const = 0;
+
+    // True once a finite source (e.g. a recording) has been fully consumed
+    virtual bool isFinished() const { return false; }
+
+    // Blocks discarded because the consumer fell behind
+    virtual uint64_t getDroppedBlocks() const { return 0; }
+};
+
+}
+
+#endif
\ No newline at end of file
@@ -4,17 +4,21 @@
 #include <atomic>
 #include <condition_variable>
 #include <mutex>
-#include <queue>
 #include <thread>
 #include <memory>
+#include "acquisition/sample_source.h"
 #include "utils/gps_constants.h"
+#include "utils/iq_converter.h"
+#include "utils/ring_buffer.h"
+
+typedef struct rtlsdr_dev rtlsdr_dev_t;
 
 namespace gps {
 
-class SDRReceiver {
+class SDRReceiver : public SampleSource {
 public:
     SDRReceiver();
-    ~SDRReceiver();
+    ~SDRReceiver() override;
 
     
     bool initializeDevice(int device_index = 0, 
@@ -22,27 +26,44 @@ public:
                          double center_freq = GPS_L1_FREQ_HZ);
 
     
-    bool startCapture();
-    void stopCapture();
+    bool startCapture() override;
+    void stopCapture() override;
 
-    
-    bool getSamples(IQBuffer& buffer, size_t num_samples);
+    static constexpr size_t MAX_BUFFER_SIZE = 1024 * 1024;
+    // The whole ring is mirrored, so any read that fits is one span
+    static constexpr size_t MAX_READ_SIZE = MAX_BUFFER_SIZE;
+
+    // Spans point into the sample ring, at most MAX_READ_SIZE samples each
+    bool readSamples(SampleSpan<IQSample>& span, size_t num_samples) override;
+    bool readSamples(SampleSpan<IQSample8>& span, size_t num_samples) override;
+    void consumeSamples(size_t num_samples) override;
+    size_t getMaxReadSize() const override { return MAX_READ_SIZE; }
 
+    bool setSampleFormat(SampleFormat format) override;
+    SampleFormat getSampleFormat() const override { return sample_format_; }
+
+    // USB blocks discarded because the consumer fell behind
+    uint64_t getDroppedBlocks() const override;
     
 
-    double getSampleRate() const { return sample_rate_; }
-    double getCenterFrequency() const { return center_freq_; }
+    double getSampleRate() const override { return sample_rate_; }
+    double getCenterFrequency() const override { return center_freq_; }
 
     
     bool setGain(int gain_db);
     bool setAutoGain(bool enable);
 
+    // Front-end corrections applied during byte-to-float conversion
+    void setDCRemoval(bool enable) { iq_converter_.setDCRemoval(enable); }
+    void setIQImbalanceCorrection(bool enable) { iq_converter_.setImbalanceCorrection(enable); }
+
 private:
     
     static void rtlsdrCallback(unsigned char* buf, uint32_t len, void* ctx);
     void processRawData(unsigned char* buf, uint32_t len);
 
     
+    rtlsdr_dev_t* device_;
 
     
     double sample_rate_;
@@ -52,15 +73,23 @@ private:
     
     std::thread capture_thread_;
     std::atomic<bool> is_running_;
-    
-    // Circular buffer for samples
-    std::queue<IQSample> sample_buffer_;
-    std::mutex buffer_mutex_;
+
+    // Lock-free sample ring; the callback writes whole USB blocks into it.
+    // Only the ring matching sample_format_ is allocated.
+    SampleFormat sample_format_;
+    std::unique_ptr<SpscRingBuffer<IQSample>> sample_ring_;
+    std::unique_ptr<SpscRingBuffer<IQSample8>> sample_ring8_;
+
+    template <typename T>
+    bool waitForSamples(SpscRingBuffer<T>& ring, SampleSpan<T>& span, size_t num_samples);
+
+    // Only used to park the consumer while the ring is empty
+    std::mutex wait_mutex_;
     std::condition_variable buffer_cv_;
-    static constexpr size_t MAX_BUFFER_SIZE = 1024 * 1024;  
 
     // Convert 8-bit unsigned to float IQ
-    void convertToIQ(const unsigned char* raw_data, size_t len, IQBuffer& iq_data);
+    IQConverter iq_converter_;
+    void convertToIQ(const unsigned char* raw_data, size_t len, IQSample* iq_data);
 };
 
 } 
@@ -1,11 +1,16 @@
 #ifndef SIGNAL_ACQUISITION_H
 #define SIGNAL_ACQUISITION_H
 
+#include <algorithm>
 #include <vector>
 #include <complex>
+#include <functional>
+#include <map>
 #include <memory>
+#include "acquisition/code_spectrum_bank.h"
+#include "utils/fft_processor.h"
 #include "utils/gps_constants.h"
-#include "utils/prn_generator.h"
+#include "utils/thread_pool.h"
 
 namespace gps {
 
@@ -19,11 +24,26 @@ struct AcquisitionResult {
     double snr_estimate;    // Estimated SNR in dB
 };
 
+// Doppler range searched for one PRN
+struct DopplerWindow {
+    double min;     // Hz
+    double max;     // Hz
+};
+
+// How Doppler bins are applied to the input block
+enum class DopplerSearchMode {
+    CARRIER_WIPEOFF,   // Mix and forward-FFT the input once per bin
+    SPECTRUM_SHIFT     // FFT once per fractional residual, rotate by whole bins
+};
+
 /**
  * @brief GPS signal acquisition engine
  * 
  * Performs parallel code phase search using FFT-based correlation
- * and serial frequency search over Doppler range.
+ * and a frequency search over the Doppler range. With parallel
+ * processing enabled the (PRN, Doppler bin) grid is spread over a
+ * work-stealing pool. A PRN stops searching one bin past its first
+ * detected Doppler peak; results are the same with or without the pool.
  */
 class SignalAcquisition {
 public:
@@ -55,6 +75,51 @@ public:
         const IQBuffer& samples,
         const std::vector<int>& prn_list);
     
+    /**
+     * @brief Search many PRNs with one input spectrum per Doppler bin
+     * @param samples Input IQ samples
+     * @param prn_list List of PRNs to search
+     * @param doppler_min Minimum Doppler frequency to search
+     * @param doppler_max Maximum Doppler frequency to search
+     * @param doppler_step Doppler search step size
+     * @return Vector of acquisition results, in prn_list order
+     *
+     * Each Doppler bin rotates the input spectrum once, multiplies it
+     * against BATCH_PRNS code spectra at a time in cache-sized blocks and
+     * runs their inverse FFTs as one batch. Peaks are taken from each
+     * inverse output as it is produced, so no correlation grid is stored.
+     * Every bin is searched; there is no early exit.
+     */
+    std::vector<AcquisitionResult> searchBatch(
+        const IQBuffer& samples,
+        const std::vector<int>& prn_list,
+        double doppler_min = -DOPPLER_SEARCH_RANGE,
+        double doppler_max = DOPPLER_SEARCH_RANGE,
+        double doppler_step = DOPPLER_SEARCH_STEP);
+
+    static constexpr size_t BATCH_PRNS = 8;
+
+    /**
+     * @brief Hierarchical search: decimated coarse pass, full-rate refinement
+     * @param samples Input IQ samples, ideally getFineIntegration() ms or more
+     * @param prn_list List of PRNs to search
+     * @return Vector of acquisition results, in prn_list order
+     *
+     * The coarse pass runs the batched search on the input decimated to
+     * about one sample per chip. Each detection is then refined at the full
+     * sample rate: code phase within one chip of the coarse estimate, and
+     * Doppler from a long zero-padded FFT of the code-wiped signal.
+     */
+    std::vector<AcquisitionResult> searchTwoStage(const IQBuffer& samples,
+                                                  const std::vector<int>& prn_list);
+
+    /**
+     * @brief Coherent length of the fine Doppler estimate
+     * @param milliseconds Code periods used by the refinement (1-20)
+     */
+    void setFineIntegration(int milliseconds) { fine_ms_ = std::max(1, std::min(20, milliseconds)); }
+    int getFineIntegration() const { return fine_ms_; }
+
     /**
      * @brief Set acquisition threshold
      * @param threshold Detection threshold (typical: 2.5)
@@ -62,23 +127,166 @@ public:
     void setThreshold(double threshold) { threshold_ = threshold; }
     
     /**
-     * @brief 
-     * @param enable 
+     * @brief Spread the PRN x Doppler grid over a thread pool
+     * @param enable True to search in parallel
      */
     void setParallelProcessing(bool enable) { use_parallel_ = enable; }
 
+    /**
+     * @brief Set the number of acquisition threads
+     * @param num_threads Worker count including the caller, 0 uses
+     *                    hardware_concurrency()
+     */
+    void setNumThreads(unsigned num_threads);
+
+    /**
+     * @brief Select how the Doppler search is carried out
+     * @param mode SPECTRUM_SHIFT (default) or CARRIER_WIPEOFF
+     */
+    void setDopplerSearchMode(DopplerSearchMode mode) { doppler_mode_ = mode; }
+
+    /**
+     * @brief Set the coherent integration time
+     * @param milliseconds Code periods per coherent block (1-10)
+     *
+     * Longer blocks narrow the FFT bins, so searchAllSatellites() and the
+     * dwell shrink their Doppler step to match.
+     */
+    void setCoherentIntegration(int milliseconds);
+    int getCoherentIntegration() const { return coherent_ms_; }
+
+    // Samples consumed by one coherent block
+    size_t getBlockSize() const { return fft_forward_plan_->size(); }
+
+    /**
+     * @brief Set the number of coherent blocks summed non-coherently
+     * @param blocks Blocks per dwell (>= 1)
+     */
+    void setNonCoherentBlocks(int blocks) { noncoherent_blocks_ = std::max(1, blocks); }
+
+    /**
+     * @brief Combine consecutive blocks pairwise, keeping the stronger one
+     * @param enable True to guard against navigation bit transitions
+     *
+     * At most one of two consecutive half-bit (10 ms) blocks can contain
+     * a data bit transition, so taking the larger power of each pair per
+     * cell avoids the cancellation a transition causes. Only applies with
+     * HALF_BIT_MS coherent blocks: shorter ones never straddle a half-bit,
+     * and pairing them would just halve the number of sums.
+     */
+    void setHalfBitCombining(bool enable) { half_bit_combining_ = enable; }
+
+    // Coherent integration that spans half a navigation data bit
+    static constexpr int HALF_BIT_MS = 10;
+
+    /**
+     * @brief Peak ratio at which a PRN is reported before the dwell ends
+     * @param ratio Decisive peak to second peak ratio
+     */
+    void setEarlyReportRatio(double ratio) { early_report_ratio_ = ratio; }
+
+    /**
+     * @brief Start a multi-block search with a fresh accumulation grid
+     * @param prn_list PRNs to search
+     * @param doppler_min Minimum Doppler frequency to search
+     * @param doppler_max Maximum Doppler frequency to search
+     * @param doppler_step Doppler step, 0 for DOPPLER_SEARCH_STEP per ms
+     */
+    void beginDwell(const std::vector<int>& prn_list,
+                    double doppler_min = -DOPPLER_SEARCH_RANGE,
+                    double doppler_max = DOPPLER_SEARCH_RANGE,
+                    double doppler_step = 0.0);
+
+    /**
+     * @brief Start a dwell with a Doppler window per PRN
+     * @param prn_list PRNs to search
+     * @param windows Window of each PRN, same order
+     * @param doppler_step Doppler step, 0 for DOPPLER_SEARCH_STEP per ms
+     *
+     * Input spectra are prepared once over the union of the windows, but
+     * each PRN is only correlated in the bins of its own window.
+     */
+    void beginDwell(const std::vector<int>& prn_list,
+                    const std::vector<DopplerWindow>& windows,
+                    double doppler_step = 0.0);
+
+    /**
+     * @brief Add one coherent block to the dwell
+     * @param samples At least getBlockSize() samples, contiguous with the
+     *                previous block
+     * @return True once the dwell is complete or every PRN is decided
+     */
+    bool accumulateBlock(const IQBuffer& samples);
+
+    /**
+     * @brief Current dwell results, valid at any point during the dwell
+     * @return One result per PRN; decided PRNs are final
+     */
+    std::vector<AcquisitionResult> getDwellResults() const { return dwell_results_; }
+    bool isDwellComplete() const;
+
 private:
+    // One Doppler hypothesis: an input spectrum rotated by whole FFT bins
+    struct DopplerBin {
+        double doppler;      // Hz
+        int bin_shift;       // Whole bins removed by rotation
+        size_t spectrum;     // Index into input_spectra_
+    };
+
+    // FFT the input block once per distinct residual frequency
+    void prepareDopplerSearch(const IQBuffer& samples,
+                              double doppler_min,
+                              double doppler_max,
+                              double doppler_step);
+
+    // Per worker correlation buffers
+    struct WorkerScratch {
+        IQBuffer fft_buffer;
+        std::vector<float> correlation;
+        std::vector<float> paired;      // First block of a half-bit pair
+        IQBuffer shifted;               // Rotated input spectrum (batched)
+        IQBuffer batch;                 // BATCH_PRNS correlation buffers
+    };
+
+    // Best peak found in one (PRN, Doppler bin) cell
+    struct CellPeak {
+        bool searched;
+        double peak_value;
+        size_t peak_index;
+        double peak_ratio;
+        double mean_power;
+    };
+
+    std::vector<AcquisitionResult> searchPrepared(const std::vector<int>& prn_list);
+
+    void searchCell(int prn, const DopplerBin& bin, WorkerScratch& scratch, CellPeak& cell);
+
+    // findPeak() on the power of one code period of an inverse FFT output
+    void detectPeak(const IQSample* correlation, WorkerScratch& scratch, CellPeak& cell) const;
+
+    // Fine stage of searchTwoStage(), updates code phase and Doppler in place
+    void refineCandidate(const IQBuffer& samples, size_t decimation, AcquisitionResult& result);
+
+    // Rebuild plans and code spectra for the coherent block length
+    void configureBlockSize();
+
+    // Run task(index, worker) inline or on the pool
+    void runTasks(size_t count, const std::function<void(size_t, unsigned)>& task);
+
+    // Fold the dwell's input spectra into the non-coherent grid
+    void accumulateGrid();
+    void updateDwellResults();
+
+    const IQBuffer& residualCarrier(double frequency);
+
+    void performFFTCorrelation(const IQBuffer& input_spectrum,
+                              int bin_shift,
+                              const IQSample* code_spectrum,
+                              WorkerScratch& scratch);
     
-    void performFFTCorrelation(const IQBuffer& samples,
-                              const std::vector<float>& prn_code,
-                              double doppler_shift,
-                              std::vector<float>& correlation_result);
-    
-    
-    void findPeak(const std::vector<float>& correlation,
-                 double& peak_value,
-                 size_t& peak_index,
-                 double& peak_ratio);
+    // Peak, ratio to the largest value more than a chip away, and mean
+    // power of one row of correlation power
+    void findPeak(const float* power, size_t length, CellPeak& cell) const;
     
     
     void generateCarrier(size_t length, double frequency, 
@@ -88,18 +296,56 @@ private:
     double sample_rate_;
     double threshold_;
     bool use_parallel_;
+    unsigned num_threads_;
+    DopplerSearchMode doppler_mode_;
+
+    int coherent_ms_;
+    int noncoherent_blocks_;
+    bool half_bit_combining_;
+    double early_report_ratio_;
+    size_t code_samples_;          // Samples per code period
+
+    // Dwell state: one power row of code_samples_ lags per (PRN, bin)
+    std::vector<int> dwell_prns_;
+    std::vector<size_t> dwell_first_bin_;   // Bins of each PRN's window
+    std::vector<size_t> dwell_last_bin_;
+    std::vector<float> dwell_grid_;
+    std::vector<char> dwell_decided_;
+    std::vector<AcquisitionResult> dwell_results_;
+    double dwell_doppler_min_;
+    double dwell_doppler_max_;
+    double dwell_doppler_step_;
+    int dwell_blocks_;
+    IQBuffer pending_block_;       // First block of a half-bit pair
+    bool has_pending_block_;
+    std::vector<IQBuffer> pending_spectra_;
+
+    // Two-stage search: engine at the decimated rate and fine FFT buffer
+    std::unique_ptr<SignalAcquisition> coarse_;
+    size_t coarse_decimation_;
+    int fine_ms_;
+    IQBuffer decimated_;
+    IQBuffer fine_buffer_;
+
+    // Created on the first parallel search
+    std::unique_ptr<WorkStealingPool> pool_;
+    std::vector<WorkerScratch> worker_scratch_;
     
     
-    std::unique_ptr<PRNGenerator> prn_generator_;
+    // Conjugated code spectra shared with every other acquisition engine
+    std::shared_ptr<const CodeSpectrumBank> code_bank_;
     
     
-    void* fft_forward_plan_;
-    void* fft_inverse_plan_;
+    std::shared_ptr<const FFTPlan> fft_forward_plan_;
+    std::shared_ptr<const FFTPlan> fft_inverse_plan_;
     
     
-    std::vector<std::complex<float>> fft_buffer_;
-    std::vector<std::complex<float>> code_fft_;
-    std::vector<std::complex<float>> carrier_buffer_;
+    // Per block: Doppler bins and the input spectra they rotate
+    std::vector<DopplerBin> doppler_bins_;
+    std::vector<IQBuffer> input_spectra_;
+
+    // Carrier wipe-off tables by residual frequency in mHz, kept across blocks
+    std::map<long long, IQBuffer> residual_carriers_;
 };
 
 } 
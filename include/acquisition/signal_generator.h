@@ -0,0 +1,131 @@
+#ifndef SIGNAL_GENERATOR_H
+#define SIGNAL_GENERATOR_H
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+#include "acquisition/file_source.h"
+#include "acquisition/sample_source.h"
+#include "utils/gps_constants.h"
+#include "utils/thread_pool.h"
+
+namespace gps {
+
+// One simulated GPS L1 C/A signal
+struct SyntheticSatellite {
+    int prn = 1;
+    double doppler = 0.0;           // Hz at t = 0
+    double doppler_rate = 0.0;      // Hz/s
+    double code_phase = 0.0;        // chips at t = 0
+    double carrier_phase = 0.0;     // radians at t = 0
+    double cn0 = 45.0;              // dB-Hz
+    bool nav_data = true;           // Modulate random 50 bps data bits
+};
+
+struct SignalGeneratorConfig {
+    double sample_rate = DEFAULT_SAMPLE_RATE;
+    double center_freq = GPS_L1_FREQ_HZ;
+    double noise_sigma = 0.25;      // Per I/Q component, float units
+    double duration = 0.0;          // Seconds, 0 streams forever
+    unsigned num_threads = 0;       // 0 uses hardware_concurrency()
+    uint64_t seed = 1;
+    std::vector<SyntheticSatellite> satellites;
+};
+
+/**
+ * @brief Synthetic multi-satellite GPS L1 C/A baseband source
+ *
+ * Every signal parameter is a closed-form function of the absolute sample
+ * index, and noise is seeded per fixed-size chunk, so output is identical
+ * no matter how generation is split across threads. Chunks are handed to
+ * a pool of workers kept for the generator's lifetime.
+ *
+ * Per sample the inner loop is a code table lookup and a complex rotator
+ * update; trig is only evaluated once per sub-block to re-anchor phase.
+ */
+class SignalGenerator : public SampleSource {
+public:
+    explicit SignalGenerator(const SignalGeneratorConfig& config);
+    ~SignalGenerator() override = default;
+
+    /**
+     * @brief Generate samples at an absolute position in the stream
+     * @param start_sample Index of the first sample
+     * @param num_samples Number of samples
+     * @param out Output, must hold num_samples samples
+     */
+    void generate(uint64_t start_sample, size_t num_samples, IQSample* out) const;
+
+    /**
+     * @brief Write a recording readable by FileSource
+     * @param path Output file
+     * @param format UINT8_IQ (rtl_sdr) or COMPLEX64 (capture_raw_data.py)
+     * @param duration Seconds of signal to write
+     * @return True on success
+     */
+    bool writeRecording(const std::string& path, SampleFileFormat format, double duration) const;
+
+    void setReplayMode(ReplayMode mode) { replay_mode_ = mode; }
+
+    bool startCapture() override;
+    void stopCapture() override;
+
+    bool readSamples(SampleSpan<IQSample>& span, size_t num_samples) override;
+    bool readSamples(SampleSpan<IQSample8>& span, size_t num_samples) override;
+    void consumeSamples(size_t num_samples) override;
+
+    bool setSampleFormat(SampleFormat format) override;
+    SampleFormat getSampleFormat() const override { return sample_format_; }
+
+    double getSampleRate() const override { return config_.sample_rate; }
+    double getCenterFrequency() const override { return config_.center_freq; }
+    bool isFinished() const override;
+
+    const SignalGeneratorConfig& getConfig() const { return config_; }
+
+    // Navigation bit k of a satellite (+1 / -1), reproducible from the seed
+    int navigationBit(int prn, uint64_t bit_index) const;
+
+    // Noise is seeded per chunk of this many samples
+    static constexpr size_t NOISE_CHUNK = 4096;
+
+private:
+    struct SatelliteState {
+        SyntheticSatellite params;
+        std::vector<float> code;    // 1023 chips, +1/-1
+        float amplitude;
+    };
+
+    void addSatellite(const SatelliteState& sat, uint64_t start_sample,
+                      size_t num_samples, IQSample* out) const;
+    void addNoise(uint64_t start_sample, size_t num_samples, IQSample* out) const;
+
+    // Ensure window_ holds [position_, position_ + num_samples)
+    bool fillWindow(size_t num_samples);
+
+    SignalGeneratorConfig config_;
+    std::vector<SatelliteState> satellites_;
+    unsigned num_threads_;
+    std::unique_ptr<WorkStealingPool> pool_;    // Null with a single thread
+    uint64_t total_samples_;        // 0 when streaming forever
+
+    // Streaming state
+    IQBuffer window_;
+    uint64_t window_start_;
+    size_t window_size_;
+    uint64_t position_;
+    IQBuffer8 staging8_;
+
+    SampleFormat sample_format_;
+    ReplayMode replay_mode_;
+    bool is_running_;
+    uint64_t pace_origin_;
+    std::chrono::steady_clock::time_point start_time_;
+
+    static constexpr size_t GENERATE_BLOCK = 256 * 1024;
+};
+
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,97 @@
+#ifndef VISIBILITY_PREDICTOR_H
+#define VISIBILITY_PREDICTOR_H
+
+#include <array>
+#include <vector>
+#include "utils/gps_constants.h"
+
+namespace gps {
+
+// Approximate receiver position, WGS-84
+struct ReceiverPosition {
+    double latitude;    // degrees
+    double longitude;   // degrees
+    double height;      // m above the ellipsoid
+};
+
+// Expected signal of a satellite above the mask
+struct VisibilityPrediction {
+    int prn;
+    double elevation;               // degrees
+    double azimuth;                 // degrees from north
+    double doppler;                 // Hz, including the clock offset
+    double doppler_uncertainty;     // Hz either side
+};
+
+struct VisibilityConfig {
+    double elevation_mask = 5.0;            // degrees
+    double position_uncertainty = 50e3;     // m
+    double time_uncertainty = 10.0;         // s
+    double clock_offset = 0.0;              // Hz, receiver oscillator error at L1
+    double clock_uncertainty = 1600.0;      // Hz, about 1 ppm
+};
+
+/**
+ * @brief Predicts which satellites are up and at what Doppler from the almanac
+ *
+ * Satellite positions follow the ICD orbit equations with the almanac's
+ * reduced parameter set; velocity is the central difference over one
+ * second. Doppler windows grow with the uncertainty in receiver
+ * position, time and oscillator offset, and the elevation mask is
+ * lowered by how far those could move a satellite. Once one satellite
+ * is tracked, the common offset of measured from predicted Doppler
+ * pins down the oscillator and the windows shrink to the almanac error.
+ */
+class VisibilityPredictor {
+public:
+    explicit VisibilityPredictor(const VisibilityConfig& config = VisibilityConfig());
+    ~VisibilityPredictor() = default;
+
+    void setConfig(const VisibilityConfig& config) { config_ = config; }
+    const VisibilityConfig& getConfig() const { return config_; }
+
+    /**
+     * @brief Satellites above the elevation mask
+     * @param almanac Almanac of each satellite to consider
+     * @param position Approximate receiver position
+     * @param time_of_week GPS seconds of week
+     * @return One prediction per visible satellite, in almanac order
+     */
+    std::vector<VisibilityPrediction> predict(const std::vector<AlmanacData>& almanac,
+                                              const ReceiverPosition& position,
+                                              double time_of_week) const;
+
+    /**
+     * @brief Oscillator offset from satellites already tracked
+     * @param predictions Output of predict() with the current configuration
+     * @param satellites Channel states; tracked ones with a prediction are used
+     * @param offset Receives the clock_offset that best fits the measurements
+     * @return True if at least one satellite was used
+     */
+    bool estimateClockOffset(const std::vector<VisibilityPrediction>& predictions,
+                             const std::vector<SatelliteInfo>& satellites,
+                             double& offset) const;
+
+    // Satellite position in ECEF, m
+    static std::array<double, 3> satellitePosition(const AlmanacData& almanac,
+                                                   double time_of_week);
+
+    // Receiver position in ECEF, m
+    static std::array<double, 3> receiverPosition(const ReceiverPosition& position);
+
+    // Doppler left once the clock offset is known: almanac orbit error
+    static constexpr double ALMANAC_DOPPLER_ERROR = 150.0;
+
+private:
+    VisibilityConfig config_;
+};
+
+/**
+ * @brief GPS seconds of week at a Unix time
+ * @param unix_time Seconds since 1970, UTC
+ */
+double gpsTimeOfWeek(double unix_time);
+
+}
+
+#endif
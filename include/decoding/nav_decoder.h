@@ -1,14 +1,56 @@
 #ifndef NAV_DECODER_H
 #define NAV_DECODER_H
 
-#include <vector>
-#include <map>
-#include <memory>
-#include <bitset>
+#include <array>
+#include <cstdint>
+#include <functional>
 #include "utils/gps_constants.h"
 
 namespace gps {
 
+/**
+ * @brief Last bits of a navigation bit stream, packed 64 to a word
+ *
+ * Bits are numbered from the start of the stream and stored most
+ * significant first, so any 64 consecutive bits still held come out of
+ * two words with one funnel shift.
+ */
+class NavBitRing {
+public:
+    static constexpr size_t WORDS = 16;
+    static constexpr uint64_t CAPACITY = WORDS * 64;
+
+    void push(bool bit) {
+        const size_t index = static_cast<size_t>(count_ >> 6) & (WORDS - 1);
+        const unsigned offset = static_cast<unsigned>(count_ & 63);
+        if (offset == 0) {
+            words_[index] = 0;
+        }
+        words_[index] |= static_cast<uint64_t>(bit) << (63 - offset);
+        ++count_;
+    }
+
+    // Bits pushed since the start of the stream
+    uint64_t count() const { return count_; }
+
+    // Bits first .. first + 63, first bit in the MSB
+    uint64_t get64(uint64_t first) const {
+        const uint64_t hi = words_[static_cast<size_t>(first >> 6) & (WORDS - 1)];
+        const uint64_t lo = words_[static_cast<size_t>((first >> 6) + 1) & (WORDS - 1)];
+        const unsigned shift = static_cast<unsigned>(first & 63);
+        return shift == 0 ? hi : (hi << shift) | (lo >> (64 - shift));
+    }
+
+    // Bits first .. first + length - 1 in the low bits, length 1 to 32
+    uint32_t get(uint64_t first, unsigned length) const {
+        return static_cast<uint32_t>(get64(first) >> (64 - length));
+    }
+
+private:
+    std::array<uint64_t, WORDS> words_{};
+    uint64_t count_ = 0;
+};
+
 /**
  * @brief GPS navigation message decoder
  * 
@@ -17,14 +59,44 @@ namespace gps {
  * - Almanac data  
  * - Time parameters
  * - Ionospheric corrections
+ *
+ * Bits go into a NavBitRing per satellite. Until subframe sync, every
+ * 64 bit offsets are tested against the preamble and its inverse in one
+ * pass of shifts and compares; each word's parity is a popcount per
+ * parity bit; fields are read with shift/mask accessors fixed at compile
+ * time from their ICD bit numbers.
+ *
+ * Bits are pushed as the tracker produces them. Each PRN runs its own
+ * frame sync: SEARCH until a preamble passes parity, VERIFY until the
+ * next subframe follows it in ID and TOW, then LOCKED, reading each
+ * subframe as its last bit comes in. Nothing is done between subframes
+ * beyond storing the bit, and callbacks report completed subframes and
+ * ephemerides.
  */
 class NavigationDecoder {
 public:
+    // One subframe, parity checked
+    struct Subframe {
+        std::array<uint32_t, 10> words{};   // 24 data bits each, parity removed
+        int id = 0;
+        bool valid = false;
+        double tow = -1.0;                  // Seconds of week at its start
+    };
+
+    using SubframeCallback = std::function<void(int prn, const Subframe& subframe)>;
+    using EphemerisCallback = std::function<void(const EphemerisData& ephemeris)>;
+
     NavigationDecoder();
     ~NavigationDecoder() = default;
+
+    // Called from addNavigationBit() as each subframe is accepted
+    void setSubframeCallback(SubframeCallback callback);
+
+    // Called when subframes 2 and 3 complete a new ephemeris
+    void setEphemerisCallback(EphemerisCallback callback);
     
     /**
-     * @brief Process navigation data bits
+     * @brief Store subframes framed elsewhere
      * @param prn Satellite PRN number
      * @param nav_data Navigation data structure with subframes
      * @return True if new ephemeris data was decoded
@@ -47,6 +119,25 @@ public:
      */
     bool getEphemeris(int prn, EphemerisData& ephemeris) const;
     
+    /**
+     * @brief Use an ephemeris from elsewhere, such as a hot start snapshot
+     * @param ephemeris Ephemeris, prn selects the satellite
+     *
+     * It is replaced by the next one decoded from the broadcast.
+     */
+    void setEphemeris(const EphemerisData& ephemeris);
+    
+    /**
+     * @brief Get the almanac of a satellite
+     * @param prn Satellite PRN number
+     * @param almanac Output almanac
+     * @return True if its almanac page has been decoded from any satellite
+     */
+    bool getAlmanac(int prn, AlmanacData& almanac) const;
+
+    // Use an almanac from elsewhere, replaced by the next one decoded
+    void setAlmanac(const AlmanacData& almanac);
+    
     /**
      * @brief Check if ephemeris is valid and current
      * @param prn Satellite PRN number
@@ -61,40 +152,51 @@ public:
      */
     double getTimeOfWeek(int prn) const;
 
-private:
-    
-    struct Subframe {
-        std::bitset<300> bits;  
-        int id;                 
-        bool valid;
-        double tow;             
+    // Frame sync state of a PRN
+    enum class FrameSync {
+        SEARCH,     // Looking for a preamble
+        VERIFY,     // One candidate subframe, waiting for the next to confirm it
+        LOCKED      // Reading subframes every 300 bits
     };
-    
+
+    FrameSync getFrameSync(int prn) const;
+
+private:
     
     struct SatelliteData {
-        std::vector<bool> bit_buffer;
-        std::map<int, Subframe> subframes;
-        EphemerisData ephemeris;
-        bool ephemeris_valid;
-        double last_update_time;
+        NavBitRing bits;
+        FrameSync sync = FrameSync::SEARCH;
+        bool inverted = false;              // Costas loop locked half a cycle off
+        uint64_t next_subframe = 0;         // Bit of the next preamble once VERIFY
+        uint64_t scan_from = 2;             // First preamble offset not yet tested
+        Subframe last;                      // Candidate in VERIFY, else last read
+        std::array<Subframe, 5> subframes;  // By subframe ID - 1
+        EphemerisData ephemeris{};
+        bool ephemeris_valid = false;
+        double tow = -1.0;
+        double last_update_time = 0.0;
     };
     
     
-    bool decodeSubframe1(const Subframe& sf, EphemerisData& eph);
     bool decodeSubframe2(const Subframe& sf, EphemerisData& eph);
     bool decodeSubframe3(const Subframe& sf, EphemerisData& eph);
+    // Almanac pages of subframes 4 and 5; false for pages of other data
+    bool decodeAlmanac(const Subframe& sf, AlmanacData& alm);
     
     
-    bool checkParity(const std::bitset<30>& word);
-    uint32_t extractBits(const std::bitset<300>& bits, int start, int length);
-    double extractSigned(const std::bitset<300>& bits, int start, int length, double scale);
-    
+    // Reads and parity checks the subframe whose preamble starts at first
+    bool extractSubframe(const NavBitRing& bits, uint64_t first, bool inverted, Subframe& sf);
+    bool findPreamble(SatelliteData& sat);
+    bool storeSubframe(int prn, SatelliteData& sat, const Subframe& sf);
     
-    bool findPreamble(const std::vector<bool>& bits, size_t& preamble_pos);
-    bool extractSubframe(const std::vector<bool>& bits, size_t start_pos, Subframe& sf);
     
-    
-    std::map<int, SatelliteData> satellite_data_;
+    // Indexed by PRN, entry 0 unused
+    std::array<SatelliteData, GPS_MAX_SATELLITES + 1> satellites_;
+    // Every satellite broadcasts the almanac of all of them
+    std::array<AlmanacData, GPS_MAX_SATELLITES + 1> almanac_{};
+    std::array<bool, GPS_MAX_SATELLITES + 1> almanac_valid_{};
+    SubframeCallback on_subframe_;
+    EphemerisCallback on_ephemeris_;
     
     
     static constexpr uint32_t PREAMBLE = 0x8B;  
@@ -102,6 +204,15 @@ private:
     static constexpr int SUBFRAME_SIZE = 300;
 };
 
+/**
+ * @brief Check the parity of one navigation word (ICD-GPS-200 20.3.5)
+ * @param word D29* and D30* of the previous word in bits 31-30, then
+ *             the 30 bits of the word, D1 first
+ * @param data Receives D1-D24 with the D30* inversion undone
+ * @return True if D25-D30 match
+ */
+bool checkWordParity(uint32_t word, uint32_t& data);
+
 } 
 
 #endif 
\ No newline at end of file
@@ -1,12 +1,20 @@
 #ifndef GPS_TRACKER_H
 #define GPS_TRACKER_H
 
+#include <array>
+#include <deque>
+#include <functional>
 #include <vector>
 #include <memory>
-#include <thread>
 #include <atomic>
 #include "utils/gps_constants.h"
 #include "tracking/correlator.h"
+#include "tracking/multi_channel_correlator.h"
+#include "tracking/multi_tap_correlator.h"
+#include "tracking/tracking_scheduler.h"
+#include "acquisition/signal_acquisition.h"
+#include "utils/sample_history.h"
+#include "utils/seqlock.h"
 
 namespace gps {
 
@@ -18,6 +26,25 @@ enum class ChannelState {
     LOST
 };
 
+// One code period of a batch: correlator outputs and the loop state after it
+struct TrackingEpoch {
+    int prn;
+    uint64_t first_sample;      // Stream index the period's span starts at
+    std::complex<float> early;
+    std::complex<float> prompt;
+    std::complex<float> late;
+    double carrier_freq;        // Hz
+    double code_freq;           // chips/s
+    float carrier_phase;        // radians at the next code epoch
+    float cn0;                  // dB-Hz, latest estimate
+};
+
+// One navigation data bit as integrated by a channel
+struct NavigationBit {
+    bool value;
+    uint64_t end_sample;        // Stream index the bit ended at
+};
+
 
 class TrackingChannel {
 public:
@@ -25,18 +52,100 @@ public:
     ~TrackingChannel();
 
     
-    void startAcquisition(const IQBuffer& samples);
-    void updateTracking(const IQBuffer& samples);
+    // Samples are addressed by their index in the stream, see SampleHistory
+    void startAcquisition(const IQBuffer& samples, uint64_t first_sample);
     
     
     ChannelState getState() const { return state_; }
     SatelliteInfo getSatelliteInfo() const { return sat_info_; }
+    int getPRN() const { return prn_; }
     bool hasNavigationBit() const;
-    bool getNavigationBit();
+    NavigationBit getNavigationBit();
+
+    /**
+     * @brief Place the channel's next code period in a window of the stream
+     * @param window_begin Stream index of the first sample in the window
+     * @param window_end Stream index one past the last sample
+     * @return True if the whole period is inside the window
+     *
+     * Integration always starts on the channel's own code epoch, which
+     * falls between samples: the span starts at the first sample after
+     * it and the replica starts at the matching fraction of a chip.
+     * Periods that have already left the window are skipped.
+     */
+    bool prepareSpan(uint64_t window_begin, uint64_t window_end);
+
+    // Span of the window and replica of the period placed by prepareSpan()
+    const ChannelSpan& getSpan() const { return span_; }
+    const ChannelReplica& getReplica() const { return replica_; }
+
+    // Correlate the prepared period on the channel's own correlator
+    void updateTracking(const IQSample* window);
+    void updateTracking(const IQSample8* window);
+
+    /**
+     * @brief Track every code period a window holds in one loop
+     * @param window First sample of the window
+     * @param window_begin Stream index of window[0]
+     * @param window_end Stream index one past the last sample
+     * @param correlator Correlator to run the periods on
+     * @return Number of periods tracked
+     *
+     * Loops are closed after each period as in applyCorrelation(), and a
+     * record of each is appended to getEpochs().
+     */
+    size_t trackBatch(const IQSample* window, uint64_t window_begin, uint64_t window_end,
+                      MultiChannelCorrelator& correlator);
+
+    const std::vector<TrackingEpoch>& getEpochs() const { return epochs_; }
+    void clearEpochs() { epochs_.clear(); }
+
+    /**
+     * @brief Close the loops on a code period correlated elsewhere
+     * @param result Correlation of getSpan() against getReplica()
+     */
+    void applyCorrelation(const CorrelationResult& result);
+
+    /**
+     * @brief Hand over a search result from a shared acquisition engine
+     * @param result Acquisition of one block
+     * @param first_sample Stream index of the first sample of that block
+     * @return True if the channel is now tracking
+     */
+    bool handoff(const AcquisitionResult& result, uint64_t first_sample);
+
+    // Counts down the retry hold-off; true once another search is due
+    bool readyForAcquisition();
+
+    // Disabled channels are not searched for; tracking is not affected
+    void setAcquisitionEnabled(bool enable) { acquisition_enabled_ = enable; }
+
+    // Doppler window for the next search only; uncertainty 0 clears it
+    void setDopplerHint(double doppler, double uncertainty);
+    bool hasDopplerHint() const { return doppler_uncertainty_ > 0.0; }
+    double getDopplerHint() const { return doppler_hint_; }
+    double getDopplerUncertainty() const { return doppler_uncertainty_; }
+
+    // Wait after a failed search before trying the PRN again
+    static constexpr int ACQUISITION_RETRY_MS = 1000;
+    // Frequency-locked pull-in before the phase lock loop takes over
+    static constexpr int FLL_PULL_IN_MS = 100;
+    // Milliseconds of prompt transitions collected before bit sync
+    static constexpr int BIT_SYNC_MS = 1000;
+    // Prompt powers per C/N0 estimate
+    static constexpr int CN0_WINDOW_MS = 50;
+    static constexpr double CN0_LOSS_THRESHOLD = 25.0;
 
 private:
     
-    bool performAcquisition(const IQBuffer& samples);
+    bool performAcquisition(const IQBuffer& samples, uint64_t first_sample);
+
+    // Move the code epoch on by a number of samples, carrier phase with it
+    void advanceEpoch(double samples);
+    
+    void updateFLL(std::complex<float> prompt);
+    void updateLockDetector(std::complex<float> prompt);
+    void updateBitSync(float prompt_i, uint64_t period_start);
     
     
     void updatePLL(double phase_error);
@@ -56,17 +165,39 @@ private:
     
     
     double carrier_freq_;
-    double carrier_phase_;
+    double carrier_phase_;      // At the next code epoch
     double code_freq_;
-    double code_phase_;
+
+    // Stream position of the next code epoch, split so that the fraction
+    // keeps its precision however long the stream runs
+    uint64_t epoch_sample_;
+    double epoch_fraction_;     // [0, 1) samples after epoch_sample_
+
+    ChannelSpan span_;
+    ChannelReplica replica_;
+    std::vector<TrackingEpoch> epochs_;     // Records of trackBatch()
     
     
     double pll_nco_;
     double dll_nco_;
+    double carrier_freq_basis_;
+    double last_phase_error_;
+    double last_code_error_;
+    std::complex<float> last_prompt_;
     
     
-    std::vector<double> correlation_history_;
-    int bit_sync_counter_;
+    std::vector<double> correlation_history_;   // prompt power, C/N0 window
+    int bit_sync_counter_;                      // ms since pull-in
+    std::array<int, 20> bit_transitions_;
+    int bit_edge_;                              // ms offset of bit edges, -1 until synced
+    float bit_sum_;
+    std::deque<NavigationBit> nav_bits_;
+
+    int tracked_ms_;
+    int acquisition_holdoff_;
+    bool acquisition_enabled_;
+    double doppler_hint_;           // Hz
+    double doppler_uncertainty_;    // Hz either side, 0 if no hint
     
     
     double sample_rate_;
@@ -76,33 +207,169 @@ private:
 
 class GPSTracker {
 public:
-    GPSTracker(double sample_rate = DEFAULT_SAMPLE_RATE);
+    GPSTracker(double sample_rate = DEFAULT_SAMPLE_RATE,
+               const TrackingSchedulerConfig& scheduler_config = TrackingSchedulerConfig());
     ~GPSTracker();
 
     
     void initialize(const std::vector<int>& prn_list);
     
     
+    /**
+     * @brief Append a block to the stream and track every code period it completes
+     * @param samples Block of any length; main passes one millisecond
+     *
+     * Blocks go into a short history, and each channel integrates from its
+     * own code epoch to the next, wherever those fall in the blocks.
+     */
     void processSamples(const IQBuffer& samples);
     
+    // Fixed-point path, samples are not widened to float
+    void processSamples(const IQSample8* samples, size_t num_samples);
+
+    /**
+     * @brief Track a long span of samples at once, for offline runs
+     * @param samples Span of any length, typically 100 ms to 1 s
+     * @param num_samples Span length
+     * @param epochs Receives a record of every code period tracked, grouped
+     *        by channel and in time order within a channel
+     *
+     * Each worker takes its channels through the whole span one channel at
+     * a time, so there is one hand-off per span rather than per millisecond
+     * and a channel's replica tables stay in cache. Channels acquired during
+     * the span are tracked over its rest. Tap monitors are not run, and
+     * getTapCorrelation() reports no taps until processSamples() runs again.
+     */
+    void processBatch(const IQSample* samples, size_t num_samples,
+                      std::vector<TrackingEpoch>& epochs);
     
+    // Start and stop the tracking workers
     void startTracking();
     void stopTracking();
     
     
     std::vector<SatelliteInfo> getTrackedSatellites() const;
-    NavigationData getNavigationData(int prn) const;
+
+    /**
+     * @brief Latest published state of a channel
+     * @param prn Satellite PRN
+     * @param info Receives the state; untouched if there is none
+     * @return Version of the state, 0 if the PRN was never published
+     *
+     * State is published after every block. Reads take no lock and do not
+     * allocate, and are safe from any thread while processSamples() runs.
+     * Versions only grow, so a reader can compare getStateVersion() with
+     * the version it last read and skip channels that have not changed.
+     */
+    uint64_t readState(int prn, SatelliteInfo& info) const;
+    uint64_t getStateVersion(int prn) const;
+
+    /**
+     * @brief Correlate a channel at many code offsets every block
+     * @param prn Satellite to monitor, replacing any earlier monitor of it
+     * @param config Tap count and span
+     *
+     * For signal quality and multipath checks; runs on the calling thread
+     * ahead of each tracking epoch in processSamples(). processBatch() does
+     * not run monitors and leaves them with no taps until the next block.
+     */
+    void setTapMonitor(int prn, const MultiTapConfig& config = MultiTapConfig());
+    void clearTapMonitor(int prn);
+
+    // Taps of the last block the PRN was tracked in; false if none yet
+    bool getTapCorrelation(int prn, TapCorrelation& taps) const;
+
+    /**
+     * @brief Narrow the next search of a PRN to a Doppler window
+     * @param prn Satellite PRN
+     * @param doppler Expected Doppler, Hz
+     * @param uncertainty Half-width of the window, Hz
+     *
+     * For hot starts. Hinted PRNs are searched ahead of the rest, in a
+     * dwell over their windows only; a miss falls back to a full search.
+     */
+    void setDopplerHint(int prn, double doppler, double uncertainty);
+
+    // Window of a PRN's pending hint; false if it has none
+    bool getDopplerHint(int prn, double& doppler, double& uncertainty) const;
+
+    /**
+     * @brief Include or leave out a PRN from acquisition
+     * @param prn Satellite PRN
+     * @param enable False for a satellite predicted below the horizon
+     */
+    void setAcquisitionEnabled(int prn, bool enable);
+
+    using NavigationBitHandler = std::function<void(int prn, bool bit, double time)>;
+
+    /**
+     * @brief Receive navigation bits as channels produce them
+     * @param handler Called with each bit and the receiver time in seconds
+     *        it ended at, in order per PRN
+     *
+     * Runs on the thread calling processSamples() or processBatch(), after
+     * the block is tracked, so the handler needs no locking of its own.
+     */
+    void setNavigationBitHandler(NavigationBitHandler handler);
 
 private:
     
     std::vector<std::unique_ptr<TrackingChannel>> channels_;
+
+    // Tracking channels are split over a fixed set of workers, each
+    // correlating its share in one pass per block
+    TrackingSchedulerConfig scheduler_config_;
+    std::unique_ptr<TrackingScheduler> scheduler_;
+    std::vector<TrackingChannel*> active_channels_;
+
+    // Recent input; holds a block and the code periods still open before it
+    SampleHistory<IQSample> history_;
+    SampleHistory<IQSample8> history8_;
+    size_t period_samples_;
+
+    static constexpr int HISTORY_PERIODS = 2;
+
+    struct TapMonitor {
+        int prn;
+        std::unique_ptr<MultiTapCorrelator> correlator;
+        TapCorrelation taps;
+        bool valid;
+    };
+    std::vector<TapMonitor> tap_monitors_;
+
+    // Idle channels share one non-coherent dwell over consecutive blocks
+    std::unique_ptr<SignalAcquisition> acquisition_;
+    std::vector<TrackingChannel*> searching_channels_;
+    IQBuffer acquisition_buffer_;
+
+    static constexpr int ACQUISITION_DWELL_BLOCKS = 10;
     
-    
-    std::vector<std::thread> channel_threads_;
+
     std::atomic<bool> is_running_;
+
+    // Published copy of each PRN, indexed by PRN; written only by the
+    // thread calling processSamples()
+    struct alignas(CACHE_LINE_SIZE) Snapshot {
+        SeqLock<SatelliteInfo> info;
+    };
+    std::array<Snapshot, GPS_MAX_SATELLITES + 1> snapshots_;
+    std::array<SatelliteInfo, GPS_MAX_SATELLITES + 1> published_;
+
+    NavigationBitHandler nav_bit_handler_;
+
+    // Stores the state of every channel that changed since its last store,
+    // and hands on the navigation bits produced since
+    void publishSnapshots();
     
    
-    void distributesamples(const IQBuffer& samples);
+    // Collects the channels with a whole code period in the window
+    bool prepareChannels(uint64_t window_begin, uint64_t window_end);
+
+    // Tracks the rest of the history on every tracking channel
+    void trackHistory();
+
+    // Feeds the block to the acquisition dwell of the idle channels
+    void distributesamples(const IQBuffer& samples, uint64_t first_sample);
     
    
     double sample_rate_;
@@ -0,0 +1,110 @@
+#ifndef MULTI_CHANNEL_CORRELATOR_H
+#define MULTI_CHANNEL_CORRELATOR_H
+
+#include <vector>
+#include "tracking/correlator.h"
+#include "utils/carrier_nco.h"
+#include "utils/code_nco.h"
+#include "utils/gps_constants.h"
+
+namespace gps {
+
+// Local replica of one tracking channel at the first sample of a block
+struct ChannelReplica {
+    int prn;
+    double code_phase;      // chips
+    double code_rate;       // chips/s, including code Doppler
+    double carrier_phase;   // radians
+    double carrier_freq;    // Hz
+};
+
+// Samples of a block one channel integrates over
+struct ChannelSpan {
+    size_t offset;
+    size_t length;
+};
+
+/**
+ * @brief Early/prompt/late correlation for many channels in one pass
+ *
+ * The sample block is walked once in L1-sized tiles. Each tile is split
+ * into I and Q once, then every channel wipes off its carrier in registers
+ * and accumulates E/P/L against its code in the same tile while it is
+ * still in cache. Channel state and accumulators are kept as structure of
+ * arrays indexed by channel.
+ */
+class MultiChannelCorrelator {
+public:
+    explicit MultiChannelCorrelator(double sample_rate);
+    ~MultiChannelCorrelator() = default;
+
+    /**
+     * @brief Correlate a block against every channel
+     * @param samples Input samples
+     * @param length Number of samples
+     * @param channels Replica of each channel at the first sample
+     * @param results One result per channel, same order
+     */
+    void correlate(const IQSample* samples,
+                   size_t length,
+                   const std::vector<ChannelReplica>& channels,
+                   std::vector<CorrelationResult>& results);
+
+    /**
+     * @brief Correlate each channel over its own part of a block
+     * @param samples Input samples
+     * @param length Number of samples
+     * @param channels Replica of each channel at the first sample of its span
+     * @param spans Part of the block each channel integrates, same order
+     * @param results One result per channel, same order
+     *
+     * Spans of channels tracked on their own code epochs overlap almost
+     * entirely, so tiles are still split once and shared; each channel
+     * only runs over the part of a tile inside its span.
+     */
+    void correlate(const IQSample* samples,
+                   size_t length,
+                   const std::vector<ChannelReplica>& channels,
+                   const std::vector<ChannelSpan>& spans,
+                   std::vector<CorrelationResult>& results);
+
+    // One channel over one span, for channels tracked on their own
+    CorrelationResult correlate(const IQSample* samples,
+                                size_t length,
+                                const ChannelReplica& channel,
+                                const ChannelSpan& span);
+
+    // Samples per tile: I/Q, carrier and the extended code replica
+    static constexpr size_t TILE_SIZE = 512;
+
+private:
+    double sample_rate_;
+    CarrierNCO carrier_nco_;
+    CodeNCO code_nco_;
+
+    // Per channel state, structure of arrays
+    std::vector<uint64_t> code_phase_;     // 32.32 chips
+    std::vector<double> code_rate_;
+    std::vector<uint32_t> carrier_phase_;  // NCO phase word
+    std::vector<double> carrier_freq_;
+    std::vector<float> acc_early_i_;
+    std::vector<float> acc_early_q_;
+    std::vector<float> acc_prompt_i_;
+    std::vector<float> acc_prompt_q_;
+    std::vector<float> acc_late_i_;
+    std::vector<float> acc_late_q_;
+    std::vector<ChannelSpan> full_spans_;
+    std::vector<ChannelReplica> single_channel_;
+    std::vector<ChannelSpan> single_span_;
+    std::vector<CorrelationResult> single_result_;
+
+    // Tile buffers, reused by every channel
+    std::vector<float> tile_i_;
+    std::vector<float> tile_q_;
+    std::vector<float> carrier_i_;
+    std::vector<float> carrier_q_;
+};
+
+}
+
+#endif
@@ -0,0 +1,91 @@
+#ifndef MULTI_TAP_CORRELATOR_H
+#define MULTI_TAP_CORRELATOR_H
+
+#include <complex>
+#include <vector>
+#include "tracking/multi_channel_correlator.h"
+#include "utils/carrier_nco.h"
+#include "utils/code_nco.h"
+#include "utils/gps_constants.h"
+
+namespace gps {
+
+struct MultiTapConfig {
+    size_t num_taps = 33;
+    double span_chips = 1.5;    // Outermost taps at about +/- span_chips
+};
+
+// Correlation at evenly spaced code offsets around prompt
+struct TapCorrelation {
+    double spacing;         // chips between taps
+    double first_offset;    // chips of tap 0 from prompt, early is positive
+    std::vector<std::complex<float>> taps;
+};
+
+/**
+ * @brief Correlation of one channel at many code offsets
+ *
+ * The block is walked in tiles like MultiChannelCorrelator. Each tile gets
+ * the carrier wiped off once into a baseband buffer, and every tap is then
+ * a dot product of that buffer with a shifted view of the code replica, so
+ * taps cost two multiply-adds per sample each.
+ *
+ * Whole-sample shifts alone would give only a handful of taps at low
+ * sample rates, so the replica is generated at a few sub-sample phases
+ * (at most MAX_PHASES) and each tap reads the phase and shift nearest its
+ * offset. Taps are evenly spaced in units of 1/phases samples; the spacing
+ * actually used is reported with each result.
+ */
+class MultiTapCorrelator {
+public:
+    explicit MultiTapCorrelator(double sample_rate,
+                                const MultiTapConfig& config = MultiTapConfig());
+    ~MultiTapCorrelator() = default;
+
+    /**
+     * @brief Correlate a block at every tap
+     * @param samples Input samples
+     * @param length Number of samples
+     * @param replica Channel replica at the first sample
+     * @param result Per-tap correlations, tap 0 lags prompt the most
+     */
+    void correlate(const IQSample* samples,
+                   size_t length,
+                   const ChannelReplica& replica,
+                   TapCorrelation& result);
+
+    size_t numTaps() const { return tap_offsets_.size(); }
+    double tapSpacing() const;
+    double tapOffset(size_t tap) const;
+
+    static constexpr size_t MAX_TAPS = 64;
+    static constexpr size_t MAX_PHASES = 16;
+    static constexpr size_t TILE_SIZE = 512;
+
+private:
+    double sample_rate_;
+    CarrierNCO carrier_nco_;
+    CodeNCO code_nco_;
+
+    size_t phases_;                     // Replica sub-sample phases
+    size_t extension_;                  // Samples of replica before and after the tile
+    std::vector<long> tap_offsets_;     // In 1/phases_ samples, early is positive
+    std::vector<size_t> tap_phase_;     // Replica phase each tap reads
+    std::vector<size_t> tap_shift_;     // Start of the tap's view in that replica
+
+    // Tile buffers
+    std::vector<float> tile_i_;
+    std::vector<float> tile_q_;
+    std::vector<float> carrier_i_;
+    std::vector<float> carrier_q_;
+    std::vector<float> baseband_i_;
+    std::vector<float> baseband_q_;
+    std::vector<float> replicas_;       // phases_ rows of TILE_SIZE + 2 * extension_
+    std::vector<const float*> views_;
+    std::vector<float> acc_i_;
+    std::vector<float> acc_q_;
+};
+
+}
+
+#endif
@@ -0,0 +1,149 @@
+#ifndef TRACKING_SCHEDULER_H
+#define TRACKING_SCHEDULER_H
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "utils/gps_constants.h"
+#include "utils/ring_buffer.h"
+#include "tracking/multi_channel_correlator.h"
+
+namespace gps {
+
+class TrackingChannel;
+
+struct TrackingSchedulerConfig {
+    unsigned num_workers = 0;   // Including the caller, capped at the core count; 0 picks
+    bool pin_cores = true;      // Pin spawned workers to one core each
+    unsigned first_core = 1;    // Core of worker 1; worker w gets first_core + w - 1
+};
+
+/**
+ * @brief Fixed set of tracking workers stepped one epoch at a time
+ *
+ * Each worker owns a group of tracking channels and a correlator, and
+ * runEpoch() hands every worker the same window of samples: the workers
+ * correlate their own channels over the span each has prepared, close
+ * their loops, then meet at a barrier before runEpoch() returns. The calling thread takes part as worker 0, so one
+ * worker means no extra threads at all.
+ *
+ * Workers wait for the next epoch by spinning on the epoch counter for
+ * SPIN_ITERATIONS before sleeping, which keeps wake-up latency well under
+ * a millisecond at real-time block rates without burning a core when the
+ * input stalls.
+ *
+ * New channels go to the least loaded worker. Per-channel cost is measured
+ * every epoch, and channels are redistributed every REBALANCE_EPOCHS by
+ * placing the most expensive first on the least loaded worker. Channels
+ * tracked on their own are timed one by one; the correlator pass a
+ * worker's channels share is split between them by span length, which
+ * their carrier, code and accumulation work scale with, and each is then
+ * charged its own loop update.
+ */
+class TrackingScheduler {
+public:
+    explicit TrackingScheduler(double sample_rate,
+                               const TrackingSchedulerConfig& config = TrackingSchedulerConfig());
+    ~TrackingScheduler();
+
+    TrackingScheduler(const TrackingScheduler&) = delete;
+    TrackingScheduler& operator=(const TrackingScheduler&) = delete;
+
+    unsigned size() const { return num_workers_; }
+
+    /**
+     * @brief Track one code period on every channel
+     * @param samples Window of recent samples
+     * @param num_samples Window length
+     * @param channels Channels whose prepareSpan() placed a period in the window
+     *
+     * Blocks until every channel has been updated. Calls are serialized.
+     */
+    void runEpoch(const IQSample* samples, size_t num_samples,
+                  const std::vector<TrackingChannel*>& channels);
+
+    // Fixed-point path, each channel runs its own int8 correlator
+    void runEpoch(const IQSample8* samples, size_t num_samples,
+                  const std::vector<TrackingChannel*>& channels);
+
+    /**
+     * @brief Track every code period a window holds on every channel
+     * @param samples Window of samples
+     * @param num_samples Window length
+     * @param window_begin Stream index of samples[0]
+     * @param channels Channels in the TRACKING state
+     *
+     * Workers run TrackingChannel::trackBatch() on their channels one after
+     * another. Counts as a single epoch.
+     */
+    void runBatch(const IQSample* samples, size_t num_samples, uint64_t window_begin,
+                  const std::vector<TrackingChannel*>& channels);
+
+    uint64_t getEpoch() const { return epoch_.load(std::memory_order_relaxed); }
+
+    // Measured time of each worker's last epoch in microseconds, read
+    // from the thread that calls runEpoch()
+    std::vector<double> getWorkerLoad() const;
+
+    // Worker a PRN is assigned to, -1 if none, and its averaged cost in
+    // microseconds; same thread as getWorkerLoad()
+    int getWorker(int prn) const { return worker_of_[prn]; }
+    double getChannelCost(int prn) const { return channel_cost_[prn]; }
+
+    static constexpr unsigned MAX_DEFAULT_WORKERS = 4;
+    static constexpr int REBALANCE_EPOCHS = 1000;
+    static constexpr int SPIN_ITERATIONS = 20000;
+    // Weight of the newest sample in the per-channel cost average
+    static constexpr double COST_ALPHA = 0.05;
+
+private:
+    struct alignas(CACHE_LINE_SIZE) Worker {
+        std::unique_ptr<MultiChannelCorrelator> correlator;
+        std::vector<TrackingChannel*> channels;
+        std::vector<ChannelReplica> replicas;
+        std::vector<ChannelSpan> spans;
+        std::vector<CorrelationResult> results;
+        std::vector<double> channel_us;     // Last epoch, same order as channels
+        double elapsed_us = 0.0;
+    };
+
+    void workerLoop(unsigned worker);
+    void runWorker(unsigned worker);
+    void dispatch(const std::vector<TrackingChannel*>& channels);
+    void assignChannels(const std::vector<TrackingChannel*>& channels);
+    void updateCosts();
+    void rebalance();
+    void pinToCore(unsigned core);
+
+    unsigned num_workers_;
+    std::vector<Worker> workers_;
+    std::vector<std::thread> threads_;
+
+    // Worker of each PRN, -1 if unassigned, and its cost in microseconds
+    std::array<int, GPS_MAX_SATELLITES + 1> worker_of_;
+    std::array<double, GPS_MAX_SATELLITES + 1> channel_cost_;
+
+    // Window of the current epoch, one of the two is set
+    const IQSample* samples_;
+    const IQSample8* samples8_;
+    size_t num_samples_;
+    bool batch_;                // Whole window per channel, see runBatch()
+    uint64_t window_begin_;
+
+    std::atomic<uint64_t> epoch_;
+    std::atomic<unsigned> pending_;
+
+    std::mutex run_mutex_;      // One runEpoch() at a time
+    std::mutex wake_mutex_;
+    std::condition_variable wake_cv_;
+    std::condition_variable done_cv_;
+    bool stop_;
+};
+
+}
+
+#endif
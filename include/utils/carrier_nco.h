@@ -0,0 +1,90 @@
+#ifndef CARRIER_NCO_H
+#define CARRIER_NCO_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "utils/gps_constants.h"
+
+namespace gps {
+
+// How CarrierNCO turns phase into cos/sin
+enum class NCOMode {
+    TABLE,        // Quantized lookup table indexed by the top phase bits
+    ROTATOR,      // Complex rotator, re-anchored every RENORM_INTERVAL
+    POLYNOMIAL    // Polynomial sincos of every sample's phase
+};
+
+/**
+ * @brief Numerically controlled oscillator for carrier replicas
+ *
+ * Phase is a 32-bit accumulator in units of 2^-32 cycles, so it wraps for
+ * free and never loses precision over a long run. Each generate() call
+ * continues from where the previous one stopped.
+ *
+ * TABLE is the cheapest and has about 2^-(TABLE_BITS+1) cycles of phase
+ * error. ROTATOR multiplies eight lanes by a fixed step and re-anchors them
+ * from the accumulator, which resets both amplitude and phase drift.
+ * POLYNOMIAL evaluates sin/cos to float precision for every sample. Both
+ * run eight lanes at a time on AVX2 and fall back to scalar code below it.
+ */
+class CarrierNCO {
+public:
+    explicit CarrierNCO(double sample_rate, NCOMode mode = NCOMode::ROTATOR);
+    ~CarrierNCO() = default;
+
+    void setMode(NCOMode mode) { mode_ = mode; }
+    NCOMode getMode() const { return mode_; }
+
+    void setPhase(double radians) { phase_ = toPhaseWord(radians); }
+    void setFrequency(double frequency) { step_ = toPhaseStep(frequency, sample_rate_); }
+    double getPhase() const;
+
+    // Raw accumulator, for callers that keep several oscillators' state
+    void setPhaseWord(uint32_t phase) { phase_ = phase; }
+    uint32_t getPhaseWord() const { return phase_; }
+
+    /**
+     * @brief Produce the next samples of exp(j * phase)
+     * @param length Number of samples
+     * @param cos_out Real part, length floats
+     * @param sin_out Imaginary part, length floats
+     */
+    void generate(size_t length, float* cos_out, float* sin_out);
+    void generate(size_t length, IQSample* out);
+
+    static uint32_t toPhaseWord(double radians);
+    static uint32_t toPhaseStep(double frequency, double sample_rate);
+
+    /**
+     * @brief Vectorized sin and cos
+     * @param radians Input angles, reduced in float: keep |x| within a few
+     *                cycles for full precision
+     * @param sin_out n floats
+     * @param cos_out n floats
+     * @param n Number of angles
+     */
+    static void sincos(const float* radians, float* sin_out, float* cos_out, size_t n);
+
+    static constexpr int TABLE_BITS = 10;
+    static constexpr size_t RENORM_INTERVAL = 256;
+
+private:
+    void generateTable(size_t length, float* cos_out, float* sin_out) const;
+    void generateRotator(size_t length, float* cos_out, float* sin_out) const;
+    void generatePolynomial(size_t length, float* cos_out, float* sin_out) const;
+
+    double sample_rate_;
+    NCOMode mode_;
+    uint32_t phase_;
+    uint32_t step_;
+
+    // Split buffers behind the interleaved generate()
+    std::vector<float> cos_buffer_;
+    std::vector<float> sin_buffer_;
+};
+
+}
+
+#endif
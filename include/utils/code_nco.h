@@ -0,0 +1,93 @@
+#ifndef CODE_NCO_H
+#define CODE_NCO_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "utils/gps_constants.h"
+
+namespace gps {
+
+/**
+ * @brief C/A code replica generator with a 32.32 fixed-point chip phase
+ *
+ * The phase counts 2^-32 chips, so each sample costs one add, one shift
+ * and one table load; the code period is handled once per wrap rather
+ * than with a floor and modulo per sample. PRN tables are built once per
+ * process and shared.
+ *
+ * generate() fills a single prompt replica extended by the correlator
+ * spacing on both sides, and early/prompt/late are offset views into it.
+ * The spacing is therefore a whole number of samples: CORRELATOR_SPACING
+ * chips rounded at the nominal chip rate.
+ */
+class CodeNCO {
+public:
+    CodeNCO(int prn, double sample_rate);
+    ~CodeNCO() = default;
+
+    void setPRN(int prn);
+    int getPRN() const { return prn_; }
+
+    void setPhase(double chips);
+    void setRate(double chips_per_second);
+    double getPhase() const;
+
+    // Raw 32.32 phase in [0, GPS_CA_CODE_LENGTH << 32)
+    void setPhaseWord(uint64_t phase) { phase_ = phase; }
+    uint64_t getPhaseWord() const { return phase_; }
+    static uint64_t toPhaseWord(double chips);
+
+    // Phase advance per sample, in the same 32.32 units
+    uint64_t getPhaseStep() const { return step_; }
+
+    // Early/late offset from prompt in samples
+    size_t spacingSamples() const { return spacing_; }
+
+    /**
+     * @brief Write count samples of the code starting at an arbitrary phase
+     *
+     * Uses the current PRN and rate but leaves the phase untouched, for
+     * callers that build their own set of offset replicas.
+     */
+    void fill(uint64_t phase, size_t count, float* out) const;
+
+    /**
+     * @brief Build the replica for the next length samples and advance
+     * @param length Number of prompt samples
+     */
+    void generate(size_t length);
+
+    // Int8 replica with each chip written twice, to line up with I/Q pairs
+    void generate8(size_t length);
+
+    // Views into the last generate(): early leads prompt, late lags it
+    const float* early() const { return replica_.data() + 2 * spacing_; }
+    const float* prompt() const { return replica_.data() + spacing_; }
+    const float* late() const { return replica_.data(); }
+
+    const int8_t* early8() const { return replica8_.data() + 4 * spacing_; }
+    const int8_t* prompt8() const { return replica8_.data() + 2 * spacing_; }
+    const int8_t* late8() const { return replica8_.data(); }
+
+    static constexpr uint64_t PHASE_ONE = uint64_t(1) << 32;
+    static constexpr uint64_t PHASE_PERIOD = uint64_t(GPS_CA_CODE_LENGTH) << 32;
+
+private:
+    uint64_t startPhase() const;
+
+    int prn_;
+    double sample_rate_;
+    size_t spacing_;
+    uint64_t phase_;
+    uint64_t step_;
+    const float* table_;
+    const int8_t* table8_;
+
+    std::vector<float> replica_;
+    std::vector<int8_t> replica8_;
+};
+
+}
+
+#endif
@@ -0,0 +1,131 @@
+#ifndef FFT_PROCESSOR_H
+#define FFT_PROCESSOR_H
+
+#include <complex>
+#include <memory>
+#include <vector>
+#include "utils/gps_constants.h"
+
+namespace gps {
+
+enum class FFTDirection {
+    FORWARD,   // exp(-2*pi*i*k*n/N)
+    INVERSE    // exp(+2*pi*i*k*n/N), unnormalized
+};
+
+/**
+ * @brief Precomputed complex FFT of one size and direction
+ *
+ * Mixed-radix Stockham autosort transform: radix 4, 2 and 3 stages plus a
+ * generic radix for other primes up to MAX_DIRECT_RADIX, so sizes such as
+ * 2046 and 4092 run without padding. Sizes with a larger prime factor use
+ * Bluestein's algorithm on a power-of-two inner transform.
+ *
+ * Stages with a stride of four or more run AVX2 butterflies over four
+ * complex values at a time when the CPU supports them (see
+ * simd_dispatch.h), scalar butterflies otherwise. Plans are immutable
+ * after construction and may be shared between threads.
+ */
+class FFTPlan {
+public:
+    FFTPlan(size_t n, FFTDirection direction);
+    ~FFTPlan() = default;
+
+    size_t size() const { return n_; }
+    FFTDirection direction() const { return direction_; }
+
+    /**
+     * @brief Transform n samples
+     * @param in Input samples
+     * @param out Output samples, may alias in for an in-place transform
+     */
+    void execute(const IQSample* in, IQSample* out) const;
+    void execute(IQSample* data) const { execute(data, data); }
+
+    /**
+     * @brief Run count transforms back to back
+     * @param in First input transform
+     * @param out First output transform
+     * @param count Number of transforms
+     * @param distance Elements between consecutive transforms (>= n)
+     */
+    void executeBatch(const IQSample* in, IQSample* out, size_t count, size_t distance) const;
+
+    static constexpr size_t MAX_DIRECT_RADIX = 64;
+
+private:
+    struct Stage {
+        size_t radix;
+        size_t stride;           // product of the radices before this stage
+        size_t m;                // butterflies per stride group
+        size_t twiddle_offset;   // into twiddles_, (radix - 1) per butterfly
+        size_t root_offset;      // into roots_, radix entries (generic stages)
+    };
+
+    void runStages(const IQSample* in, IQSample* out, IQSample* scratch) const;
+    void runStage(const Stage& stage, const IQSample* x, IQSample* y) const;
+
+    void radix2(const Stage& stage, const IQSample* x, IQSample* y) const;
+    void radix4(const Stage& stage, const IQSample* x, IQSample* y) const;
+    void radixGeneric(const Stage& stage, const IQSample* x, IQSample* y) const;
+
+    void executeBluestein(const IQSample* in, IQSample* out) const;
+
+    size_t n_;
+    FFTDirection direction_;
+    bool vector_;                // AVX2 butterflies, fixed at construction
+    std::vector<Stage> stages_;
+    std::vector<IQSample> twiddles_;
+    std::vector<IQSample> roots_;
+
+    // Bluestein: inner power-of-two transforms and chirp tables
+    std::unique_ptr<FFTPlan> bluestein_forward_;
+    std::unique_ptr<FFTPlan> bluestein_inverse_;
+    std::vector<IQSample> chirp_;
+    std::vector<IQSample> chirp_spectrum_;
+};
+
+/**
+ * @brief Real-input FFT of even length via a half-size complex transform
+ *
+ * forward() maps n real samples to the n/2 + 1 non-negative frequency
+ * bins; inverse() maps those bins back to n real samples (unnormalized).
+ */
+class RealFFTPlan {
+public:
+    explicit RealFFTPlan(size_t n);
+    ~RealFFTPlan() = default;
+
+    size_t size() const { return n_; }
+
+    void forward(const float* in, IQSample* out) const;
+    void inverse(const IQSample* in, float* out) const;
+
+private:
+    size_t n_;
+    std::shared_ptr<const FFTPlan> half_forward_;
+    std::shared_ptr<const FFTPlan> half_inverse_;
+    std::vector<IQSample> twiddles_;   // exp(-2*pi*i*k/n), k <= n/2
+};
+
+/**
+ * @brief Process-wide FFT plan cache
+ *
+ * Plans are built on first use for a (size, direction) pair and then
+ * shared, so twiddle tables are computed once per process.
+ */
+class FFTProcessor {
+public:
+    static std::shared_ptr<const FFTPlan> getPlan(size_t n, FFTDirection direction);
+    static std::shared_ptr<const RealFFTPlan> getRealPlan(size_t n);
+
+    // Convenience wrappers around cached plans
+    static void forward(const IQSample* in, IQSample* out, size_t n);
+    static void inverse(const IQSample* in, IQSample* out, size_t n);
+
+    static void clearCache();
+};
+
+}
+
+#endif
\ No newline at end of file
@@ -14,6 +14,12 @@ constexpr int GPS_CA_CODE_LENGTH = 1023;  // C/A code length in chips
 constexpr int GPS_DATA_RATE_BPS = 50;  // Navigation data rate
 constexpr int GPS_MAX_SATELLITES = 32;  // Maximum number of GPS satellites
 
+// WGS-84 values as used by the ICD orbit equations
+constexpr double GPS_EARTH_GM = 3.986005e14;  // m^3/s^2
+constexpr double GPS_EARTH_ROTATION_RATE = 7.2921151467e-5;  // rad/s
+constexpr double SPEED_OF_LIGHT = 2.99792458e8;  // m/s
+constexpr double GPS_WEEK_SECONDS = 604800.0;
+
 // Sampling parameters
 constexpr double DEFAULT_SAMPLE_RATE = 2.048e6;  
 constexpr double DEFAULT_IF_FREQ = 0.0;  
@@ -27,11 +33,34 @@ constexpr int DOPPLER_SEARCH_STEP = 500;
 constexpr double PLL_BANDWIDTH = 18.0;  
 constexpr double DLL_BANDWIDTH = 2.0;  
 constexpr double TRACKING_INTEGRATION_TIME = 0.001;  
+constexpr double CORRELATOR_SPACING = 0.5;  // Early/late offset in chips
 
 
 using IQSample = std::complex<float>;
 using IQBuffer = std::vector<IQSample>;
 
+// Native RTL-SDR resolution: signed 8-bit I/Q in [-127, 127]
+struct IQSample8 {
+    int8_t i;
+    int8_t q;
+};
+using IQBuffer8 = std::vector<IQSample8>;
+
+// Fixed-point samples relate to float samples by this factor
+constexpr float INT8_SAMPLE_SCALE = 127.5f;
+
+// Sample representation used between the front end and tracking
+enum class SampleFormat {
+    FLOAT32,  // std::complex<float>, 8 bytes per sample
+    INT8      // IQSample8, 2 bytes per sample
+};
+
+#ifdef GPS_FIXED_POINT
+constexpr SampleFormat DEFAULT_SAMPLE_FORMAT = SampleFormat::INT8;
+#else
+constexpr SampleFormat DEFAULT_SAMPLE_FORMAT = SampleFormat::FLOAT32;
+#endif
+
 // Satellite structure
 struct SatelliteInfo {
     int prn;
@@ -63,6 +92,22 @@ struct EphemerisData {
     // Add more parameters as needed
 };
 
+// Almanac of one satellite, from subframe 4 or 5; angles in radians
+struct AlmanacData {
+    int prn;
+    int health;  // 0 if all signals are healthy
+    double toa;  // Almanac reference time, seconds of week
+    double ecc;
+    double i0;  // Inclination, 0.3 semicircles plus the broadcast offset
+    double omega_dot;  // Rate of right ascension, rad/s
+    double sqrt_a;
+    double omega0;
+    double w;
+    double m0;
+    double af0;  // Clock bias, s
+    double af1;  // Clock drift, s/s
+};
+
 } 
 
 #endif 
\ No newline at end of file
@@ -0,0 +1,66 @@
+#ifndef HOT_START_H
+#define HOT_START_H
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include "utils/gps_constants.h"
+
+namespace gps {
+
+// Receiver state kept across restarts, indexed by PRN
+struct HotStartState {
+    double saved_time = 0.0;    // Unix time of the save, seconds
+    std::array<EphemerisData, GPS_MAX_SATELLITES + 1> ephemeris{};
+    std::array<bool, GPS_MAX_SATELLITES + 1> ephemeris_valid{};
+    std::array<SatelliteInfo, GPS_MAX_SATELLITES + 1> channels{};  // Last state, is_tracked if in use
+    std::array<AlmanacData, GPS_MAX_SATELLITES + 1> almanac{};
+    std::array<bool, GPS_MAX_SATELLITES + 1> almanac_valid{};
+};
+
+// Broadcast ephemerides are fit for four hours centred on toe
+constexpr double HOT_START_EPHEMERIS_AGE = 4 * 3600.0;
+// Almanac orbits stay good to a few km for about a week
+constexpr double HOT_START_ALMANAC_AGE = 7 * 86400.0;
+// Older Doppler is no narrower than a full search
+constexpr double HOT_START_DOPPLER_AGE = 600.0;
+// Doppler hint half-width at save time, and its growth with age
+constexpr double HOT_START_DOPPLER_UNCERTAINTY = 2.0 * DOPPLER_SEARCH_STEP;
+constexpr double HOT_START_DOPPLER_DRIFT = 1.0;    // Hz/s
+
+/**
+ * @brief Write a hot start snapshot
+ * @param path Snapshot file, replaced atomically
+ * @param state State to save
+ * @return True if the snapshot is on disk
+ *
+ * The file is a fixed header (magic, format version, payload size and a
+ * CRC-32 of the payload) followed by fixed-size little-endian records.
+ * It is written to a temporary file, synced and renamed over the old one,
+ * so a crash mid-save leaves the previous snapshot in place.
+ */
+bool saveHotStart(const std::string& path, const HotStartState& state);
+
+/**
+ * @brief Map and validate a hot start snapshot
+ * @param path Snapshot file
+ * @param state Receives the saved state; untouched on failure
+ * @return True if the file has this build's format and its checksum matches
+ */
+bool loadHotStart(const std::string& path, HotStartState& state);
+
+/**
+ * @brief Whether an ephemeris is still inside its fit interval
+ * @param ephemeris Saved ephemeris
+ * @param time_of_week Current GPS seconds of week
+ * @return True within half of HOT_START_EPHEMERIS_AGE of toe, across a
+ *         week boundary if need be
+ */
+bool ephemerisCurrent(const EphemerisData& ephemeris, double time_of_week);
+
+// CRC-32 (IEEE 802.3) of a buffer
+uint32_t crc32(const void* data, size_t length);
+
+}
+
+#endif
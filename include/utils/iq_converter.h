@@ -0,0 +1,115 @@
+#ifndef IQ_CONVERTER_H
+#define IQ_CONVERTER_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include "utils/gps_constants.h"
+
+namespace gps {
+
+/**
+ * @brief Converts RTL-SDR uint8 IQ pairs to complex float samples
+ *
+ * Vectorized for the SIMD tier picked at runtime (see simd_dispatch.h),
+ * with a scalar lookup table for the tail, and writes straight into
+ * caller-provided storage, so it is cheap enough to run on the librtlsdr
+ * USB thread.
+ *
+ * Optional front-end corrections are applied in the same pass:
+ * - DC offset removal using a running estimate of the I/Q means
+ * - I/Q imbalance correction (gain and phase) estimated from the
+ *   second-order statistics of the stream
+ *
+ * Estimates are refreshed every ESTIMATE_INTERVAL samples and applied to
+ * the following samples, so a single pass over the data is enough.
+ */
+class IQConverter {
+public:
+    IQConverter();
+    ~IQConverter() = default;
+
+    /**
+     * @brief Convert interleaved uint8 IQ pairs
+     * @param raw_data Interleaved I/Q bytes (2 bytes per sample)
+     * @param num_samples Number of IQ samples to convert
+     * @param iq_data Output, must hold num_samples samples
+     */
+    void convert(const uint8_t* raw_data, size_t num_samples, IQSample* iq_data);
+
+    /**
+     * @brief Convert to signed 8-bit samples for the fixed-point path
+     * @param raw_data Interleaved I/Q bytes (2 bytes per sample)
+     * @param num_samples Number of IQ samples to convert
+     * @param iq_data Output in [-127, 127], must hold num_samples samples
+     *
+     * Only recentres the bytes; DC and imbalance corrections are not applied.
+     */
+    static void convertInt8(const uint8_t* raw_data, size_t num_samples, IQSample8* iq_data);
+
+    // Quantize float samples to the fixed-point representation
+    static void quantizeInt8(const IQSample* samples, size_t num_samples, IQSample8* iq_data);
+
+    /**
+     * @brief Enable DC offset removal
+     * @param enable Subtract the running I/Q mean
+     * @param alpha Smoothing factor for the mean estimate (0..1]
+     */
+    void setDCRemoval(bool enable, float alpha = 0.1f);
+
+    /**
+     * @brief Enable I/Q gain and phase imbalance correction
+     * @param enable Apply Q' = a*I + b*Q from the running estimate
+     * @param alpha Smoothing factor for the imbalance estimate (0..1]
+     */
+    void setImbalanceCorrection(bool enable, float alpha = 0.1f);
+
+    // Discard learned DC / imbalance estimates
+    void reset();
+
+    float getDCOffsetI() const { return dc_i_; }
+    float getDCOffsetQ() const { return dc_q_; }
+    float getGainImbalance() const { return gain_ratio_; }
+    float getPhaseImbalance() const { return phase_error_; }
+
+    static constexpr size_t ESTIMATE_INTERVAL = 64 * 1024;
+
+private:
+    // Fast path: plain offset/scale, no statistics
+    void convertPlain(const uint8_t* raw_data, size_t num_samples, IQSample* iq_data);
+
+    // Corrected path: applies current estimates and accumulates statistics
+    void convertCorrected(const uint8_t* raw_data, size_t num_samples, IQSample* iq_data);
+
+    void updateEstimates();
+
+    // (x - 127.5) / 127.5 for every possible byte
+    std::array<float, 256> lut_;
+
+    bool dc_removal_;
+    bool imbalance_correction_;
+    float dc_alpha_;
+    float imbalance_alpha_;
+
+    // Current estimates
+    float dc_i_;
+    float dc_q_;
+    float gain_ratio_;   // sigma_Q / sigma_I
+    float phase_error_;  // radians
+
+    // Q' = iq_a_ * I + iq_b_ * Q
+    float iq_a_;
+    float iq_b_;
+
+    // Statistics gathered since the last estimate update (DC-removed values)
+    double acc_i_;
+    double acc_q_;
+    double acc_ii_;
+    double acc_qq_;
+    double acc_iq_;
+    size_t acc_count_;
+};
+
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,188 @@
+#ifndef RING_BUFFER_H
+#define RING_BUFFER_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+namespace gps {
+
+constexpr size_t CACHE_LINE_SIZE = 64;
+
+/**
+ * @brief Read-only view of contiguous samples owned by someone else
+ */
+template <typename T>
+struct SampleSpan {
+    const T* data = nullptr;
+    size_t size = 0;
+};
+
+/**
+ * @brief Lock-free single-producer/single-consumer ring buffer
+ *
+ * Storage is allocated once. The first max_read elements are mirrored
+ * past the end of the ring, so any read of up to max_read elements is
+ * one contiguous span, even when it crosses the wrap point.
+ *
+ * Producer side: beginWrite() / commitWrite() (or write()).
+ * Consumer side: readSpan() / commitRead().
+ */
+template <typename T>
+class SpscRingBuffer {
+    static_assert(std::is_trivially_copyable<T>::value,
+                  "SpscRingBuffer requires trivially copyable elements");
+
+public:
+    // Up to two contiguous regions the producer may fill
+    struct WriteRegion {
+        T* first = nullptr;
+        size_t first_size = 0;
+        T* second = nullptr;
+        size_t second_size = 0;
+    };
+
+    /**
+     * @param capacity Ring size in elements (rounded up to a power of two)
+     * @param max_read Largest span readSpan() can hand out contiguously
+     */
+    SpscRingBuffer(size_t capacity, size_t max_read)
+        : capacity_(roundUpPow2(capacity))
+        , mask_(capacity_ - 1)
+        , mirror_(max_read)
+        , storage_(capacity_ + max_read) {
+        if (max_read > capacity_) {
+            throw std::invalid_argument("max_read must not exceed ring capacity");
+        }
+    }
+
+    size_t capacity() const { return capacity_; }
+    size_t maxRead() const { return mirror_; }
+
+    size_t size() const {
+        return head_.load(std::memory_order_acquire) -
+               tail_.load(std::memory_order_acquire);
+    }
+
+    // Producer: reserve n elements. Returns false if the block does not fit.
+    bool beginWrite(size_t n, WriteRegion& region) {
+        const size_t head = head_.load(std::memory_order_relaxed);
+        const size_t tail = tail_.load(std::memory_order_acquire);
+        if (n > capacity_ - (head - tail)) {
+            return false;
+        }
+
+        const size_t start = head & mask_;
+        const size_t first = std::min(n, capacity_ - start);
+        region.first = &storage_[start];
+        region.first_size = first;
+        region.second = &storage_[0];
+        region.second_size = n - first;
+        return true;
+    }
+
+    // Producer: publish n elements previously reserved with beginWrite()
+    void commitWrite(size_t n) {
+        const size_t head = head_.load(std::memory_order_relaxed);
+        updateMirror(head & mask_, n);
+        head_.store(head + n, std::memory_order_release);
+    }
+
+    // Producer: copy a whole block in, or drop it entirely if it does not fit
+    bool write(const T* data, size_t n) {
+        WriteRegion region;
+        if (!beginWrite(n, region)) {
+            dropped_blocks_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        std::memcpy(region.first, data, region.first_size * sizeof(T));
+        std::memcpy(region.second, data + region.first_size, region.second_size * sizeof(T));
+        commitWrite(n);
+        return true;
+    }
+
+    // Producer: account for a block that was discarded without calling write()
+    void recordDroppedBlock() {
+        dropped_blocks_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // Consumer: view the next n elements without copying (n <= max_read)
+    bool readSpan(size_t n, SampleSpan<T>& span) const {
+        if (n > mirror_) {
+            return false;
+        }
+        const size_t tail = tail_.load(std::memory_order_relaxed);
+        const size_t head = head_.load(std::memory_order_acquire);
+        if (head - tail < n) {
+            return false;
+        }
+
+        span.data = &storage_[tail & mask_];
+        span.size = n;
+        return true;
+    }
+
+    // Consumer: release n elements obtained through readSpan()
+    void commitRead(size_t n) {
+        tail_.store(tail_.load(std::memory_order_relaxed) + n,
+                    std::memory_order_release);
+    }
+
+    uint64_t droppedBlocks() const {
+        return dropped_blocks_.load(std::memory_order_relaxed);
+    }
+
+    // Only safe while neither side is active
+    void reset() {
+        head_.store(0, std::memory_order_relaxed);
+        tail_.store(0, std::memory_order_relaxed);
+    }
+
+private:
+    static size_t roundUpPow2(size_t n) {
+        size_t p = 1;
+        while (p < n) {
+            p <<= 1;
+        }
+        return p;
+    }
+
+    // Keep storage_[capacity_ .. capacity_ + mirror_) equal to storage_[0 .. mirror_)
+    void updateMirror(size_t start, size_t n) {
+        if (mirror_ == 0) {
+            return;
+        }
+
+        const size_t first_end = std::min(start + n, capacity_);
+        if (start < mirror_) {
+            const size_t end = std::min(first_end, mirror_);
+            std::memcpy(&storage_[capacity_ + start], &storage_[start],
+                        (end - start) * sizeof(T));
+        }
+
+        const size_t wrapped = n - (first_end - start);
+        if (wrapped > 0) {
+            const size_t end = std::min(wrapped, mirror_);
+            std::memcpy(&storage_[capacity_], &storage_[0], end * sizeof(T));
+        }
+    }
+
+    const size_t capacity_;
+    const size_t mask_;
+    const size_t mirror_;
+    std::vector<T> storage_;
+
+    // Producer and consumer indices live on separate cache lines
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t> head_{0};
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t> tail_{0};
+    alignas(CACHE_LINE_SIZE) std::atomic<uint64_t> dropped_blocks_{0};
+};
+
+}
+
+#endif
\ No newline at end of file
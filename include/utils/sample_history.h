@@ -0,0 +1,84 @@
+#ifndef SAMPLE_HISTORY_H
+#define SAMPLE_HISTORY_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+namespace gps {
+
+/**
+ * @brief The most recent samples of a stream, addressed by sample index
+ *
+ * Blocks are appended as they arrive and every sample keeps the absolute
+ * index it has in the stream. The last window() samples are always held
+ * contiguously, so any span inside [begin(), end()) is a plain pointer,
+ * whatever block boundaries it crosses.
+ *
+ * Storage is twice the window. Appends fill it from the front, and when a
+ * block no longer fits the newest window is moved down to the start, so
+ * each sample is copied once on the way in and at most once more.
+ */
+template <typename T>
+class SampleHistory {
+    static_assert(std::is_trivially_copyable<T>::value,
+                  "SampleHistory requires trivially copyable samples");
+
+public:
+    explicit SampleHistory(size_t window = 0)
+        : window_(window)
+        , storage_(2 * window)
+        , held_(0)
+        , end_(0) {}
+
+    size_t window() const { return window_; }
+
+    // Index of the oldest sample in the window and one past the newest
+    uint64_t begin() const { return end_ - size(); }
+    uint64_t end() const { return end_; }
+    size_t size() const { return std::min(held_, window_); }
+
+    // Oldest sample in the window; valid until the next append()
+    const T* data() const { return storage_.data() + (held_ - size()); }
+
+    // Sample at a stream index in [begin(), end())
+    const T* at(uint64_t index) const {
+        return storage_.data() + (held_ - static_cast<size_t>(end_ - index));
+    }
+
+    void append(const T* samples, size_t count) {
+        if (held_ + count > storage_.size()) {
+            // Only the window is still needed
+            const size_t keep = size();
+            std::memmove(storage_.data(), storage_.data() + (held_ - keep), keep * sizeof(T));
+            held_ = keep;
+            if (keep + count > storage_.size()) {
+                storage_.resize(keep + count);
+            }
+        }
+        std::memcpy(storage_.data() + held_, samples, count * sizeof(T));
+        held_ += count;
+        end_ += count;
+    }
+
+    // Grow the window to at least the given size, keeping what is held
+    void reserve(size_t window) {
+        if (window > window_) {
+            window_ = window;
+            storage_.resize(std::max(storage_.size(), 2 * window));
+        }
+    }
+
+private:
+    size_t window_;
+    std::vector<T> storage_;
+    size_t held_;       // Samples in storage_, the window is the newest of them
+    uint64_t end_;      // Stream index one past the newest sample
+};
+
+}
+
+#endif
@@ -0,0 +1,91 @@
+#ifndef SEQLOCK_H
+#define SEQLOCK_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+namespace gps {
+
+/**
+ * @brief Single-writer value that readers copy out without locks
+ *
+ * The writer makes the sequence odd, stores the value and makes it even
+ * again; a reader copies the value between two reads of the sequence and
+ * retries if they differ or a store was in progress. Neither side blocks
+ * or allocates, and the writer never waits for readers.
+ *
+ * The value is held as relaxed atomic words so that a read racing a store
+ * is well defined; it is only used when the sequence shows it was whole.
+ * The sequence also counts stores, so readers can tell whether anything
+ * changed since their last copy.
+ */
+template <typename T>
+class SeqLock {
+    static_assert(std::is_trivially_copyable<T>::value,
+                  "SeqLock requires a trivially copyable value");
+
+    static constexpr size_t WORDS = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+public:
+    SeqLock() : sequence_(0) {
+        for (auto& word : words_) {
+            word.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    SeqLock(const SeqLock&) = delete;
+    SeqLock& operator=(const SeqLock&) = delete;
+
+    // Writer only; one writer at a time
+    void store(const T& value) {
+        uint64_t buffer[WORDS] = {};
+        std::memcpy(buffer, &value, sizeof(T));
+
+        const uint64_t sequence = sequence_.load(std::memory_order_relaxed);
+        sequence_.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        for (size_t i = 0; i < WORDS; ++i) {
+            words_[i].store(buffer[i], std::memory_order_relaxed);
+        }
+        sequence_.store(sequence + 2, std::memory_order_release);
+    }
+
+    /**
+     * @brief Copy out the latest value
+     * @param value Receives the value
+     * @return Version of the copy, the number of stores before it
+     */
+    uint64_t load(T& value) const {
+        uint64_t buffer[WORDS];
+        uint64_t before;
+        uint64_t after;
+        do {
+            before = sequence_.load(std::memory_order_acquire);
+            for (size_t i = 0; i < WORDS; ++i) {
+                buffer[i] = words_[i].load(std::memory_order_relaxed);
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            after = sequence_.load(std::memory_order_relaxed);
+        } while (before != after || (before & 1) != 0);
+
+        std::memcpy(&value, buffer, sizeof(T));
+        return before / 2;
+    }
+
+    // Number of completed stores; 0 if the value was never stored
+    uint64_t version() const {
+        return sequence_.load(std::memory_order_acquire) / 2;
+    }
+
+private:
+    std::atomic<uint64_t> sequence_;
+    std::array<std::atomic<uint64_t>, WORDS> words_;
+};
+
+}
+
+#endif
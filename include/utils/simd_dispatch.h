@@ -0,0 +1,89 @@
+#ifndef SIMD_DISPATCH_H
+#define SIMD_DISPATCH_H
+
+#include <string>
+
+namespace gps {
+
+// Instruction set tiers, in increasing order
+enum class SimdLevel {
+    SCALAR,
+    SSE4,      // SSE4.1 / SSSE3
+    AVX2,      // AVX2 + FMA
+    AVX512     // AVX-512 F/BW/VL
+};
+
+// Kernels for a tier are compiled with these attributes, so the rest of
+// the binary stays at the baseline instruction set
+#define GPS_TARGET_SSE4 __attribute__((target("sse4.1")))
+#define GPS_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#define GPS_TARGET_AVX512 __attribute__((target("avx512f,avx512bw,avx512vl,avx2,fma")))
+
+// GCC 12's AVX-512 headers trip -Wmaybe-uninitialized when inlined into a
+// target function (GCC bug 105593); AVX-512 kernels sit between these
+#define GPS_AVX512_BEGIN                                            \
+    _Pragma("GCC diagnostic push")                                  \
+    _Pragma("GCC diagnostic ignored \"-Wuninitialized\"")           \
+    _Pragma("GCC diagnostic ignored \"-Wmaybe-uninitialized\"")
+#define GPS_AVX512_END _Pragma("GCC diagnostic pop")
+
+/**
+ * @brief Highest tier the CPU and OS support, from cpuid and xgetbv
+ */
+SimdLevel detectSimdLevel();
+
+/**
+ * @brief Tier the kernels run at
+ *
+ * The detected tier, lowered by the GPS_SIMD environment variable
+ * (scalar, sse4, avx2, avx512) or by setSimdLevel(). Kernels latch it on
+ * first use, so overrides must happen at startup.
+ */
+SimdLevel activeSimdLevel();
+
+/**
+ * @brief Force a tier, e.g. from the command line
+ * @param level Requested tier, clamped to what the CPU supports
+ * @return The tier that will be used
+ */
+SimdLevel setSimdLevel(SimdLevel level);
+
+const char* simdLevelName(SimdLevel level);
+bool parseSimdLevel(const std::string& name, SimdLevel& level);
+
+/**
+ * @brief One kernel in every tier
+ *
+ * A null entry falls back to the next lower tier; scalar must be set.
+ */
+template <typename Fn>
+struct KernelSet {
+    Fn scalar;
+    Fn sse4;
+    Fn avx2;
+    Fn avx512;
+
+    Fn select(SimdLevel level) const {
+        switch (level) {
+            case SimdLevel::AVX512:
+                if (avx512) return avx512;
+                // fall through
+            case SimdLevel::AVX2:
+                if (avx2) return avx2;
+                // fall through
+            case SimdLevel::SSE4:
+                if (sse4) return sse4;
+                // fall through
+            case SimdLevel::SCALAR:
+                break;
+        }
+        return scalar;
+    }
+
+    // Kernel for the active tier
+    Fn select() const { return select(activeSimdLevel()); }
+};
+
+}
+
+#endif
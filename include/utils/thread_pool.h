@@ -0,0 +1,75 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "utils/ring_buffer.h"
+
+namespace gps {
+
+/**
+ * @brief Fixed-size pool of workers with per-worker task queues
+ *
+ * parallelFor() deals task indices round-robin onto the worker queues.
+ * Each worker drains its own queue from the back and, once empty, steals
+ * from the front of the others, so uneven task costs still balance out.
+ * The calling thread takes part as worker 0; worker ids are stable and
+ * can be used to index per-worker scratch state.
+ */
+class WorkStealingPool {
+public:
+    /**
+     * @param num_threads Total workers including the caller, 0 uses
+     *                    hardware_concurrency()
+     */
+    explicit WorkStealingPool(unsigned num_threads = 0);
+    ~WorkStealingPool();
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    unsigned size() const { return num_workers_; }
+
+    /**
+     * @brief Run task(index, worker) for every index in [0, count)
+     * @param count Number of tasks
+     * @param task Called once per index, worker is in [0, size())
+     *
+     * Blocks until every task has finished. Calls are serialized.
+     */
+    void parallelFor(size_t count, const std::function<void(size_t, unsigned)>& task);
+
+private:
+    struct alignas(CACHE_LINE_SIZE) TaskQueue {
+        std::mutex mutex;
+        std::deque<size_t> tasks;
+    };
+
+    void workerLoop(unsigned worker);
+    void runTasks(unsigned worker);
+    bool popTask(unsigned worker, size_t& index);
+
+    unsigned num_workers_;
+    std::vector<std::thread> threads_;
+    std::unique_ptr<TaskQueue[]> queues_;
+
+    const std::function<void(size_t, unsigned)>* task_;
+    std::atomic<size_t> pending_;
+
+    std::mutex run_mutex_;      // One parallelFor() at a time
+    std::mutex wake_mutex_;
+    std::condition_variable wake_cv_;
+    std::condition_variable done_cv_;
+    uint64_t generation_;
+    bool stop_;
+};
+
+}
+
+#endif
@@ -0,0 +1,61 @@
+#include "acquisition/code_spectrum_bank.h"
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <utility>
+#include "utils/fft_processor.h"
+#include "utils/prn_generator.h"
+
+namespace gps {
+
+CodeSpectrumBank::CodeSpectrumBank(double sample_rate, size_t fft_size)
+    : sample_rate_(sample_rate)
+    , fft_size_(fft_size)
+    , spectra_(static_cast<size_t>(GPS_MAX_SATELLITES) * fft_size) {
+
+    PRNGenerator generator;
+    std::vector<float> sampled_code;
+
+    for (int prn = 1; prn <= GPS_MAX_SATELLITES; ++prn) {
+        IQSample* bins = spectra_.data() + (prn - 1) * fft_size_;
+
+        generator.generateCodeSampled(prn, sample_rate_, fft_size_, sampled_code);
+        for (size_t i = 0; i < fft_size_; ++i) {
+            bins[i] = IQSample(sampled_code[i], 0.0f);
+        }
+    }
+
+    auto plan = FFTProcessor::getPlan(fft_size_, FFTDirection::FORWARD);
+    plan->executeBatch(spectra_.data(), spectra_.data(), GPS_MAX_SATELLITES, fft_size_);
+
+    for (auto& bin : spectra_) {
+        bin = std::conj(bin);
+    }
+}
+
+std::shared_ptr<const CodeSpectrumBank> CodeSpectrumBank::get(double sample_rate, size_t fft_size) {
+    static std::mutex mutex;
+    static std::map<std::pair<double, size_t>, std::shared_ptr<const CodeSpectrumBank>> banks;
+
+    // Held across the build so concurrent first users wait for one bank
+    std::lock_guard<std::mutex> lock(mutex);
+
+    auto key = std::make_pair(sample_rate, fft_size);
+    auto it = banks.find(key);
+    if (it != banks.end()) {
+        return it->second;
+    }
+
+    auto bank = std::make_shared<const CodeSpectrumBank>(sample_rate, fft_size);
+    banks.emplace(key, bank);
+    return bank;
+}
+
+const IQSample* CodeSpectrumBank::spectrum(int prn) const {
+    if (prn < 1 || prn > GPS_MAX_SATELLITES) {
+        throw std::invalid_argument("PRN must be between 1 and 32");
+    }
+    return spectra_.data() + (prn - 1) * fft_size_;
+}
+
+}
@@ -1,4 +1,5 @@
 #include "acquisition/sdr_receiver.h"
+#include <rtl-sdr.h>
 #include <iostream>
 #include <cstring>
 #include <chrono>
@@ -10,7 +11,9 @@ SDRReceiver::SDRReceiver()
     , sample_rate_(DEFAULT_SAMPLE_RATE)
     , center_freq_(GPS_L1_FREQ_HZ)
     , gain_(40)
-    , is_running_(false) {
+    , is_running_(false)
+    , sample_format_(SampleFormat::FLOAT32) {
+    setSampleFormat(DEFAULT_SAMPLE_FORMAT);
 }
 
 SDRReceiver::~SDRReceiver() {
@@ -118,36 +121,74 @@ void SDRReceiver::stopCapture() {
         capture_thread_.join();
     }
 
-   
-    {
-        std::lock_guard<std::mutex> lock(buffer_mutex_);
-        std::queue<IQSample> empty;
-        std::swap(sample_buffer_, empty);
+    // Producer is gone, safe to drop whatever is left
+    if (sample_ring_) {
+        sample_ring_->reset();
+    }
+    if (sample_ring8_) {
+        sample_ring8_->reset();
     }
+    buffer_cv_.notify_all();
 }
 
-bool SDRReceiver::getSamples(IQBuffer& buffer, size_t num_samples) {
-    std::unique_lock<std::mutex> lock(buffer_mutex_);
+bool SDRReceiver::setSampleFormat(SampleFormat format) {
+    if (is_running_) {
+        return false;
+    }
+
+    sample_format_ = format;
+    if (format == SampleFormat::INT8) {
+        sample_ring_.reset();
+        if (!sample_ring8_) {
+            sample_ring8_ = std::make_unique<SpscRingBuffer<IQSample8>>(MAX_BUFFER_SIZE, MAX_READ_SIZE);
+        }
+    } else {
+        sample_ring8_.reset();
+        if (!sample_ring_) {
+            sample_ring_ = std::make_unique<SpscRingBuffer<IQSample>>(MAX_BUFFER_SIZE, MAX_READ_SIZE);
+        }
+    }
+    return true;
+}
+
+uint64_t SDRReceiver::getDroppedBlocks() const {
+    return sample_ring_ ? sample_ring_->droppedBlocks() : sample_ring8_->droppedBlocks();
+}
+
+template <typename T>
+bool SDRReceiver::waitForSamples(SpscRingBuffer<T>& ring, SampleSpan<T>& span, size_t num_samples) {
+    if (ring.readSpan(num_samples, span)) {
+        return true;
+    }
+    if (num_samples > MAX_READ_SIZE) {
+        return false;
+    }
+
+    std::unique_lock<std::mutex> lock(wait_mutex_);
     
     
     auto timeout = std::chrono::milliseconds(100);
-    if (buffer_cv_.wait_for(lock, timeout, [this, num_samples]() {
-        return sample_buffer_.size() >= num_samples || !is_running_;
-    })) {
-        
-        if (sample_buffer_.size() >= num_samples) {
-            buffer.clear();
-            buffer.reserve(num_samples);
-            
-            for (size_t i = 0; i < num_samples; ++i) {
-                buffer.push_back(sample_buffer_.front());
-                sample_buffer_.pop();
-            }
-            return true;
-        }
+    buffer_cv_.wait_for(lock, timeout, [this, &ring, num_samples]() {
+        return ring.size() >= num_samples || !is_running_;
+    });
+
+    return ring.readSpan(num_samples, span);
+}
+
+bool SDRReceiver::readSamples(SampleSpan<IQSample>& span, size_t num_samples) {
+    return sample_ring_ && waitForSamples(*sample_ring_, span, num_samples);
+}
+
+bool SDRReceiver::readSamples(SampleSpan<IQSample8>& span, size_t num_samples) {
+    return sample_ring8_ && waitForSamples(*sample_ring8_, span, num_samples);
+}
+
+void SDRReceiver::consumeSamples(size_t num_samples) {
+    if (sample_ring_) {
+        sample_ring_->commitRead(num_samples);
+    } else {
+        sample_ring8_->commitRead(num_samples);
     }
-    
-    return false;
 }
 
 bool SDRReceiver::setGain(int gain_db) {
@@ -186,34 +227,40 @@ void SDRReceiver::rtlsdrCallback(unsigned char* buf, uint32_t len, void* ctx) {
 }
 
 void SDRReceiver::processRawData(unsigned char* buf, uint32_t len) {
-    IQBuffer iq_samples;
-    convertToIQ(buf, len, iq_samples);
+    const size_t num_samples = len / 2;
+
+    // Whole block or nothing: a partial block would splice discontinuous data
+    if (sample_ring8_) {
+        SpscRingBuffer<IQSample8>::WriteRegion region;
+        if (!sample_ring8_->beginWrite(num_samples, region)) {
+            sample_ring8_->recordDroppedBlock();
+            return;
+        }
 
-    std::lock_guard<std::mutex> lock(buffer_mutex_);
-    
-    for (const auto& sample : iq_samples) {
-        
-        if (sample_buffer_.size() >= MAX_BUFFER_SIZE) {
-            sample_buffer_.pop();  
+        IQConverter::convertInt8(buf, region.first_size, region.first);
+        IQConverter::convertInt8(buf + region.first_size * 2, region.second_size, region.second);
+        sample_ring8_->commitWrite(num_samples);
+    } else {
+        SpscRingBuffer<IQSample>::WriteRegion region;
+        if (!sample_ring_->beginWrite(num_samples, region)) {
+            sample_ring_->recordDroppedBlock();
+            return;
         }
-        sample_buffer_.push(sample);
+
+        convertToIQ(buf, region.first_size * 2, region.first);
+        convertToIQ(buf + region.first_size * 2, region.second_size * 2, region.second);
+        sample_ring_->commitWrite(num_samples);
+    }
+
+    {
+        // Empty critical section orders the publish against a waiting consumer
+        std::lock_guard<std::mutex> lock(wait_mutex_);
     }
-    
     buffer_cv_.notify_all();
 }
 
-void SDRReceiver::convertToIQ(const unsigned char* raw_data, size_t len, IQBuffer& iq_data) {
-    
-    size_t num_samples = len / 2;
-    iq_data.clear();
-    iq_data.reserve(num_samples);
-
-    for (size_t i = 0; i < len; i += 2) {
-        
-        float i_sample = (raw_data[i] - 127.5f) / 127.5f;
-        float q_sample = (raw_data[i + 1] - 127.5f) / 127.5f;
-        iq_data.emplace_back(i_sample, q_sample);
-    }
+void SDRReceiver::convertToIQ(const unsigned char* raw_data, size_t len, IQSample* iq_data) {
+    iq_converter_.convert(raw_data, len / 2, iq_data);
 }
 
-} 
\ No newline at end of file
+}
\ No newline at end of file
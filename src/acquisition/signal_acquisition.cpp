@@ -0,0 +1,915 @@
+#include "acquisition/signal_acquisition.h"
+#include "utils/carrier_nco.h"
+#include "utils/prn_generator.h"
+#include "utils/simd_dispatch.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <atomic>
+#include <immintrin.h>
+
+namespace gps {
+
+namespace {
+
+// out[k] = a[k] * b[k] over interleaved complex floats; out may alias a
+using MultiplyKernel = void (*)(const IQSample*, const IQSample*, IQSample*, size_t);
+// out[k] = |in[k]|^2
+using PowerKernel = void (*)(const IQSample*, float*, size_t);
+
+// Written out rather than with std::complex operator*, whose inf/NaN
+// recovery path keeps the compiler from vectorizing the loop
+inline void multiplyTail(const IQSample* a, const IQSample* b, IQSample* out,
+                         size_t begin, size_t end) {
+    for (size_t k = begin; k < end; ++k) {
+        const float re = a[k].real() * b[k].real() - a[k].imag() * b[k].imag();
+        const float im = a[k].real() * b[k].imag() + a[k].imag() * b[k].real();
+        out[k] = IQSample(re, im);
+    }
+}
+
+inline void powerTail(const IQSample* in, float* out, size_t begin, size_t end) {
+    for (size_t k = begin; k < end; ++k) {
+        out[k] = in[k].real() * in[k].real() + in[k].imag() * in[k].imag();
+    }
+}
+
+void multiplyScalar(const IQSample* a, const IQSample* b, IQSample* out, size_t n) {
+    multiplyTail(a, b, out, 0, n);
+}
+
+void powerScalar(const IQSample* in, float* out, size_t n) {
+    powerTail(in, out, 0, n);
+}
+
+GPS_TARGET_SSE4
+void multiplySSE4(const IQSample* a, const IQSample* b, IQSample* out, size_t n) {
+    const float* pa = reinterpret_cast<const float*>(a);
+    const float* pb = reinterpret_cast<const float*>(b);
+    float* po = reinterpret_cast<float*>(out);
+
+    size_t k = 0;
+    for (; k + 2 <= n; k += 2) {
+        __m128 va = _mm_loadu_ps(pa + 2 * k);
+        __m128 vb = _mm_loadu_ps(pb + 2 * k);
+        // (ar*br - ai*bi, ar*bi + ai*br)
+        __m128 re = _mm_mul_ps(_mm_moveldup_ps(vb), va);
+        __m128 im = _mm_mul_ps(_mm_movehdup_ps(vb), _mm_shuffle_ps(va, va, _MM_SHUFFLE(2, 3, 0, 1)));
+        _mm_storeu_ps(po + 2 * k, _mm_addsub_ps(re, im));
+    }
+    multiplyTail(a, b, out, k, n);
+}
+
+GPS_TARGET_SSE4
+void powerSSE4(const IQSample* in, float* out, size_t n) {
+    const float* pi = reinterpret_cast<const float*>(in);
+
+    size_t k = 0;
+    for (; k + 4 <= n; k += 4) {
+        __m128 lo = _mm_loadu_ps(pi + 2 * k);
+        __m128 hi = _mm_loadu_ps(pi + 2 * k + 4);
+        _mm_storeu_ps(out + k, _mm_hadd_ps(_mm_mul_ps(lo, lo), _mm_mul_ps(hi, hi)));
+    }
+    powerTail(in, out, k, n);
+}
+
+GPS_TARGET_AVX2
+void multiplyAVX2(const IQSample* a, const IQSample* b, IQSample* out, size_t n) {
+    const float* pa = reinterpret_cast<const float*>(a);
+    const float* pb = reinterpret_cast<const float*>(b);
+    float* po = reinterpret_cast<float*>(out);
+
+    size_t k = 0;
+    for (; k + 4 <= n; k += 4) {
+        __m256 va = _mm256_loadu_ps(pa + 2 * k);
+        __m256 vb = _mm256_loadu_ps(pb + 2 * k);
+        __m256 im = _mm256_mul_ps(_mm256_movehdup_ps(vb), _mm256_permute_ps(va, 0xB1));
+        _mm256_storeu_ps(po + 2 * k, _mm256_fmaddsub_ps(_mm256_moveldup_ps(vb), va, im));
+    }
+    multiplyTail(a, b, out, k, n);
+}
+
+GPS_TARGET_AVX2
+void powerAVX2(const IQSample* in, float* out, size_t n) {
+    const float* pi = reinterpret_cast<const float*>(in);
+
+    size_t k = 0;
+    for (; k + 8 <= n; k += 8) {
+        __m256 lo = _mm256_loadu_ps(pi + 2 * k);
+        __m256 hi = _mm256_loadu_ps(pi + 2 * k + 8);
+        // hadd works within 128-bit lanes; put the 64-bit pairs back in order
+        __m256 sum = _mm256_hadd_ps(_mm256_mul_ps(lo, lo), _mm256_mul_ps(hi, hi));
+        sum = _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(sum), _MM_SHUFFLE(3, 1, 2, 0)));
+        _mm256_storeu_ps(out + k, sum);
+    }
+    powerTail(in, out, k, n);
+}
+
+GPS_AVX512_BEGIN
+GPS_TARGET_AVX512
+void multiplyAVX512(const IQSample* a, const IQSample* b, IQSample* out, size_t n) {
+    const float* pa = reinterpret_cast<const float*>(a);
+    const float* pb = reinterpret_cast<const float*>(b);
+    float* po = reinterpret_cast<float*>(out);
+
+    size_t k = 0;
+    for (; k + 8 <= n; k += 8) {
+        __m512 va = _mm512_loadu_ps(pa + 2 * k);
+        __m512 vb = _mm512_loadu_ps(pb + 2 * k);
+        __m512 im = _mm512_mul_ps(_mm512_movehdup_ps(vb), _mm512_permute_ps(va, 0xB1));
+        _mm512_storeu_ps(po + 2 * k, _mm512_fmaddsub_ps(_mm512_moveldup_ps(vb), va, im));
+    }
+    multiplyTail(a, b, out, k, n);
+}
+GPS_AVX512_END
+
+// Power is load-bound; AVX-512 would only widen the shuffle
+const KernelSet<MultiplyKernel> kMultiplyKernels = {
+    multiplyScalar, multiplySSE4, multiplyAVX2, multiplyAVX512};
+const KernelSet<PowerKernel> kPowerKernels = {
+    powerScalar, powerSSE4, powerAVX2, nullptr};
+
+}
+
+SignalAcquisition::SignalAcquisition(double sample_rate)
+    : sample_rate_(sample_rate)
+    , threshold_(ACQUISITION_THRESHOLD)
+    , use_parallel_(false)
+    , num_threads_(0)
+    , doppler_mode_(DopplerSearchMode::SPECTRUM_SHIFT)
+    , coherent_ms_(1)
+    , noncoherent_blocks_(1)
+    , half_bit_combining_(true)
+    , early_report_ratio_(2.0 * ACQUISITION_THRESHOLD)
+    , dwell_doppler_min_(-DOPPLER_SEARCH_RANGE)
+    , dwell_doppler_max_(DOPPLER_SEARCH_RANGE)
+    , dwell_doppler_step_(DOPPLER_SEARCH_STEP)
+    , dwell_blocks_(0)
+    , has_pending_block_(false)
+    , coarse_decimation_(0)
+    , fine_ms_(10) {
+
+    code_samples_ = static_cast<size_t>(
+        std::lround(sample_rate_ * GPS_CA_CODE_LENGTH / GPS_CA_CODE_FREQ_HZ));
+
+    worker_scratch_.resize(1);
+    configureBlockSize();
+}
+
+SignalAcquisition::~SignalAcquisition() = default;
+
+void SignalAcquisition::setNumThreads(unsigned num_threads) {
+    if (num_threads != num_threads_) {
+        num_threads_ = num_threads;
+        pool_.reset();
+    }
+}
+
+void SignalAcquisition::setCoherentIntegration(int milliseconds) {
+    milliseconds = std::max(1, std::min(10, milliseconds));
+    if (milliseconds != coherent_ms_) {
+        coherent_ms_ = milliseconds;
+        configureBlockSize();
+    }
+}
+
+void SignalAcquisition::configureBlockSize() {
+    // coherent_ms_ code periods per coherent integration
+    const size_t fft_size = code_samples_ * coherent_ms_;
+
+    fft_forward_plan_ = FFTProcessor::getPlan(fft_size, FFTDirection::FORWARD);
+    fft_inverse_plan_ = FFTProcessor::getPlan(fft_size, FFTDirection::INVERSE);
+    code_bank_ = CodeSpectrumBank::get(sample_rate_, fft_size);
+
+    residual_carriers_.clear();
+    input_spectra_.clear();
+    pending_spectra_.clear();
+    doppler_bins_.clear();
+
+    for (auto& scratch : worker_scratch_) {
+        scratch.fft_buffer.resize(fft_size);
+    }
+
+    // A dwell cannot span a change of block length
+    dwell_prns_.clear();
+    dwell_grid_.clear();
+    dwell_results_.clear();
+    has_pending_block_ = false;
+}
+
+void SignalAcquisition::runTasks(size_t count, const std::function<void(size_t, unsigned)>& task) {
+    if (use_parallel_ && count > 1) {
+        if (!pool_) {
+            pool_.reset(new WorkStealingPool(num_threads_));
+        }
+        if (worker_scratch_.size() < pool_->size()) {
+            worker_scratch_.resize(pool_->size());
+        }
+        for (auto& scratch : worker_scratch_) {
+            scratch.fft_buffer.resize(fft_forward_plan_->size());
+        }
+        pool_->parallelFor(count, task);
+    } else {
+        for (size_t i = 0; i < count; ++i) {
+            task(i, 0);
+        }
+    }
+}
+
+AcquisitionResult SignalAcquisition::searchSatellite(const IQBuffer& samples,
+                                                     int prn,
+                                                     double doppler_min,
+                                                     double doppler_max,
+                                                     double doppler_step) {
+    prepareDopplerSearch(samples, doppler_min, doppler_max, doppler_step);
+    return searchPrepared({prn}).front();
+}
+
+std::vector<AcquisitionResult> SignalAcquisition::searchAllSatellites(
+    const IQBuffer& samples,
+    const std::vector<int>& prn_list) {
+
+    // The input spectra do not depend on the PRN, so every search shares them
+    prepareDopplerSearch(samples, -DOPPLER_SEARCH_RANGE, DOPPLER_SEARCH_RANGE,
+                         DOPPLER_SEARCH_STEP / coherent_ms_);
+    return searchPrepared(prn_list);
+}
+
+std::vector<AcquisitionResult> SignalAcquisition::searchBatch(
+    const IQBuffer& samples,
+    const std::vector<int>& prn_list,
+    double doppler_min,
+    double doppler_max,
+    double doppler_step) {
+
+    prepareDopplerSearch(samples, doppler_min, doppler_max, doppler_step);
+
+    std::vector<int> prns;
+    for (int prn : prn_list) {
+        if (prn >= 1 && prn <= GPS_MAX_SATELLITES) {
+            prns.push_back(prn);
+        }
+    }
+
+    const size_t num_prns = prns.size();
+    const size_t num_bins = doppler_bins_.size();
+    const size_t fft_size = fft_forward_plan_->size();
+    const long n = static_cast<long>(fft_size);
+    const size_t num_groups = (num_prns + BATCH_PRNS - 1) / BATCH_PRNS;
+
+    // Input bins per cache block: the rotated chunk, BATCH_PRNS code chunks
+    // and BATCH_PRNS output chunks stay resident together
+    constexpr size_t CACHE_BLOCK = 256;
+
+    std::vector<CellPeak> cells(num_prns * num_bins, CellPeak{false, 0.0, 0, 0.0, 0.0});
+    const MultiplyKernel multiply = kMultiplyKernels.select();
+
+    auto task = [&](size_t index, unsigned worker) {
+        const size_t b = index / num_groups;
+        const size_t first = (index % num_groups) * BATCH_PRNS;
+        const size_t count = std::min(BATCH_PRNS, num_prns - first);
+
+        const DopplerBin& bin = doppler_bins_[b];
+        WorkerScratch& scratch = worker_scratch_[worker];
+        scratch.shifted.resize(fft_size);
+        scratch.batch.resize(BATCH_PRNS * fft_size);
+
+        // Rotate once, shared by every PRN in the group
+        const IQSample* spectrum = input_spectra_[bin.spectrum].data();
+        const size_t shift = static_cast<size_t>(((bin.bin_shift % n) + n) % n);
+        std::copy(spectrum + shift, spectrum + fft_size, scratch.shifted.begin());
+        std::copy(spectrum, spectrum + shift, scratch.shifted.begin() + (fft_size - shift));
+
+        const IQSample* codes[BATCH_PRNS];
+        for (size_t j = 0; j < count; ++j) {
+            codes[j] = code_bank_->spectrum(prns[first + j]);
+        }
+
+        for (size_t k0 = 0; k0 < fft_size; k0 += CACHE_BLOCK) {
+            const size_t k1 = std::min(fft_size, k0 + CACHE_BLOCK);
+            const IQSample* in = scratch.shifted.data();
+            for (size_t j = 0; j < count; ++j) {
+                IQSample* out = scratch.batch.data() + j * fft_size;
+                const IQSample* code = codes[j];
+                multiply(in + k0, code + k0, out + k0, k1 - k0);
+            }
+        }
+
+        fft_inverse_plan_->executeBatch(scratch.batch.data(), scratch.batch.data(), count, fft_size);
+
+        for (size_t j = 0; j < count; ++j) {
+            detectPeak(scratch.batch.data() + j * fft_size, scratch,
+                       cells[(first + j) * num_bins + b]);
+        }
+    };
+
+    runTasks(num_bins * num_groups, task);
+
+    std::vector<AcquisitionResult> results;
+    results.reserve(num_prns);
+
+    for (size_t p = 0; p < num_prns; ++p) {
+        AcquisitionResult result{};
+        result.prn = prns[p];
+
+        const CellPeak* best = nullptr;
+        size_t best_bin = 0;
+        for (size_t b = 0; b < num_bins; ++b) {
+            const CellPeak& cell = cells[p * num_bins + b];
+            if (cell.searched && (!best || cell.peak_value > best->peak_value)) {
+                best = &cell;
+                best_bin = b;
+            }
+        }
+
+        if (best) {
+            const size_t code_offset = (code_samples_ - best->peak_index) % code_samples_;
+            result.code_phase = code_offset * GPS_CA_CODE_FREQ_HZ / sample_rate_;
+            result.doppler_shift = doppler_bins_[best_bin].doppler;
+            result.peak_ratio = best->peak_ratio;
+            result.snr_estimate = best->mean_power > 0.0 ?
+                10.0 * std::log10(best->peak_value / best->mean_power) : 0.0;
+            result.found = best->peak_ratio > threshold_;
+        }
+
+        results.push_back(result);
+    }
+
+    return results;
+}
+
+std::vector<AcquisitionResult> SignalAcquisition::searchTwoStage(
+    const IQBuffer& samples,
+    const std::vector<int>& prn_list) {
+
+    // Largest decimation that keeps at least one sample per chip and a
+    // whole number of samples per code period
+    size_t decimation = static_cast<size_t>(sample_rate_ / GPS_CA_CODE_FREQ_HZ);
+    while (decimation > 1 && std::fmod(sample_rate_ / decimation, 1000.0) != 0.0) {
+        --decimation;
+    }
+    decimation = std::max<size_t>(1, decimation);
+
+    if (!coarse_ || coarse_decimation_ != decimation) {
+        coarse_.reset(new SignalAcquisition(sample_rate_ / decimation));
+        coarse_decimation_ = decimation;
+    }
+    coarse_->setThreshold(threshold_);
+    coarse_->setParallelProcessing(use_parallel_);
+    coarse_->setNumThreads(num_threads_);
+
+    // Boxcar average and downsample, which also acts as the anti-alias filter
+    const size_t coarse_samples = samples.size() / decimation;
+    decimated_.resize(coarse_samples);
+    for (size_t i = 0; i < coarse_samples; ++i) {
+        IQSample acc(0.0f, 0.0f);
+        for (size_t j = 0; j < decimation; ++j) {
+            acc += samples[i * decimation + j];
+        }
+        decimated_[i] = acc;
+    }
+
+    std::vector<AcquisitionResult> results = coarse_->searchBatch(decimated_, prn_list);
+    for (auto& result : results) {
+        if (result.found) {
+            refineCandidate(samples, decimation, result);
+        }
+    }
+
+    return results;
+}
+
+void SignalAcquisition::refineCandidate(const IQBuffer& samples,
+                                        size_t decimation,
+                                        AcquisitionResult& result) {
+    const size_t periods = std::min<size_t>(fine_ms_, samples.size() / code_samples_);
+    if (periods == 0) {
+        return;
+    }
+
+    // Zero-padded to twice the coherent length for a finer frequency grid
+    const size_t length = periods * code_samples_;
+    const size_t fft_size = 2 * length;
+    auto plan = FFTProcessor::getPlan(fft_size, FFTDirection::FORWARD);
+    fine_buffer_.resize(fft_size);
+
+    PRNGenerator generator;
+    const std::vector<float> code = generator.generateCodeFloat(result.prn);
+
+    const double chips_per_sample = GPS_CA_CODE_FREQ_HZ / sample_rate_;
+    const double bin_width = sample_rate_ / fft_size;
+
+    // Residual Doppler window: half a coarse step plus a margin
+    const long max_bin = static_cast<long>(std::ceil(0.6 * DOPPLER_SEARCH_STEP / bin_width));
+    const long window = static_cast<long>(decimation);
+
+    // Coarse carrier wipe-off, shared by every code offset
+    IQBuffer wiped(length);
+    generateCarrier(length, result.doppler_shift, wiped);
+    for (size_t n = 0; n < length; ++n) {
+        wiped[n] *= samples[n];
+    }
+
+    auto wipeCode = [&](double code_phase) {
+        for (size_t n = 0; n < length; ++n) {
+            double chip = code_phase + n * chips_per_sample;
+            long index = static_cast<long>(std::floor(chip)) % GPS_CA_CODE_LENGTH;
+            if (index < 0) {
+                index += GPS_CA_CODE_LENGTH;
+            }
+            fine_buffer_[n] = wiped[n] * code[index];
+        }
+    };
+
+    // Code phase: strongest per-period energy, which tolerates the
+    // residual Doppler left by the coarse grid
+    double best_energy = -1.0;
+    double best_code_phase = result.code_phase;
+    for (long offset = -window; offset <= window; ++offset) {
+        const double code_phase = result.code_phase + offset * chips_per_sample;
+        wipeCode(code_phase);
+
+        double energy = 0.0;
+        for (size_t period = 0; period < periods; ++period) {
+            IQSample sum(0.0f, 0.0f);
+            for (size_t n = period * code_samples_; n < (period + 1) * code_samples_; ++n) {
+                sum += fine_buffer_[n];
+            }
+            energy += std::norm(sum);
+        }
+
+        if (energy > best_energy) {
+            best_energy = energy;
+            best_code_phase = code_phase;
+        }
+    }
+
+    // Doppler: the code-wiped signal is a tone at the residual frequency
+    wipeCode(best_code_phase);
+    std::fill(fine_buffer_.begin() + length, fine_buffer_.end(), IQSample(0.0f, 0.0f));
+    plan->execute(fine_buffer_.data());
+
+    auto power = [&](long k) {
+        return static_cast<double>(std::norm(fine_buffer_[(k + fft_size) % fft_size]));
+    };
+
+    long best_bin = 0;
+    for (long k = -max_bin; k <= max_bin; ++k) {
+        if (power(k) > power(best_bin)) {
+            best_bin = k;
+        }
+    }
+
+    // Parabolic interpolation between neighbouring bins
+    const double pm = power(best_bin - 1);
+    const double p0 = power(best_bin);
+    const double pp = power(best_bin + 1);
+    const double denom = pm - 2.0 * p0 + pp;
+    const double delta = denom < 0.0 ? 0.5 * (pm - pp) / denom : 0.0;
+    const double best_doppler = result.doppler_shift + (best_bin + delta) * bin_width;
+
+    best_code_phase = std::fmod(best_code_phase, static_cast<double>(GPS_CA_CODE_LENGTH));
+    if (best_code_phase < 0.0) {
+        best_code_phase += GPS_CA_CODE_LENGTH;
+    }
+
+    result.code_phase = best_code_phase;
+    result.doppler_shift = best_doppler;
+}
+
+void SignalAcquisition::detectPeak(const IQSample* correlation,
+                                   WorkerScratch& scratch,
+                                   CellPeak& cell) const {
+    // Power straight off the inverse FFT output, one code period; the row
+    // is reused for every cell
+    static const PowerKernel power = kPowerKernels.select();
+    scratch.correlation.resize(code_samples_);
+    power(correlation, scratch.correlation.data(), code_samples_);
+    findPeak(scratch.correlation.data(), code_samples_, cell);
+}
+
+void SignalAcquisition::prepareDopplerSearch(const IQBuffer& samples,
+                                             double doppler_min,
+                                             double doppler_max,
+                                             double doppler_step) {
+    doppler_bins_.clear();
+
+    const size_t fft_size = fft_forward_plan_->size();
+    if (samples.size() < fft_size || doppler_step <= 0.0 || doppler_max < doppler_min) {
+        return;
+    }
+
+    const double bin_width = sample_rate_ / fft_size;
+    const size_t num_bins = static_cast<size_t>(
+        std::floor((doppler_max - doppler_min) / doppler_step + 1e-9)) + 1;
+
+    // Input spectra keyed by residual frequency, built once per residual
+    std::map<long long, size_t> spectrum_index;
+    size_t num_spectra = 0;
+
+    for (size_t b = 0; b < num_bins; ++b) {
+        DopplerBin bin;
+        bin.doppler = doppler_min + b * doppler_step;
+        bin.bin_shift = 0;
+
+        double residual = bin.doppler;
+        if (doppler_mode_ == DopplerSearchMode::SPECTRUM_SHIFT) {
+            bin.bin_shift = static_cast<int>(std::lround(bin.doppler / bin_width));
+            residual = bin.doppler - bin.bin_shift * bin_width;
+        }
+
+        const long long key = std::llround(residual * 1000.0);
+        auto it = spectrum_index.find(key);
+        if (it == spectrum_index.end()) {
+            if (input_spectra_.size() <= num_spectra) {
+                input_spectra_.emplace_back(fft_size);
+            }
+
+            IQBuffer& spectrum = input_spectra_[num_spectra];
+            if (key == 0) {
+                std::copy(samples.begin(), samples.begin() + fft_size, spectrum.begin());
+            } else {
+                const IQBuffer& carrier = residualCarrier(residual);
+                for (size_t i = 0; i < fft_size; ++i) {
+                    spectrum[i] = samples[i] * carrier[i];
+                }
+            }
+            fft_forward_plan_->execute(spectrum.data());
+
+            it = spectrum_index.emplace(key, num_spectra++).first;
+        }
+
+        bin.spectrum = it->second;
+        doppler_bins_.push_back(bin);
+    }
+}
+
+const IQBuffer& SignalAcquisition::residualCarrier(double frequency) {
+    const long long key = std::llround(frequency * 1000.0);
+    auto it = residual_carriers_.find(key);
+    if (it == residual_carriers_.end()) {
+        it = residual_carriers_.emplace(key, IQBuffer()).first;
+        generateCarrier(fft_forward_plan_->size(), frequency, it->second);
+    }
+    return it->second;
+}
+
+std::vector<AcquisitionResult> SignalAcquisition::searchPrepared(const std::vector<int>& prn_list) {
+    const size_t num_prns = prn_list.size();
+    const size_t num_bins = doppler_bins_.size();
+
+    std::vector<CellPeak> cells(num_prns * num_bins, CellPeak{false, 0.0, 0, 0.0, 0.0});
+
+    // A PRN's result comes from its bins up to one past the first peak bin:
+    // the lowest bin above threshold whose next bin is no stronger. Bins
+    // beyond that are skipped once the peak is seen. Which ones get skipped
+    // depends on thread timing, but they never count, so the result does not.
+    std::unique_ptr<std::atomic<char>[]> done(new std::atomic<char>[num_prns * num_bins]);
+    std::unique_ptr<std::atomic<size_t>[]> last_needed(new std::atomic<size_t>[num_prns]);
+    for (size_t i = 0; i < num_prns * num_bins; ++i) {
+        done[i].store(0, std::memory_order_relaxed);
+    }
+    for (size_t p = 0; p < num_prns; ++p) {
+        last_needed[p].store(num_bins, std::memory_order_relaxed);
+    }
+
+    auto isPeakBin = [&](size_t p, size_t b) {
+        const CellPeak& cell = cells[p * num_bins + b];
+        return cell.searched && cell.peak_ratio > threshold_
+            && (b + 1 == num_bins || (cells[p * num_bins + b + 1].searched
+                                      && cells[p * num_bins + b + 1].peak_value <= cell.peak_value));
+    };
+
+    // Called once bins b and b + 1 are both searched
+    auto checkPeak = [&](size_t p, size_t b) {
+        if (!isPeakBin(p, b)) {
+            return;
+        }
+        size_t last = last_needed[p].load(std::memory_order_relaxed);
+        while (b + 1 < last && !last_needed[p].compare_exchange_weak(
+                                   last, b + 1, std::memory_order_relaxed)) {
+        }
+    };
+
+    // Tasks run Doppler-major so every PRN advances together
+    auto task = [&](size_t index, unsigned worker) {
+        const size_t b = index / num_prns;
+        const size_t p = index % num_prns;
+        const int prn = prn_list[p];
+
+        if (prn < 1 || prn > GPS_MAX_SATELLITES) {
+            return;
+        }
+        if (b > last_needed[p].load(std::memory_order_relaxed)) {
+            return;
+        }
+
+        searchCell(prn, doppler_bins_[b], worker_scratch_[worker], cells[p * num_bins + b]);
+        done[p * num_bins + b].store(1);
+
+        if (b + 1 == num_bins || done[p * num_bins + b + 1].load()) {
+            checkPeak(p, b);
+        }
+        if (b > 0 && done[p * num_bins + b - 1].load()) {
+            checkPeak(p, b - 1);
+        }
+    };
+
+    runTasks(num_prns * num_bins, task);
+
+    std::vector<AcquisitionResult> results;
+    results.reserve(num_prns);
+
+    for (size_t p = 0; p < num_prns; ++p) {
+        AcquisitionResult result{};
+        result.prn = prn_list[p];
+
+        // Every bin up to one past the first peak bin was searched
+        size_t last_bin = num_bins;
+        for (size_t b = 0; b < num_bins; ++b) {
+            if (isPeakBin(p, b)) {
+                last_bin = std::min(num_bins, b + 2);
+                break;
+            }
+        }
+
+        const CellPeak* best = nullptr;
+        size_t best_bin = 0;
+        for (size_t b = 0; b < last_bin; ++b) {
+            const CellPeak& cell = cells[p * num_bins + b];
+            if (cell.searched && (!best || cell.peak_value > best->peak_value)) {
+                best = &cell;
+                best_bin = b;
+            }
+        }
+
+        if (best) {
+            // A lag of k samples means the code chip at the first sample is at -k
+            const size_t code_offset = (code_samples_ - best->peak_index) % code_samples_;
+            result.code_phase = code_offset * GPS_CA_CODE_FREQ_HZ / sample_rate_;
+            result.doppler_shift = doppler_bins_[best_bin].doppler;
+            result.peak_ratio = best->peak_ratio;
+            result.snr_estimate = best->mean_power > 0.0 ?
+                10.0 * std::log10(best->peak_value / best->mean_power) : 0.0;
+            result.found = best->peak_ratio > threshold_;
+        }
+
+        results.push_back(result);
+    }
+
+    return results;
+}
+
+void SignalAcquisition::searchCell(int prn, const DopplerBin& bin,
+                                   WorkerScratch& scratch, CellPeak& cell) {
+    performFFTCorrelation(input_spectra_[bin.spectrum], bin.bin_shift,
+                          code_bank_->spectrum(prn), scratch);
+    findPeak(scratch.correlation.data(), scratch.correlation.size(), cell);
+}
+
+void SignalAcquisition::performFFTCorrelation(const IQBuffer& input_spectrum,
+                                              int bin_shift,
+                                              const IQSample* code_spectrum,
+                                              WorkerScratch& scratch) {
+    const size_t fft_size = fft_forward_plan_->size();
+    IQSample* buffer = scratch.fft_buffer.data();
+
+    // Mixing by exp(-2*pi*i*s*n/N) moves bin k + s of the input to bin k
+    const long n = static_cast<long>(fft_size);
+    const size_t shift = static_cast<size_t>(((bin_shift % n) + n) % n);
+    const size_t head = fft_size - shift;
+
+    static const MultiplyKernel multiply = kMultiplyKernels.select();
+    static const PowerKernel power = kPowerKernels.select();
+
+    const IQSample* spectrum = input_spectrum.data();
+    multiply(spectrum + shift, code_spectrum, buffer, head);
+    multiply(spectrum, code_spectrum + head, buffer + head, fft_size - head);
+    fft_inverse_plan_->execute(buffer);
+
+    // The replica repeats every code period, so one period of lags is enough
+    scratch.correlation.resize(code_samples_);
+    power(buffer, scratch.correlation.data(), code_samples_);
+}
+
+void SignalAcquisition::beginDwell(const std::vector<int>& prn_list,
+                                   double doppler_min,
+                                   double doppler_max,
+                                   double doppler_step) {
+    beginDwell(prn_list, std::vector<DopplerWindow>(prn_list.size(), DopplerWindow{doppler_min, doppler_max}),
+               doppler_step);
+}
+
+void SignalAcquisition::beginDwell(const std::vector<int>& prn_list,
+                                   const std::vector<DopplerWindow>& windows,
+                                   double doppler_step) {
+    dwell_prns_.clear();
+    std::vector<DopplerWindow> prn_windows;
+    double doppler_min = 0.0;
+    double doppler_max = 0.0;
+    for (size_t i = 0; i < prn_list.size() && i < windows.size(); ++i) {
+        if (prn_list[i] >= 1 && prn_list[i] <= GPS_MAX_SATELLITES) {
+            const DopplerWindow& window = windows[i];
+            doppler_min = dwell_prns_.empty() ? window.min : std::min(doppler_min, window.min);
+            doppler_max = dwell_prns_.empty() ? window.max : std::max(doppler_max, window.max);
+            dwell_prns_.push_back(prn_list[i]);
+            prn_windows.push_back(window);
+        }
+    }
+
+    dwell_doppler_min_ = doppler_min;
+    dwell_doppler_max_ = doppler_max;
+    dwell_doppler_step_ = doppler_step > 0.0 ? doppler_step : DOPPLER_SEARCH_STEP / coherent_ms_;
+    dwell_blocks_ = 0;
+    has_pending_block_ = false;
+
+    const double step = dwell_doppler_step_;
+    const size_t num_bins = static_cast<size_t>(
+        std::floor((doppler_max - doppler_min) / step + 1e-9)) + 1;
+
+    // Bins whose centre lies in the window, at least the nearest one
+    dwell_first_bin_.clear();
+    dwell_last_bin_.clear();
+    for (const DopplerWindow& window : prn_windows) {
+        const double first = std::ceil((window.min - doppler_min) / step - 1e-9);
+        const double last = std::floor((window.max - doppler_min) / step + 1e-9);
+        const double nearest = std::round(((window.min + window.max) / 2 - doppler_min) / step);
+        const size_t lo = static_cast<size_t>(std::max(0.0, first <= last ? first : nearest));
+        const size_t hi = std::min(num_bins - 1, static_cast<size_t>(std::max(0.0, first <= last ? last : nearest)));
+        dwell_first_bin_.push_back(lo);
+        dwell_last_bin_.push_back(hi);
+    }
+
+    dwell_grid_.assign(dwell_prns_.size() * num_bins * code_samples_, 0.0f);
+    dwell_decided_.assign(dwell_prns_.size(), 0);
+
+    dwell_results_.clear();
+    for (int prn : dwell_prns_) {
+        AcquisitionResult result{};
+        result.prn = prn;
+        dwell_results_.push_back(result);
+    }
+}
+
+bool SignalAcquisition::isDwellComplete() const {
+    if (dwell_blocks_ >= noncoherent_blocks_) {
+        return true;
+    }
+    return std::all_of(dwell_decided_.begin(), dwell_decided_.end(),
+                       [](char decided) { return decided != 0; });
+}
+
+bool SignalAcquisition::accumulateBlock(const IQBuffer& samples) {
+    const size_t block_size = fft_forward_plan_->size();
+    if (samples.size() < block_size || dwell_prns_.empty() || isDwellComplete()) {
+        return isDwellComplete();
+    }
+
+    const double step = dwell_doppler_step_;
+
+    // The first block of a half-bit pair is held until its partner
+    // arrives, unless it is the last block of the dwell
+    const bool pairing = half_bit_combining_ && coherent_ms_ == HALF_BIT_MS;
+    if (pairing && !has_pending_block_ && dwell_blocks_ + 1 < noncoherent_blocks_) {
+        pending_block_.assign(samples.begin(), samples.begin() + block_size);
+        has_pending_block_ = true;
+        return false;
+    }
+
+    if (has_pending_block_) {
+        prepareDopplerSearch(pending_block_, dwell_doppler_min_, dwell_doppler_max_, step);
+        pending_spectra_.swap(input_spectra_);
+    }
+    prepareDopplerSearch(samples, dwell_doppler_min_, dwell_doppler_max_, step);
+
+    accumulateGrid();
+
+    dwell_blocks_ += has_pending_block_ ? 2 : 1;
+    has_pending_block_ = false;
+
+    updateDwellResults();
+    return isDwellComplete();
+}
+
+void SignalAcquisition::accumulateGrid() {
+    const size_t num_prns = dwell_prns_.size();
+    const size_t num_bins = doppler_bins_.size();
+    const bool paired = has_pending_block_;
+
+    // Doppler-major, like searchPrepared(), skipping decided PRNs
+    auto task = [&](size_t index, unsigned worker) {
+        const size_t b = index / num_prns;
+        const size_t p = index % num_prns;
+        if (dwell_decided_[p] || b < dwell_first_bin_[p] || b > dwell_last_bin_[p]) {
+            return;
+        }
+
+        const DopplerBin& bin = doppler_bins_[b];
+        const IQSample* code_spectrum = code_bank_->spectrum(dwell_prns_[p]);
+        WorkerScratch& scratch = worker_scratch_[worker];
+        float* row = dwell_grid_.data() + (p * num_bins + b) * code_samples_;
+
+        if (paired) {
+            performFFTCorrelation(pending_spectra_[bin.spectrum], bin.bin_shift, code_spectrum, scratch);
+            scratch.paired.swap(scratch.correlation);
+        }
+
+        performFFTCorrelation(input_spectra_[bin.spectrum], bin.bin_shift, code_spectrum, scratch);
+
+        if (paired) {
+            for (size_t i = 0; i < code_samples_; ++i) {
+                row[i] += std::max(scratch.paired[i], scratch.correlation[i]);
+            }
+        } else {
+            for (size_t i = 0; i < code_samples_; ++i) {
+                row[i] += scratch.correlation[i];
+            }
+        }
+    };
+
+    runTasks(num_prns * num_bins, task);
+}
+
+void SignalAcquisition::updateDwellResults() {
+    const size_t num_bins = doppler_bins_.size();
+
+    for (size_t p = 0; p < dwell_prns_.size(); ++p) {
+        if (dwell_decided_[p]) {
+            continue;
+        }
+
+        // Strongest cell over this PRN's window of the grid
+        const float* grid = dwell_grid_.data() + p * num_bins * code_samples_;
+        const float* peak = std::max_element(grid + dwell_first_bin_[p] * code_samples_,
+                                             grid + (dwell_last_bin_[p] + 1) * code_samples_);
+        const size_t best_bin = static_cast<size_t>(peak - grid) / code_samples_;
+
+        CellPeak cell;
+        findPeak(grid + best_bin * code_samples_, code_samples_, cell);
+
+        AcquisitionResult& result = dwell_results_[p];
+        const size_t code_offset = (code_samples_ - cell.peak_index) % code_samples_;
+        result.code_phase = code_offset * GPS_CA_CODE_FREQ_HZ / sample_rate_;
+        result.doppler_shift = doppler_bins_[best_bin].doppler;
+        result.peak_ratio = cell.peak_ratio;
+        result.snr_estimate = cell.mean_power > 0.0 ?
+            10.0 * std::log10(cell.peak_value / cell.mean_power) : 0.0;
+        result.found = cell.peak_ratio > threshold_;
+
+        if (cell.peak_ratio > early_report_ratio_) {
+            dwell_decided_[p] = 1;
+        }
+    }
+}
+
+void SignalAcquisition::findPeak(const float* power, size_t length, CellPeak& cell) const {
+    cell = CellPeak{true, 0.0, 0, 0.0, 0.0};
+    if (length == 0) {
+        return;
+    }
+
+    const float* peak = std::max_element(power, power + length);
+    const size_t peak_index = static_cast<size_t>(peak - power);
+
+    double sum = 0.0;
+    for (size_t i = 0; i < length; ++i) {
+        sum += power[i];
+    }
+
+    // Second peak: largest value more than one chip from the main peak,
+    // searched as the circular range between the two exclusion edges
+    const size_t exclude = static_cast<size_t>(std::ceil(sample_rate_ / GPS_CA_CODE_FREQ_HZ));
+    float second = 0.0f;
+    if (2 * exclude + 1 < length) {
+        const size_t lo = (peak_index + length - exclude) % length;
+        const size_t hi = (peak_index + exclude + 1) % length;
+        if (hi <= lo) {
+            second = *std::max_element(power + hi, power + lo);
+        } else {
+            if (lo > 0) {
+                second = *std::max_element(power, power + lo);
+            }
+            if (hi < length) {
+                second = std::max(second, *std::max_element(power + hi, power + length));
+            }
+        }
+    }
+
+    cell.peak_value = *peak;
+    cell.peak_index = peak_index;
+    cell.peak_ratio = second > 0.0f ? *peak / second : 0.0;
+    cell.mean_power = sum / length;
+}
+
+void SignalAcquisition::generateCarrier(size_t length, double frequency,
+                                        std::vector<std::complex<float>>& carrier) {
+    carrier.resize(length);
+
+    // Local oscillator that removes the given Doppler; these tables are
+    // cached or multiplied straight into the FFT input, so use full precision
+    CarrierNCO nco(sample_rate_, NCOMode::POLYNOMIAL);
+    nco.setFrequency(-frequency);
+    nco.generate(length, carrier.data());
+}
+
+}
@@ -0,0 +1,333 @@
+#include "acquisition/signal_generator.h"
+#include "utils/iq_converter.h"
+#include "utils/prn_generator.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <thread>
+
+namespace gps {
+
+namespace {
+
+// Phase is re-anchored from the closed-form model every SUB_BLOCK samples
+constexpr size_t SUB_BLOCK = 1024;
+
+inline uint64_t splitmix64(uint64_t x) {
+    x += 0x9E3779B97F4A7C15ULL;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+// Unit-variance Gaussian values, indexed by 16 random bits
+const std::vector<float>& gaussianTable() {
+    static const std::vector<float> table = [] {
+        std::vector<float> values(1 << 16);
+        std::mt19937 rng(12345);
+        std::normal_distribution<float> dist(0.0f, 1.0f);
+        for (auto& v : values) {
+            v = dist(rng);
+        }
+        return values;
+    }();
+    return table;
+}
+
+}
+
+SignalGenerator::SignalGenerator(const SignalGeneratorConfig& config)
+    : config_(config)
+    , num_threads_(config.num_threads)
+    , total_samples_(static_cast<uint64_t>(config.duration * config.sample_rate))
+    , window_start_(0)
+    , window_size_(0)
+    , position_(0)
+    , sample_format_(DEFAULT_SAMPLE_FORMAT)
+    , replay_mode_(ReplayMode::MAX_SPEED)
+    , is_running_(false)
+    , pace_origin_(0) {
+    if (num_threads_ == 0) {
+        num_threads_ = std::max(1u, std::thread::hardware_concurrency());
+    }
+    if (num_threads_ > 1) {
+        pool_.reset(new WorkStealingPool(num_threads_));
+    }
+
+    // C/N0 is relative to the complex noise density 2 * sigma^2 / fs
+    const double noise_density = 2.0 * config_.noise_sigma * config_.noise_sigma / config_.sample_rate;
+
+    PRNGenerator prn_generator;
+    for (const auto& sat : config_.satellites) {
+        SatelliteState state;
+        state.params = sat;
+        state.code = prn_generator.generateCodeFloat(sat.prn);
+        state.amplitude = static_cast<float>(std::sqrt(std::pow(10.0, sat.cn0 / 10.0) * noise_density));
+        satellites_.push_back(std::move(state));
+    }
+
+    // Build the table before any worker thread needs it
+    gaussianTable();
+}
+
+int SignalGenerator::navigationBit(int prn, uint64_t bit_index) const {
+    uint64_t h = splitmix64(config_.seed ^ (static_cast<uint64_t>(prn) << 48) ^ bit_index);
+    return (h & 1) ? 1 : -1;
+}
+
+void SignalGenerator::addSatellite(const SatelliteState& sat, uint64_t start_sample,
+                                   size_t num_samples, IQSample* out) const {
+    const SyntheticSatellite& p = sat.params;
+    const double fs = config_.sample_rate;
+    const double code_doppler_scale = GPS_CA_CODE_FREQ_HZ / GPS_L1_FREQ_HZ;
+    const double chip_count = static_cast<double>(GPS_CA_CODE_LENGTH);
+
+    for (size_t offset = 0; offset < num_samples; offset += SUB_BLOCK) {
+        const size_t len = std::min(SUB_BLOCK, num_samples - offset);
+        const double t = static_cast<double>(start_sample + offset) / fs;
+        const double t_mid = t + 0.5 * len / fs;
+
+        // Doppler cycles accumulated since t = 0
+        const double cycles = p.doppler * t + 0.5 * p.doppler_rate * t * t;
+        const double freq = p.doppler + p.doppler_rate * t_mid;
+
+        const double phase = p.carrier_phase + 2.0 * M_PI * (cycles - std::floor(cycles));
+        IQSample rot(static_cast<float>(std::cos(phase)), static_cast<float>(std::sin(phase)));
+        const double step_angle = 2.0 * M_PI * freq / fs;
+        const IQSample step(static_cast<float>(std::cos(step_angle)),
+                            static_cast<float>(std::sin(step_angle)));
+
+        // Code phase includes code Doppler
+        const double chips = p.code_phase + GPS_CA_CODE_FREQ_HZ * t + code_doppler_scale * cycles;
+        int64_t period = static_cast<int64_t>(std::floor(chips / chip_count));
+        double chip = chips - period * chip_count;
+        const double chip_step = (GPS_CA_CODE_FREQ_HZ + code_doppler_scale * freq) / fs;
+
+        auto bitAmplitude = [&](int64_t code_period) {
+            int sign = p.nav_data ? navigationBit(p.prn, static_cast<uint64_t>(code_period) / 20) : 1;
+            return sat.amplitude * sign;
+        };
+        float amplitude = bitAmplitude(period);
+
+        IQSample* dst = out + offset;
+        for (size_t i = 0; i < len; ++i) {
+            dst[i] += (amplitude * sat.code[static_cast<int>(chip)]) * rot;
+            rot *= step;
+            chip += chip_step;
+            if (chip >= chip_count) {
+                chip -= chip_count;
+                ++period;
+                if (period % 20 == 0) {
+                    amplitude = bitAmplitude(period);
+                }
+            }
+        }
+    }
+}
+
+void SignalGenerator::addNoise(uint64_t start_sample, size_t num_samples, IQSample* out) const {
+    const std::vector<float>& table = gaussianTable();
+    const float sigma = static_cast<float>(config_.noise_sigma);
+
+    size_t done = 0;
+    while (done < num_samples) {
+        const uint64_t index = start_sample + done;
+        const uint64_t chunk = index / NOISE_CHUNK;
+        const size_t skip = static_cast<size_t>(index % NOISE_CHUNK);
+        const size_t len = std::min(NOISE_CHUNK - skip, num_samples - done);
+
+        // xorshift64*, one 32-bit draw per sample gives I and Q indices
+        uint64_t state = splitmix64(config_.seed ^ (chunk * 0xD1B54A32D192ED03ULL)) | 1;
+        auto next = [&state]() {
+            state ^= state >> 12;
+            state ^= state << 25;
+            state ^= state >> 27;
+            return static_cast<uint32_t>((state * 0x2545F4914F6CDD1DULL) >> 32);
+        };
+        for (size_t i = 0; i < skip; ++i) {
+            next();
+        }
+
+        IQSample* dst = out + done;
+        for (size_t i = 0; i < len; ++i) {
+            uint32_t r = next();
+            dst[i] += IQSample(sigma * table[r & 0xFFFF], sigma * table[r >> 16]);
+        }
+        done += len;
+    }
+}
+
+void SignalGenerator::generate(uint64_t start_sample, size_t num_samples, IQSample* out) const {
+    auto work = [this](uint64_t start, size_t count, IQSample* dst) {
+        std::fill(dst, dst + count, IQSample(0.0f, 0.0f));
+        for (const auto& sat : satellites_) {
+            addSatellite(sat, start, count, dst);
+        }
+        addNoise(start, count, dst);
+    };
+
+    const size_t num_chunks = (num_samples + NOISE_CHUNK - 1) / NOISE_CHUNK;
+    if (!pool_ || num_chunks <= 1) {
+        work(start_sample, num_samples, out);
+        return;
+    }
+
+    // One task per noise chunk, so each is generated whole by one worker
+    pool_->parallelFor(num_chunks, [&](size_t chunk, unsigned) {
+        const size_t begin = chunk * NOISE_CHUNK;
+        const size_t count = std::min(NOISE_CHUNK, num_samples - begin);
+        work(start_sample + begin, count, out + begin);
+    });
+}
+
+bool SignalGenerator::writeRecording(const std::string& path, SampleFileFormat format,
+                                     double duration) const {
+    const uint64_t num_samples = static_cast<uint64_t>(duration * config_.sample_rate);
+
+    std::ofstream file(path, std::ios::binary);
+    if (!file) {
+        std::cerr << "Failed to create recording: " << path << std::endl;
+        return false;
+    }
+
+    if (format == SampleFileFormat::COMPLEX64) {
+        if (num_samples > UINT32_MAX) {
+            std::cerr << "Recording too long for the capture header" << std::endl;
+            return false;
+        }
+        // Same layout as scripts/capture_raw_data.py
+        uint32_t count = static_cast<uint32_t>(num_samples);
+        file.write(reinterpret_cast<const char*>(&count), sizeof(count));
+        file.write(reinterpret_cast<const char*>(&config_.sample_rate), sizeof(double));
+        file.write(reinterpret_cast<const char*>(&config_.center_freq), sizeof(double));
+    }
+
+    IQBuffer block(GENERATE_BLOCK);
+    std::vector<uint8_t> bytes;
+    for (uint64_t start = 0; start < num_samples; start += GENERATE_BLOCK) {
+        const size_t count = static_cast<size_t>(std::min<uint64_t>(GENERATE_BLOCK, num_samples - start));
+        generate(start, count, block.data());
+
+        if (format == SampleFileFormat::COMPLEX64) {
+            file.write(reinterpret_cast<const char*>(block.data()), count * sizeof(IQSample));
+        } else {
+            bytes.resize(count * 2);
+            const float* values = reinterpret_cast<const float*>(block.data());
+            for (size_t i = 0; i < count * 2; ++i) {
+                float v = std::nearbyint(values[i] * 127.5f + 127.5f);
+                bytes[i] = static_cast<uint8_t>(std::max(0.0f, std::min(255.0f, v)));
+            }
+            file.write(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+        }
+    }
+
+    if (!file) {
+        std::cerr << "Failed to write recording: " << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool SignalGenerator::startCapture() {
+    if (is_running_) {
+        return false;
+    }
+
+    is_running_ = true;
+    pace_origin_ = position_;
+    start_time_ = std::chrono::steady_clock::now();
+    return true;
+}
+
+void SignalGenerator::stopCapture() {
+    is_running_ = false;
+}
+
+bool SignalGenerator::setSampleFormat(SampleFormat format) {
+    if (is_running_) {
+        return false;
+    }
+    sample_format_ = format;
+    return true;
+}
+
+bool SignalGenerator::isFinished() const {
+    return total_samples_ > 0 && position_ >= total_samples_;
+}
+
+bool SignalGenerator::fillWindow(size_t num_samples) {
+    if (!is_running_ || num_samples == 0) {
+        return false;
+    }
+    if (total_samples_ > 0 && position_ + num_samples > total_samples_) {
+        position_ = total_samples_;
+        return false;
+    }
+
+    if (replay_mode_ == ReplayMode::REALTIME) {
+        const double elapsed = (position_ + num_samples - pace_origin_) / config_.sample_rate;
+        std::this_thread::sleep_until(start_time_ +
+            std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                std::chrono::duration<double>(elapsed)));
+    }
+
+    const uint64_t window_end = window_start_ + window_size_;
+    if (position_ >= window_start_ && position_ + num_samples <= window_end) {
+        return true;
+    }
+
+    // Slide unread samples to the front and generate the rest
+    size_t keep = 0;
+    if (position_ >= window_start_ && position_ < window_end) {
+        keep = static_cast<size_t>(window_end - position_);
+        std::memmove(window_.data(), window_.data() + (position_ - window_start_),
+                     keep * sizeof(IQSample));
+    }
+
+    size_t size = std::max(GENERATE_BLOCK, num_samples);
+    if (total_samples_ > 0) {
+        size = static_cast<size_t>(std::min<uint64_t>(size, total_samples_ - position_));
+    }
+    if (window_.size() < size) {
+        window_.resize(size);
+    }
+
+    generate(position_ + keep, size - keep, window_.data() + keep);
+    window_start_ = position_;
+    window_size_ = size;
+    return true;
+}
+
+bool SignalGenerator::readSamples(SampleSpan<IQSample>& span, size_t num_samples) {
+    if (sample_format_ != SampleFormat::FLOAT32 || !fillWindow(num_samples)) {
+        return false;
+    }
+
+    span.data = window_.data() + (position_ - window_start_);
+    span.size = num_samples;
+    return true;
+}
+
+bool SignalGenerator::readSamples(SampleSpan<IQSample8>& span, size_t num_samples) {
+    if (sample_format_ != SampleFormat::INT8 || !fillWindow(num_samples)) {
+        return false;
+    }
+
+    if (staging8_.size() < num_samples) {
+        staging8_.resize(num_samples);
+    }
+    IQConverter::quantizeInt8(window_.data() + (position_ - window_start_), num_samples,
+                              staging8_.data());
+    span.data = staging8_.data();
+    span.size = num_samples;
+    return true;
+}
+
+void SignalGenerator::consumeSamples(size_t num_samples) {
+    position_ += num_samples;
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,177 @@
+#include "acquisition/visibility_predictor.h"
+#include <algorithm>
+#include <cmath>
+
+namespace gps {
+
+namespace {
+
+using Vec3 = std::array<double, 3>;
+
+constexpr double WGS84_A = 6378137.0;
+constexpr double WGS84_F = 1.0 / 298.257223563;
+constexpr double EARTH_RADIUS = 6371e3;
+constexpr double DEG = M_PI / 180.0;
+
+// Seconds from the Unix to the GPS epoch, and GPS ahead of UTC since 2017
+constexpr double GPS_UNIX_OFFSET = 315964800.0;
+constexpr double GPS_LEAP_SECONDS = 18.0;
+
+double dot(const Vec3& a, const Vec3& b) {
+    return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+}
+
+Vec3 sub(const Vec3& a, const Vec3& b) {
+    return {a[0] - b[0], a[1] - b[1], a[2] - b[2]};
+}
+
+// Elevation and azimuth of a line of sight, radians
+void lookAngles(const Vec3& los, double latitude, double longitude,
+                double& elevation, double& azimuth) {
+    const Vec3 east = {-std::sin(longitude), std::cos(longitude), 0.0};
+    const Vec3 north = {-std::sin(latitude) * std::cos(longitude),
+                        -std::sin(latitude) * std::sin(longitude), std::cos(latitude)};
+    const Vec3 up = {std::cos(latitude) * std::cos(longitude),
+                     std::cos(latitude) * std::sin(longitude), std::sin(latitude)};
+    const double range = std::sqrt(dot(los, los));
+    elevation = std::asin(dot(los, up) / range);
+    azimuth = std::atan2(dot(los, east), dot(los, north));
+    if (azimuth < 0.0) {
+        azimuth += 2.0 * M_PI;
+    }
+}
+
+}
+
+VisibilityPredictor::VisibilityPredictor(const VisibilityConfig& config)
+    : config_(config) {
+}
+
+std::array<double, 3> VisibilityPredictor::satellitePosition(const AlmanacData& almanac,
+                                                             double time_of_week) {
+    const double a = almanac.sqrt_a * almanac.sqrt_a;
+    const double n = std::sqrt(GPS_EARTH_GM / (a * a * a));
+
+    // Time from the reference epoch, across a week boundary if need be
+    double tk = time_of_week - almanac.toa;
+    if (tk > GPS_WEEK_SECONDS / 2) {
+        tk -= GPS_WEEK_SECONDS;
+    } else if (tk < -GPS_WEEK_SECONDS / 2) {
+        tk += GPS_WEEK_SECONDS;
+    }
+
+    // Kepler's equation converges in a few steps at GPS eccentricities
+    const double mk = almanac.m0 + n * tk;
+    double ek = mk;
+    for (int i = 0; i < 8; ++i) {
+        ek = mk + almanac.ecc * std::sin(ek);
+    }
+
+    const double vk = std::atan2(std::sqrt(1.0 - almanac.ecc * almanac.ecc) * std::sin(ek),
+                                 std::cos(ek) - almanac.ecc);
+    const double phi = vk + almanac.w;
+    const double rk = a * (1.0 - almanac.ecc * std::cos(ek));
+    const double xp = rk * std::cos(phi);
+    const double yp = rk * std::sin(phi);
+
+    const double omega = almanac.omega0 + (almanac.omega_dot - GPS_EARTH_ROTATION_RATE) * tk
+                       - GPS_EARTH_ROTATION_RATE * almanac.toa;
+    return {xp * std::cos(omega) - yp * std::cos(almanac.i0) * std::sin(omega),
+            xp * std::sin(omega) + yp * std::cos(almanac.i0) * std::cos(omega),
+            yp * std::sin(almanac.i0)};
+}
+
+std::array<double, 3> VisibilityPredictor::receiverPosition(const ReceiverPosition& position) {
+    const double lat = position.latitude * DEG;
+    const double lon = position.longitude * DEG;
+    const double e2 = WGS84_F * (2.0 - WGS84_F);
+    const double n = WGS84_A / std::sqrt(1.0 - e2 * std::sin(lat) * std::sin(lat));
+    return {(n + position.height) * std::cos(lat) * std::cos(lon),
+            (n + position.height) * std::cos(lat) * std::sin(lon),
+            (n * (1.0 - e2) + position.height) * std::sin(lat)};
+}
+
+std::vector<VisibilityPrediction> VisibilityPredictor::predict(
+    const std::vector<AlmanacData>& almanac,
+    const ReceiverPosition& position,
+    double time_of_week) const {
+
+    const Vec3 receiver = receiverPosition(position);
+    const double lat = position.latitude * DEG;
+    const double lon = position.longitude * DEG;
+    const double wavelength = SPEED_OF_LIGHT / GPS_L1_FREQ_HZ;
+
+    std::vector<VisibilityPrediction> predictions;
+    for (const AlmanacData& alm : almanac) {
+        const Vec3 before = satellitePosition(alm, time_of_week - 0.5);
+        const Vec3 now = satellitePosition(alm, time_of_week);
+        const Vec3 after = satellitePosition(alm, time_of_week + 0.5);
+        const Vec3 velocity = sub(after, before);
+
+        const Vec3 los = sub(now, receiver);
+        const double range = std::sqrt(dot(los, los));
+        double elevation, azimuth;
+        lookAngles(los, lat, lon, elevation, azimuth);
+
+        // Elevation a second later gives the rate over the time uncertainty
+        double elevation_next, azimuth_next;
+        lookAngles(sub(after, receiver), lat, lon, elevation_next, azimuth_next);
+        const double elevation_margin = config_.position_uncertainty / EARTH_RADIUS
+            + 2.0 * std::fabs(elevation_next - elevation) * config_.time_uncertainty;
+        if (elevation + elevation_margin < config_.elevation_mask * DEG) {
+            continue;
+        }
+
+        const double range_rate = dot(velocity, los) / range;
+        const double doppler = -range_rate / wavelength;
+
+        // Doppler one second on, for its rate over the time uncertainty;
+        // velocity again over one second, centred on the new line of sight
+        const Vec3 next = satellitePosition(alm, time_of_week + 1.0);
+        const Vec3 later = satellitePosition(alm, time_of_week + 1.5);
+        const Vec3 los_next = sub(next, receiver);
+        const double doppler_next = -dot(sub(later, after), los_next)
+                                  / std::sqrt(dot(los_next, los_next)) / wavelength;
+
+        // Moving the receiver sideways turns the line of sight across the velocity
+        const double cross_speed = std::sqrt(std::max(0.0, dot(velocity, velocity)
+                                                          - range_rate * range_rate));
+        const double uncertainty = config_.clock_uncertainty + ALMANAC_DOPPLER_ERROR
+            + std::fabs(doppler_next - doppler) * config_.time_uncertainty
+            + cross_speed * config_.position_uncertainty / range / wavelength;
+
+        predictions.push_back(VisibilityPrediction{alm.prn, elevation / DEG, azimuth / DEG,
+                                                   doppler + config_.clock_offset, uncertainty});
+    }
+    return predictions;
+}
+
+bool VisibilityPredictor::estimateClockOffset(const std::vector<VisibilityPrediction>& predictions,
+                                              const std::vector<SatelliteInfo>& satellites,
+                                              double& offset) const {
+    double sum = 0.0;
+    int used = 0;
+    for (const SatelliteInfo& sat : satellites) {
+        if (!sat.is_tracked) {
+            continue;
+        }
+        for (const VisibilityPrediction& prediction : predictions) {
+            if (prediction.prn == sat.prn) {
+                sum += sat.doppler_shift - (prediction.doppler - config_.clock_offset);
+                ++used;
+            }
+        }
+    }
+    if (used == 0) {
+        return false;
+    }
+    offset = sum / used;
+    return true;
+}
+
+double gpsTimeOfWeek(double unix_time) {
+    const double gps_time = unix_time - GPS_UNIX_OFFSET + GPS_LEAP_SECONDS;
+    return std::fmod(gps_time, GPS_WEEK_SECONDS);
+}
+
+}
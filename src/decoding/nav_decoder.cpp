@@ -0,0 +1,381 @@
+#include "decoding/nav_decoder.h"
+#include <cmath>
+#include <utility>
+
+namespace gps {
+
+namespace {
+
+// D25-D30 each cover D29*, D30* (bits 31-30) and some of D1-D24 (bits 29-6)
+constexpr uint32_t PARITY_MASKS[6] = {
+    0xBB1F3480, 0x5D8F9A40, 0xAEC7CD00, 0x5763E680, 0x6BB1F340, 0x8B7A89C0
+};
+
+// Field of the navigation message by its ICD subframe bit number (1-based)
+// and length. Each accessor is one shift and mask of a 24-bit data word.
+template <int Start, int Length>
+struct NavField {
+    static_assert(Length >= 1 && (Start - 1) % 30 + Length <= 24,
+                  "Field must lie within the data bits of one word");
+    static constexpr int LENGTH = Length;
+
+    static constexpr uint32_t get(const std::array<uint32_t, 10>& words) {
+        return (words[(Start - 1) / 30] >> (24 - (Start - 1) % 30 - Length))
+             & ((1u << Length) - 1u);
+    }
+};
+
+// Field split over two words, most significant part first
+template <typename Hi, typename Lo>
+struct NavSplitField {
+    static constexpr int LENGTH = Hi::LENGTH + Lo::LENGTH;
+
+    static constexpr uint32_t get(const std::array<uint32_t, 10>& words) {
+        return (Hi::get(words) << Lo::LENGTH) | Lo::get(words);
+    }
+};
+
+template <typename Field>
+constexpr int32_t navSigned(const std::array<uint32_t, 10>& words) {
+    return static_cast<int32_t>(Field::get(words) << (32 - Field::LENGTH)) >> (32 - Field::LENGTH);
+}
+
+// Telemetry and handover words
+using Preamble = NavField<1, 8>;
+using TowCount = NavField<31, 17>;
+using SubframeId = NavField<50, 3>;
+
+// Subframe 2
+using Iode2 = NavField<61, 8>;
+using M0 = NavSplitField<NavField<107, 8>, NavField<121, 24>>;
+using Eccentricity = NavSplitField<NavField<167, 8>, NavField<181, 24>>;
+using SqrtA = NavSplitField<NavField<227, 8>, NavField<241, 24>>;
+using Toe = NavField<271, 16>;
+
+// Subframe 3
+using Omega0 = NavSplitField<NavField<77, 8>, NavField<91, 24>>;
+using I0 = NavSplitField<NavField<137, 8>, NavField<151, 24>>;
+using Omega = NavSplitField<NavField<197, 8>, NavField<211, 24>>;
+using Iode3 = NavField<271, 8>;
+
+// Subframes 4 and 5, almanac pages
+using DataId = NavField<61, 2>;
+using SvId = NavField<63, 6>;
+using AlmEccentricity = NavField<69, 16>;
+using Toa = NavField<91, 8>;
+using DeltaI = NavField<99, 16>;
+using OmegaDot = NavField<121, 16>;
+using Health = NavField<137, 8>;
+using AlmSqrtA = NavField<151, 24>;
+using AlmOmega0 = NavField<181, 24>;
+using AlmOmega = NavField<211, 24>;
+using AlmM0 = NavField<241, 24>;
+using Af0 = NavSplitField<NavField<271, 8>, NavField<290, 3>>;
+using Af1 = NavField<279, 11>;
+
+constexpr double SEMICIRCLE = M_PI;
+
+// TOW counts per week
+constexpr uint32_t TOW_COUNT_WEEK = 100800;
+
+// Whether b is the subframe transmitted right after a
+bool followsSubframe(const NavigationDecoder::Subframe& a, const NavigationDecoder::Subframe& b) {
+    return b.id == a.id % 5 + 1
+        && TowCount::get(b.words) == (TowCount::get(a.words) + 1) % TOW_COUNT_WEEK;
+}
+
+}
+
+bool checkWordParity(uint32_t word, uint32_t& data) {
+    // D30* set means the transmitter inverted D1-D24
+    if (word & 0x40000000u) {
+        word ^= 0x3FFFFFC0u;
+    }
+    uint32_t parity = 0;
+    for (uint32_t mask : PARITY_MASKS) {
+        parity = (parity << 1) | (__builtin_popcount(word & mask) & 1u);
+    }
+    data = (word >> 6) & 0xFFFFFFu;
+    return parity == (word & 0x3Fu);
+}
+
+NavigationDecoder::NavigationDecoder() = default;
+
+void NavigationDecoder::setSubframeCallback(SubframeCallback callback) {
+    on_subframe_ = std::move(callback);
+}
+
+void NavigationDecoder::setEphemerisCallback(EphemerisCallback callback) {
+    on_ephemeris_ = std::move(callback);
+}
+
+void NavigationDecoder::addNavigationBit(int prn, bool bit, double timestamp) {
+    if (prn < 1 || prn > GPS_MAX_SATELLITES) {
+        return;
+    }
+    SatelliteData& sat = satellites_[prn];
+    sat.bits.push(bit);
+    sat.last_update_time = timestamp;
+
+    for (;;) {
+        if (sat.sync == FrameSync::SEARCH) {
+            if (!findPreamble(sat)) {
+                return;
+            }
+            continue;
+        }
+
+        // Subframes are read once their last bit is in
+        if (sat.bits.count() < sat.next_subframe + SUBFRAME_SIZE) {
+            return;
+        }
+        Subframe sf;
+        if (!extractSubframe(sat.bits, sat.next_subframe, sat.inverted, sf)
+            || !followsSubframe(sat.last, sf)) {
+            // A failed candidate is searched past; a lost lock resumes the search here
+            sat.scan_from = (sat.sync == FrameSync::VERIFY ? sat.next_subframe - SUBFRAME_SIZE
+                                                           : sat.next_subframe) + 1;
+            sat.sync = FrameSync::SEARCH;
+            continue;
+        }
+
+        if (sat.sync == FrameSync::VERIFY) {
+            sat.sync = FrameSync::LOCKED;
+            storeSubframe(prn, sat, sat.last);
+        }
+        sat.next_subframe += SUBFRAME_SIZE;
+        sat.last = sf;
+        storeSubframe(prn, sat, sf);
+    }
+}
+
+bool NavigationDecoder::findPreamble(SatelliteData& sat) {
+    const NavBitRing& bits = sat.bits;
+
+    // 64 offsets per pass; each needs its whole subframe in the ring
+    while (bits.count() >= sat.scan_from + 64 + SUBFRAME_SIZE) {
+        const uint64_t first = sat.scan_from;
+        const uint64_t hi = bits.get64(first);
+        const uint64_t lo = bits.get64(first + 64);
+
+        // Bit 63 - j of each mask: the preamble, upright or inverted, at first + j
+        uint64_t upright = ~0ull;
+        uint64_t inverse = ~0ull;
+        for (unsigned k = 0; k < 8; ++k) {
+            const uint64_t window = k == 0 ? hi : (hi << k) | (lo >> (64 - k));
+            if ((PREAMBLE >> (7 - k)) & 1u) {
+                upright &= window;
+                inverse &= ~window;
+            } else {
+                upright &= ~window;
+                inverse &= window;
+            }
+        }
+
+        // The pattern turns up in data too; parity over the subframe decides
+        for (uint64_t candidates = upright | inverse; candidates != 0; ) {
+            const unsigned j = static_cast<unsigned>(__builtin_clzll(candidates));
+            const uint64_t bit = 1ull << (63 - j);
+            candidates &= ~bit;
+
+            Subframe sf;
+            const bool inverted = (inverse & bit) != 0;
+            if (extractSubframe(bits, first + j, inverted, sf)) {
+                sat.sync = FrameSync::VERIFY;
+                sat.inverted = inverted;
+                sat.last = sf;
+                sat.next_subframe = first + j + SUBFRAME_SIZE;
+                return true;
+            }
+        }
+        sat.scan_from += 64;
+    }
+    return false;
+}
+
+bool NavigationDecoder::extractSubframe(const NavBitRing& bits, uint64_t first, bool inverted,
+                                        Subframe& sf) {
+    // Parity needs the last two bits of the previous word
+    if (first < 2) {
+        return false;
+    }
+    for (int w = 0; w < 10; ++w) {
+        uint32_t word = bits.get(first - 2 + static_cast<uint64_t>(w) * WORD_SIZE, 32);
+        if (inverted) {
+            word = ~word;
+        }
+        if (!checkWordParity(word, sf.words[w])) {
+            return false;
+        }
+    }
+
+    sf.id = static_cast<int>(SubframeId::get(sf.words));
+    sf.valid = Preamble::get(sf.words) == PREAMBLE && sf.id >= 1 && sf.id <= 5;
+    // The handover word counts to the start of the next subframe
+    sf.tow = TowCount::get(sf.words) * 6.0 - 6.0;
+    return sf.valid;
+}
+
+bool NavigationDecoder::storeSubframe(int prn, SatelliteData& sat, const Subframe& sf) {
+    sat.subframes[sf.id - 1] = sf;
+    sat.tow = sf.tow;
+    if (on_subframe_) {
+        on_subframe_(prn, sf);
+    }
+    if (sf.id == 4 || sf.id == 5) {
+        AlmanacData alm;
+        if (decodeAlmanac(sf, alm)) {
+            almanac_[alm.prn] = alm;
+            almanac_valid_[alm.prn] = true;
+        }
+        return false;
+    }
+    if (sf.id != 2 && sf.id != 3) {
+        return false;
+    }
+
+    const Subframe& sf2 = sat.subframes[1];
+    const Subframe& sf3 = sat.subframes[2];
+    if (!sf2.valid || !sf3.valid) {
+        return false;
+    }
+
+    // Both halves must come from the same issue of data
+    if (Iode2::get(sf2.words) != Iode3::get(sf3.words)) {
+        return false;
+    }
+
+    EphemerisData eph{};
+    eph.prn = prn;
+    if (!decodeSubframe2(sf2, eph) || !decodeSubframe3(sf3, eph)) {
+        return false;
+    }
+    const bool changed = !sat.ephemeris_valid || eph.toe != sat.ephemeris.toe
+                      || eph.m0 != sat.ephemeris.m0;
+    sat.ephemeris = eph;
+    sat.ephemeris_valid = true;
+    if (changed && on_ephemeris_) {
+        on_ephemeris_(eph);
+    }
+    return changed;
+}
+
+bool NavigationDecoder::decodeSubframe2(const Subframe& sf, EphemerisData& eph) {
+    if (!sf.valid || sf.id != 2) {
+        return false;
+    }
+    eph.m0 = navSigned<M0>(sf.words) * std::ldexp(1.0, -31) * SEMICIRCLE;
+    eph.ecc = Eccentricity::get(sf.words) * std::ldexp(1.0, -33);
+    eph.sqrt_a = SqrtA::get(sf.words) * std::ldexp(1.0, -19);
+    eph.toe = Toe::get(sf.words) * 16.0;
+    return true;
+}
+
+bool NavigationDecoder::decodeSubframe3(const Subframe& sf, EphemerisData& eph) {
+    if (!sf.valid || sf.id != 3) {
+        return false;
+    }
+    eph.omega0 = navSigned<Omega0>(sf.words) * std::ldexp(1.0, -31) * SEMICIRCLE;
+    eph.i0 = navSigned<I0>(sf.words) * std::ldexp(1.0, -31) * SEMICIRCLE;
+    eph.w = navSigned<Omega>(sf.words) * std::ldexp(1.0, -31) * SEMICIRCLE;
+    return true;
+}
+
+bool NavigationDecoder::decodeAlmanac(const Subframe& sf, AlmanacData& alm) {
+    // Pages with SV IDs past 32 carry other data; sqrt(A) of 0 marks a dummy page
+    const int sv_id = static_cast<int>(SvId::get(sf.words));
+    if (!sf.valid || (sf.id != 4 && sf.id != 5) || DataId::get(sf.words) != 1
+        || sv_id < 1 || sv_id > GPS_MAX_SATELLITES || AlmSqrtA::get(sf.words) == 0) {
+        return false;
+    }
+    alm.prn = sv_id;
+    alm.health = static_cast<int>(Health::get(sf.words));
+    alm.toa = Toa::get(sf.words) * std::ldexp(1.0, 12);
+    alm.ecc = AlmEccentricity::get(sf.words) * std::ldexp(1.0, -21);
+    alm.i0 = (0.3 + navSigned<DeltaI>(sf.words) * std::ldexp(1.0, -19)) * SEMICIRCLE;
+    alm.omega_dot = navSigned<OmegaDot>(sf.words) * std::ldexp(1.0, -38) * SEMICIRCLE;
+    alm.sqrt_a = AlmSqrtA::get(sf.words) * std::ldexp(1.0, -11);
+    alm.omega0 = navSigned<AlmOmega0>(sf.words) * std::ldexp(1.0, -23) * SEMICIRCLE;
+    alm.w = navSigned<AlmOmega>(sf.words) * std::ldexp(1.0, -23) * SEMICIRCLE;
+    alm.m0 = navSigned<AlmM0>(sf.words) * std::ldexp(1.0, -23) * SEMICIRCLE;
+    alm.af0 = navSigned<Af0>(sf.words) * std::ldexp(1.0, -20);
+    alm.af1 = navSigned<Af1>(sf.words) * std::ldexp(1.0, -38);
+    return true;
+}
+
+bool NavigationDecoder::processNavigationData(int prn, const NavigationData& nav_data) {
+    if (prn < 1 || prn > GPS_MAX_SATELLITES) {
+        return false;
+    }
+
+    // Words arrive framed and parity checked, data bits only
+    bool updated = false;
+    for (int i = 0; i < 5; ++i) {
+        if (!nav_data.subframe_valid[i]) {
+            continue;
+        }
+        Subframe sf;
+        for (int w = 0; w < 10; ++w) {
+            sf.words[w] = nav_data.subframe[i][w] & 0xFFFFFFu;
+        }
+        sf.id = static_cast<int>(SubframeId::get(sf.words));
+        sf.valid = Preamble::get(sf.words) == PREAMBLE && sf.id == i + 1;
+        sf.tow = TowCount::get(sf.words) * 6.0 - 6.0;
+        if (sf.valid) {
+            updated = storeSubframe(prn, satellites_[prn], sf) || updated;
+        }
+    }
+    return updated;
+}
+
+bool NavigationDecoder::getEphemeris(int prn, EphemerisData& ephemeris) const {
+    if (!hasValidEphemeris(prn)) {
+        return false;
+    }
+    ephemeris = satellites_[prn].ephemeris;
+    return true;
+}
+
+bool NavigationDecoder::getAlmanac(int prn, AlmanacData& almanac) const {
+    if (prn < 1 || prn > GPS_MAX_SATELLITES || !almanac_valid_[prn]) {
+        return false;
+    }
+    almanac = almanac_[prn];
+    return true;
+}
+
+void NavigationDecoder::setAlmanac(const AlmanacData& almanac) {
+    if (almanac.prn < 1 || almanac.prn > GPS_MAX_SATELLITES) {
+        return;
+    }
+    almanac_[almanac.prn] = almanac;
+    almanac_valid_[almanac.prn] = true;
+}
+
+void NavigationDecoder::setEphemeris(const EphemerisData& ephemeris) {
+    if (ephemeris.prn < 1 || ephemeris.prn > GPS_MAX_SATELLITES) {
+        return;
+    }
+    satellites_[ephemeris.prn].ephemeris = ephemeris;
+    satellites_[ephemeris.prn].ephemeris_valid = true;
+}
+
+bool NavigationDecoder::hasValidEphemeris(int prn) const {
+    return prn >= 1 && prn <= GPS_MAX_SATELLITES && satellites_[prn].ephemeris_valid;
+}
+
+double NavigationDecoder::getTimeOfWeek(int prn) const {
+    if (prn < 1 || prn > GPS_MAX_SATELLITES) {
+        return -1.0;
+    }
+    return satellites_[prn].tow;
+}
+
+NavigationDecoder::FrameSync NavigationDecoder::getFrameSync(int prn) const {
+    if (prn < 1 || prn > GPS_MAX_SATELLITES) {
+        return FrameSync::SEARCH;
+    }
+    return satellites_[prn].sync;
+}
+
+}
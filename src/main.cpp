@@ -4,10 +4,24 @@
 #include <signal.h>
 #include <atomic>
 #include <iomanip>
+#include <memory>
+#include <string>
+#include <cstdio>
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+#include <array>
+#include "acquisition/file_source.h"
+#include "acquisition/signal_generator.h"
+#ifdef GPS_HAVE_RTLSDR
 #include "acquisition/sdr_receiver.h"
+#endif
 #include "acquisition/signal_acquisition.h"
+#include "acquisition/visibility_predictor.h"
 #include "tracking/gps_tracker.h"
 #include "decoding/nav_decoder.h"
+#include "utils/hot_start.h"
+#include "utils/simd_dispatch.h"
 
 std::atomic<bool> g_running(true);
 
@@ -26,7 +40,316 @@ void printHeader() {
     std::cout << "\n";
 }
 
-void printStatus(const std::vector<gps::SatelliteInfo>& satellites) {
+void printUsage(const char* program) {
+    std::cout << "Usage: " << program << " [options]\n"
+              << "  --device <index>      RTL-SDR device index (default 0)\n"
+              << "  --file <path>         Replay a recording instead of a live device\n"
+              << "  --format <fmt>        Recording format: auto, u8, cf32 (default auto)\n"
+              << "  --sample-rate <Hz>    Sample rate of u8 recordings (default 2048000)\n"
+              << "  --realtime            Pace replay to the recording's sample rate\n"
+              << "  --loop                Restart replay at end of file\n"
+              << "  --fixed-point         Track on int8 samples instead of float\n"
+              << "  --simulate <count>    Use a synthetic signal with <count> satellites\n"
+              << "  --record <path>       With --simulate: write a recording and exit\n"
+              << "  --duration <s>        Length of simulated signal (default: endless)\n"
+              << "  --simd <level>        Limit kernels to scalar, sse4, avx2 or avx512\n"
+              << "  --workers <n>         Tracking workers incl. the main thread (default: cores, max 4)\n"
+              << "  --no-pin              Leave tracking workers unpinned\n"
+              << "  --batch <ms>          Track <ms> milliseconds per call, for replays (float only)\n"
+              << "  --state <path>        Hot start from this snapshot and keep it up to date\n"
+              << "  --position <lat,lon,h>  Approximate position; with an almanac, only satellites\n"
+              << "                        predicted visible are searched, around their Doppler\n";
+}
+
+struct ReceiverOptions {
+    int device_index = 0;
+    std::string file_path;
+    gps::SampleFileFormat file_format = gps::SampleFileFormat::AUTO;
+    double sample_rate = 2.048e6;
+    bool realtime = false;
+    bool loop = false;
+    gps::SampleFormat sample_format = gps::DEFAULT_SAMPLE_FORMAT;
+    int simulate_count = 0;
+    std::string record_path;
+    double duration = 0.0;
+    gps::TrackingSchedulerConfig scheduler;
+    bool force_simd = false;
+    gps::SimdLevel simd_level = gps::SimdLevel::SCALAR;
+    int batch_ms = 0;
+    std::string state_path;
+    bool has_position = false;
+    gps::ReceiverPosition position{};
+};
+
+bool parseArguments(int argc, char* argv[], ReceiverOptions& options) {
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        const bool has_value = i + 1 < argc;
+
+        if (std::strcmp(arg, "--device") == 0 && has_value) {
+            options.device_index = std::stoi(argv[++i]);
+        } else if (std::strcmp(arg, "--file") == 0 && has_value) {
+            options.file_path = argv[++i];
+        } else if (std::strcmp(arg, "--format") == 0 && has_value) {
+            std::string format = argv[++i];
+            if (format == "auto") {
+                options.file_format = gps::SampleFileFormat::AUTO;
+            } else if (format == "u8") {
+                options.file_format = gps::SampleFileFormat::UINT8_IQ;
+            } else if (format == "cf32") {
+                options.file_format = gps::SampleFileFormat::COMPLEX64;
+            } else {
+                std::cerr << "Unknown format: " << format << "\n";
+                return false;
+            }
+        } else if (std::strcmp(arg, "--sample-rate") == 0 && has_value) {
+            options.sample_rate = std::stod(argv[++i]);
+        } else if (std::strcmp(arg, "--realtime") == 0) {
+            options.realtime = true;
+        } else if (std::strcmp(arg, "--loop") == 0) {
+            options.loop = true;
+        } else if (std::strcmp(arg, "--fixed-point") == 0) {
+            options.sample_format = gps::SampleFormat::INT8;
+        } else if (std::strcmp(arg, "--simulate") == 0 && has_value) {
+            options.simulate_count = std::stoi(argv[++i]);
+        } else if (std::strcmp(arg, "--record") == 0 && has_value) {
+            options.record_path = argv[++i];
+        } else if (std::strcmp(arg, "--duration") == 0 && has_value) {
+            options.duration = std::stod(argv[++i]);
+        } else if (std::strcmp(arg, "--workers") == 0 && has_value) {
+            options.scheduler.num_workers = static_cast<unsigned>(std::stoi(argv[++i]));
+        } else if (std::strcmp(arg, "--no-pin") == 0) {
+            options.scheduler.pin_cores = false;
+        } else if (std::strcmp(arg, "--batch") == 0 && has_value) {
+            options.batch_ms = std::max(0, std::stoi(argv[++i]));
+        } else if (std::strcmp(arg, "--state") == 0 && has_value) {
+            options.state_path = argv[++i];
+        } else if (std::strcmp(arg, "--position") == 0 && has_value) {
+            gps::ReceiverPosition& position = options.position;
+            if (std::sscanf(argv[++i], "%lf,%lf,%lf", &position.latitude, &position.longitude,
+                            &position.height) != 3) {
+                std::cerr << "Position must be <lat,lon,height>: " << argv[i] << "\n";
+                return false;
+            }
+            options.has_position = true;
+        } else if (std::strcmp(arg, "--simd") == 0 && has_value) {
+            if (!gps::parseSimdLevel(argv[++i], options.simd_level)) {
+                std::cerr << "Unknown SIMD level: " << argv[i] << "\n";
+                return false;
+            }
+            options.force_simd = true;
+        } else {
+            std::cerr << "Unknown option: " << arg << "\n";
+            return false;
+        }
+    }
+    return true;
+}
+
+gps::SignalGeneratorConfig makeSimulationConfig(const ReceiverOptions& options,
+                                                double center_freq) {
+    gps::SignalGeneratorConfig config;
+    config.sample_rate = options.sample_rate;
+    config.center_freq = center_freq;
+    config.duration = options.duration;
+    
+    // Spread satellites over the Doppler and code phase search space
+    const int count = std::min(options.simulate_count, gps::GPS_MAX_SATELLITES);
+    for (int n = 0; n < count; ++n) {
+        gps::SyntheticSatellite sat;
+        sat.prn = n + 1;
+        sat.doppler = -4000.0 + 8000.0 * ((n * 7) % 13) / 12.0;
+        sat.doppler_rate = ((n % 3) - 1) * 0.6;
+        sat.code_phase = std::fmod(n * 311.7, gps::GPS_CA_CODE_LENGTH);
+        sat.cn0 = 38.0 + (n % 5) * 2.5;
+        config.satellites.push_back(sat);
+    }
+    return config;
+}
+
+std::unique_ptr<gps::SampleSource> createSampleSource(const ReceiverOptions& options,
+                                                      double center_freq) {
+    if (options.simulate_count > 0) {
+        std::cout << "Simulating " << options.simulate_count << " satellites...\n";
+        auto generator = std::make_unique<gps::SignalGenerator>(
+            makeSimulationConfig(options, center_freq));
+        generator->setReplayMode(options.realtime ? gps::ReplayMode::REALTIME
+                                                  : gps::ReplayMode::MAX_SPEED);
+        return generator;
+    }
+    
+    if (!options.file_path.empty()) {
+        std::cout << "Opening sample file...\n";
+        auto file_source = std::make_unique<gps::FileSource>();
+        if (!file_source->open(options.file_path, options.file_format,
+                               options.sample_rate, center_freq)) {
+            return nullptr;
+        }
+        file_source->setReplayMode(options.realtime ? gps::ReplayMode::REALTIME
+                                                    : gps::ReplayMode::MAX_SPEED);
+        file_source->setLooping(options.loop);
+        return file_source;
+    }
+
+#ifdef GPS_HAVE_RTLSDR
+    std::cout << "Initializing SDR receiver...\n";
+    auto receiver = std::make_unique<gps::SDRReceiver>();
+    if (!receiver->initializeDevice(options.device_index, options.sample_rate, center_freq)) {
+        std::cerr << "Failed to initialize SDR device!\n";
+        return nullptr;
+    }
+    return receiver;
+#else
+    std::cerr << "Built without RTL-SDR support, use --file to replay a recording\n";
+    return nullptr;
+#endif
+}
+
+double unixTime() {
+    return std::chrono::duration<double>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+// Seed the decoder and the searches from a saved snapshot, as far as it is still fresh
+void applyHotStart(const gps::HotStartState& state,
+                   gps::GPSTracker& tracker,
+                   gps::NavigationDecoder& decoder,
+                   std::array<bool, gps::GPS_MAX_SATELLITES + 1>& have_ephemeris) {
+    const double now = unixTime();
+    const double age = std::max(0.0, now - state.saved_time);
+    const double time_of_week = gps::gpsTimeOfWeek(now);
+    int ephemerides = 0;
+    int hints = 0;
+    for (int prn = 1; prn <= gps::GPS_MAX_SATELLITES; ++prn) {
+        // A fresh snapshot can still hold an ephemeris decoded hours before it
+        if (state.ephemeris_valid[prn] && age < gps::HOT_START_EPHEMERIS_AGE
+            && gps::ephemerisCurrent(state.ephemeris[prn], time_of_week)) {
+            decoder.setEphemeris(state.ephemeris[prn]);
+            have_ephemeris[prn] = true;
+            ++ephemerides;
+        }
+        const gps::SatelliteInfo& channel = state.channels[prn];
+        if (channel.is_tracked && age < gps::HOT_START_DOPPLER_AGE) {
+            tracker.setDopplerHint(prn, channel.doppler_shift,
+                                   gps::HOT_START_DOPPLER_UNCERTAINTY
+                                   + gps::HOT_START_DOPPLER_DRIFT * age);
+            ++hints;
+        }
+    }
+    int almanacs = 0;
+    for (int prn = 1; prn <= gps::GPS_MAX_SATELLITES; ++prn) {
+        if (state.almanac_valid[prn] && age < gps::HOT_START_ALMANAC_AGE) {
+            decoder.setAlmanac(state.almanac[prn]);
+            ++almanacs;
+        }
+    }
+    std::cout << "Hot start from a snapshot " << static_cast<long>(age) << " s old: "
+              << ephemerides << " ephemerides, " << almanacs << " almanac pages, "
+              << hints << " Doppler hints\n";
+}
+
+// Search only the satellites the almanac puts above the horizon, each around
+// its predicted Doppler; PRNs without an almanac are searched as before
+void applyVisibility(const std::vector<int>& prn_list,
+                     const gps::ReceiverPosition& position,
+                     double time_of_week,
+                     gps::GPSTracker& tracker,
+                     const gps::NavigationDecoder& decoder) {
+    std::vector<gps::AlmanacData> almanac;
+    gps::AlmanacData alm;
+    for (int prn : prn_list) {
+        if (decoder.getAlmanac(prn, alm)) {
+            almanac.push_back(alm);
+        }
+    }
+    if (almanac.empty()) {
+        return;
+    }
+
+    gps::VisibilityPredictor predictor;
+    std::vector<gps::VisibilityPrediction> predictions =
+        predictor.predict(almanac, position, time_of_week);
+
+    // Tracked satellites give away the oscillator offset every window shares
+    const std::vector<gps::SatelliteInfo> satellites = tracker.getTrackedSatellites();
+    gps::VisibilityConfig config = predictor.getConfig();
+    if (predictor.estimateClockOffset(predictions, satellites, config.clock_offset)) {
+        config.clock_uncertainty = 0.0;
+        predictor.setConfig(config);
+        predictions = predictor.predict(almanac, position, time_of_week);
+    }
+
+    for (const gps::AlmanacData& entry : almanac) {
+        auto prediction = std::find_if(predictions.begin(), predictions.end(),
+                                       [&entry](const gps::VisibilityPrediction& p) {
+                                           return p.prn == entry.prn;
+                                       });
+        const bool visible = prediction != predictions.end();
+        const bool tracked = std::any_of(satellites.begin(), satellites.end(),
+                                         [&entry](const gps::SatelliteInfo& sat) {
+                                             return sat.prn == entry.prn && sat.is_tracked;
+                                         });
+        tracker.setAcquisitionEnabled(entry.prn, visible);
+        if (visible && !tracked) {
+            double low = prediction->doppler - prediction->doppler_uncertainty;
+            double high = prediction->doppler + prediction->doppler_uncertainty;
+            // A hot start hint was measured with the oscillator offset in it,
+            // so it is often the tighter window; search where both agree
+            double hint = 0.0;
+            double uncertainty = 0.0;
+            if (tracker.getDopplerHint(entry.prn, hint, uncertainty)) {
+                const double hint_low = hint - uncertainty;
+                const double hint_high = hint + uncertainty;
+                if (std::max(low, hint_low) < std::min(high, hint_high)) {
+                    low = std::max(low, hint_low);
+                    high = std::min(high, hint_high);
+                } else if (hint_high - hint_low < high - low) {
+                    low = hint_low;
+                    high = hint_high;
+                }
+            }
+            tracker.setDopplerHint(entry.prn, 0.5 * (low + high), 0.5 * (high - low));
+        }
+    }
+}
+
+// GPS time of week from the navigation data, else from the clock for live input
+bool receiverTimeOfWeek(const ReceiverOptions& options,
+                        const gps::NavigationDecoder& decoder,
+                        double& time_of_week) {
+    time_of_week = -1.0;
+    for (int prn = 1; prn <= gps::GPS_MAX_SATELLITES; ++prn) {
+        time_of_week = std::max(time_of_week, decoder.getTimeOfWeek(prn));
+    }
+    if (time_of_week >= 0.0) {
+        return true;
+    }
+    // Recordings were made at some other time
+    if (options.file_path.empty() && options.simulate_count == 0) {
+        time_of_week = gps::gpsTimeOfWeek(unixTime());
+        return true;
+    }
+    return false;
+}
+
+gps::HotStartState collectHotStart(const gps::GPSTracker& tracker,
+                                   const gps::NavigationDecoder& decoder) {
+    gps::HotStartState state;
+    state.saved_time = unixTime();
+    for (int prn = 1; prn <= gps::GPS_MAX_SATELLITES; ++prn) {
+        state.ephemeris_valid[prn] = decoder.getEphemeris(prn, state.ephemeris[prn]);
+    }
+    for (const auto& sat : tracker.getTrackedSatellites()) {
+        state.channels[sat.prn] = sat;
+    }
+    for (int prn = 1; prn <= gps::GPS_MAX_SATELLITES; ++prn) {
+        state.almanac_valid[prn] = decoder.getAlmanac(prn, state.almanac[prn]);
+    }
+    return state;
+}
+
+void printStatus(const std::vector<gps::SatelliteInfo>& satellites,
+                 const std::array<bool, gps::GPS_MAX_SATELLITES + 1>& have_ephemeris) {
     // Clear screen (works on Unix-like systems)
     std::cout << "\033[2J\033[1;1H";
     
@@ -47,7 +370,7 @@ void printStatus(const std::vector<gps::SatelliteInfo>& satellites) {
                   << std::setw(15) << (sat.is_tracked ? "TRACKING" : "SEARCHING")
                   << std::setw(15) << std::fixed << std::setprecision(1) << sat.doppler_shift
                   << std::setw(15) << std::fixed << std::setprecision(1) << sat.cn0
-                  << std::setw(15) << (sat.has_ephemeris ? "YES" : "NO")
+                  << std::setw(15) << (sat.has_ephemeris || have_ephemeris[sat.prn] ? "YES" : "NO")
                   << "\n";
     }
     std::cout << "\nPress Ctrl+C to exit...\n";
@@ -57,12 +380,37 @@ int main(int argc, char* argv[]) {
     
     signal(SIGINT, signalHandler);
     
+    ReceiverOptions options;
+    if (!parseArguments(argc, argv, options)) {
+        printUsage(argv[0]);
+        return 1;
+    }
+    
     printHeader();
+
+    // Before any kernel runs, since kernels latch the level on first use
+    if (options.force_simd) {
+        gps::setSimdLevel(options.simd_level);
+    }
+    std::cout << "SIMD kernels: " << gps::simdLevelName(gps::activeSimdLevel())
+              << " (CPU supports " << gps::simdLevelName(gps::detectSimdLevel()) << ")\n";
     
     
-    const double sample_rate = 2.048e6;  
     const double center_freq = 1575.42e6;  
-    const int device_index = 0;
+    
+    if (!options.record_path.empty()) {
+        if (options.simulate_count <= 0 || options.duration <= 0.0) {
+            std::cerr << "--record needs --simulate and --duration\n";
+            return 1;
+        }
+        gps::SignalGenerator generator(makeSimulationConfig(options, center_freq));
+        auto format = options.file_format == gps::SampleFileFormat::UINT8_IQ
+                          ? gps::SampleFileFormat::UINT8_IQ
+                          : gps::SampleFileFormat::COMPLEX64;
+        std::cout << "Writing " << options.duration << " s of simulated signal to "
+                  << options.record_path << "...\n";
+        return generator.writeRecording(options.record_path, format, options.duration) ? 0 : 1;
+    }
     
     
     std::vector<int> prn_list;
@@ -72,26 +420,56 @@ int main(int argc, char* argv[]) {
     
     try {
         
-        std::cout << "Initializing SDR receiver...\n";
-        gps::SDRReceiver receiver;
-        
-        if (!receiver.initializeDevice(device_index, sample_rate, center_freq)) {
-            std::cerr << "Failed to initialize SDR device!\n";
+        auto source = createSampleSource(options, center_freq);
+        if (!source) {
+            return 1;
+        }
+        const double sample_rate = source->getSampleRate();
+        const bool fixed_point = options.sample_format == gps::SampleFormat::INT8;
+        if (!source->setSampleFormat(options.sample_format)) {
+            std::cerr << "Sample source does not support the requested sample format!\n";
+            return 1;
+        }
+        // A live source holds only so much; a longer span would never arrive
+        const size_t max_read = source->getMaxReadSize();
+        const size_t batch_samples = static_cast<size_t>(sample_rate * 0.001) * options.batch_ms;
+        if (!fixed_point && max_read > 0 && batch_samples > max_read) {
+            std::cerr << "--batch " << options.batch_ms << " ms is longer than this source can hold, "
+                      << "use at most " << static_cast<int>(max_read / (sample_rate * 0.001))
+                      << " ms\n";
             return 1;
         }
         
         
         std::cout << "Initializing GPS tracker...\n";
-        gps::GPSTracker tracker(sample_rate);
+        gps::GPSTracker tracker(sample_rate, options.scheduler);
         tracker.initialize(prn_list);
         
         
         std::cout << "Initializing navigation decoder...\n";
         gps::NavigationDecoder decoder;
+        std::array<bool, gps::GPS_MAX_SATELLITES + 1> have_ephemeris{};
+        decoder.setEphemerisCallback([&have_ephemeris](const gps::EphemerisData& eph) {
+            have_ephemeris[eph.prn] = true;
+        });
+        // Bits go straight to the decoder as each channel produces them
+        tracker.setNavigationBitHandler([&decoder](int prn, bool bit, double time) {
+            decoder.addNavigationBit(prn, bit, time);
+        });
+
+        gps::HotStartState hot_start;
+        if (!options.state_path.empty() && gps::loadHotStart(options.state_path, hot_start)) {
+            applyHotStart(hot_start, tracker, decoder, have_ephemeris);
+        }
+
+        double time_of_week = 0.0;
+        if (options.has_position && receiverTimeOfWeek(options, decoder, time_of_week)) {
+            applyVisibility(prn_list, options.position, time_of_week, tracker, decoder);
+        }
         
        
         std::cout << "Starting data capture...\n";
-        if (!receiver.startCapture()) {
+        if (!source->startCapture()) {
             std::cerr << "Failed to start data capture!\n";
             return 1;
         }
@@ -104,41 +482,69 @@ int main(int argc, char* argv[]) {
         
         const size_t buffer_size = static_cast<size_t>(sample_rate * 0.001);  
         gps::IQBuffer sample_buffer;
+        gps::SampleSpan<gps::IQSample8> fixed_span;
+        gps::SampleSpan<gps::IQSample> batch_span;
+        std::vector<gps::TrackingEpoch> batch_epochs;
+        const bool batched = options.batch_ms > 0 && !fixed_point;
         
         auto last_status_time = std::chrono::steady_clock::now();
         const auto status_interval = std::chrono::seconds(1);
+        auto last_state_time = last_status_time;
+        const auto state_interval = std::chrono::seconds(30);
+        auto last_visibility_time = last_status_time;
+        const auto visibility_interval = std::chrono::seconds(60);
         
         while (g_running) {
             
-            if (receiver.getSamples(sample_buffer, buffer_size)) {
-                
-                tracker.processSamples(sample_buffer);
-                
-                
-                auto satellites = tracker.getTrackedSatellites();
-                for (const auto& sat : satellites) {
-                    if (sat.is_tracked) {
-                        auto nav_data = tracker.getNavigationData(sat.prn);
-                        decoder.processNavigationData(sat.prn, nav_data);
-                    }
+            bool have_samples = false;
+            if (batched) {
+                have_samples = source->readSamples(batch_span, buffer_size * options.batch_ms);
+                if (have_samples) {
+                    tracker.processBatch(batch_span.data, batch_span.size, batch_epochs);
+                    source->consumeSamples(batch_span.size);
                 }
-                
-                
+            } else if (fixed_point) {
+                // No staging buffer: the tracker reads straight out of the source
+                have_samples = source->readSamples(fixed_span, buffer_size);
+                if (have_samples) {
+                    tracker.processSamples(fixed_span.data, fixed_span.size);
+                    source->consumeSamples(fixed_span.size);
+                }
+            } else if (source->getSamples(sample_buffer, buffer_size)) {
+                have_samples = true;
+                tracker.processSamples(sample_buffer);
+            }
+            
+            if (have_samples) {
+                // Navigation bits reached the decoder inside the calls above
                 auto now = std::chrono::steady_clock::now();
                 if (now - last_status_time >= status_interval) {
-                    printStatus(satellites);
+                    printStatus(tracker.getTrackedSatellites(), have_ephemeris);
                     last_status_time = now;
                 }
+                if (options.has_position && now - last_visibility_time >= visibility_interval) {
+                    if (receiverTimeOfWeek(options, decoder, time_of_week)) {
+                        applyVisibility(prn_list, options.position, time_of_week, tracker, decoder);
+                    }
+                    last_visibility_time = now;
+                }
+                if (!options.state_path.empty() && now - last_state_time >= state_interval) {
+                    gps::saveHotStart(options.state_path, collectHotStart(tracker, decoder));
+                    last_state_time = now;
+                }
+            } else if (source->isFinished()) {
+                std::cout << "\nEnd of recording reached.\n";
+                break;
             }
-            
-            
-            std::this_thread::sleep_for(std::chrono::microseconds(100));
         }
         
         
         std::cout << "\nShutting down...\n";
         tracker.stopTracking();
-        receiver.stopCapture();
+        source->stopCapture();
+        if (!options.state_path.empty()) {
+            gps::saveHotStart(options.state_path, collectHotStart(tracker, decoder));
+        }
         
     } catch (const std::exception& e) {
         std::cerr << "Error: " << e.what() << std::endl;
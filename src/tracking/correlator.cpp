@@ -0,0 +1,432 @@
+#include "tracking/correlator.h"
+#include <immintrin.h>
+#include <array>
+#include <cmath>
+
+namespace gps {
+
+namespace {
+
+// One full sine period, quantized to INT8_CARRIER_SCALE
+struct SineTable8 {
+    std::array<int8_t, 256> values;
+
+    SineTable8() {
+        for (int n = 0; n < 256; ++n) {
+            values[n] = static_cast<int8_t>(
+                std::lround(INT8_CARRIER_SCALE * std::sin(2.0 * M_PI * n / 256.0)));
+        }
+    }
+};
+
+const SineTable8 kSineTable8;
+
+}
+
+namespace {
+
+void correlateScalar(const float* __restrict__ samples_i,
+                     const float* __restrict__ samples_q,
+                     const float* __restrict__ code,
+                     const float* __restrict__ carrier_i,
+                     const float* __restrict__ carrier_q,
+                     size_t length,
+                     float& corr_i,
+                     float& corr_q) {
+    corr_i = 0.0f;
+    corr_q = 0.0f;
+    for (size_t i = 0; i < length; ++i) {
+        float mix_i = samples_i[i] * carrier_i[i] + samples_q[i] * carrier_q[i];
+        float mix_q = samples_q[i] * carrier_i[i] - samples_i[i] * carrier_q[i];
+        corr_i += mix_i * code[i];
+        corr_q += mix_q * code[i];
+    }
+}
+
+GPS_TARGET_SSE4
+void correlateSSE4(const float* __restrict__ samples_i,
+                   const float* __restrict__ samples_q,
+                   const float* __restrict__ code,
+                   const float* __restrict__ carrier_i,
+                   const float* __restrict__ carrier_q,
+                   size_t length,
+                   float& corr_i,
+                   float& corr_q) {
+    __m128 sum_i = _mm_setzero_ps();
+    __m128 sum_q = _mm_setzero_ps();
+
+    size_t simd_length = length & ~static_cast<size_t>(3);
+    for (size_t i = 0; i < simd_length; i += 4) {
+        __m128 samp_i = _mm_loadu_ps(&samples_i[i]);
+        __m128 samp_q = _mm_loadu_ps(&samples_q[i]);
+        __m128 code_vec = _mm_loadu_ps(&code[i]);
+        __m128 carr_i = _mm_loadu_ps(&carrier_i[i]);
+        __m128 carr_q = _mm_loadu_ps(&carrier_q[i]);
+
+        __m128 real = _mm_add_ps(_mm_mul_ps(samp_i, carr_i), _mm_mul_ps(samp_q, carr_q));
+        __m128 imag = _mm_sub_ps(_mm_mul_ps(samp_q, carr_i), _mm_mul_ps(samp_i, carr_q));
+        sum_i = _mm_add_ps(sum_i, _mm_mul_ps(real, code_vec));
+        sum_q = _mm_add_ps(sum_q, _mm_mul_ps(imag, code_vec));
+    }
+
+    __m128 result = _mm_hadd_ps(sum_i, sum_q);
+    result = _mm_hadd_ps(result, result);
+    corr_i = _mm_cvtss_f32(result);
+    corr_q = _mm_cvtss_f32(_mm_shuffle_ps(result, result, 1));
+
+    for (size_t i = simd_length; i < length; ++i) {
+        float mix_i = samples_i[i] * carrier_i[i] + samples_q[i] * carrier_q[i];
+        float mix_q = samples_q[i] * carrier_i[i] - samples_i[i] * carrier_q[i];
+        corr_i += mix_i * code[i];
+        corr_q += mix_q * code[i];
+    }
+}
+
+GPS_AVX512_BEGIN
+GPS_TARGET_AVX512
+void correlateAVX512(const float* __restrict__ samples_i,
+                     const float* __restrict__ samples_q,
+                     const float* __restrict__ code,
+                     const float* __restrict__ carrier_i,
+                     const float* __restrict__ carrier_q,
+                     size_t length,
+                     float& corr_i,
+                     float& corr_q) {
+    __m512 sum_i = _mm512_setzero_ps();
+    __m512 sum_q = _mm512_setzero_ps();
+
+    size_t simd_length = length & ~static_cast<size_t>(15);
+    for (size_t i = 0; i < simd_length; i += 16) {
+        __m512 samp_i = _mm512_loadu_ps(&samples_i[i]);
+        __m512 samp_q = _mm512_loadu_ps(&samples_q[i]);
+        __m512 code_vec = _mm512_loadu_ps(&code[i]);
+        __m512 carr_i = _mm512_loadu_ps(&carrier_i[i]);
+        __m512 carr_q = _mm512_loadu_ps(&carrier_q[i]);
+
+        __m512 real = _mm512_fmadd_ps(samp_q, carr_q, _mm512_mul_ps(samp_i, carr_i));
+        __m512 imag = _mm512_fnmadd_ps(samp_i, carr_q, _mm512_mul_ps(samp_q, carr_i));
+        sum_i = _mm512_fmadd_ps(real, code_vec, sum_i);
+        sum_q = _mm512_fmadd_ps(imag, code_vec, sum_q);
+    }
+
+    corr_i = _mm512_reduce_add_ps(sum_i);
+    corr_q = _mm512_reduce_add_ps(sum_q);
+
+    for (size_t i = simd_length; i < length; ++i) {
+        float mix_i = samples_i[i] * carrier_i[i] + samples_q[i] * carrier_q[i];
+        float mix_q = samples_q[i] * carrier_i[i] - samples_i[i] * carrier_q[i];
+        corr_i += mix_i * code[i];
+        corr_q += mix_q * code[i];
+    }
+}
+GPS_AVX512_END
+
+void correlateInt8Scalar(const int8_t* __restrict__ samples,
+                         const int8_t* __restrict__ code,
+                         const int8_t* __restrict__ carrier_re,
+                         const int8_t* __restrict__ carrier_im,
+                         size_t length,
+                         int32_t& corr_i,
+                         int32_t& corr_q) {
+    corr_i = 0;
+    corr_q = 0;
+    for (size_t i = 0; i < 2 * length; i += 2) {
+        int s_i = samples[i] * code[i];
+        int s_q = samples[i + 1] * code[i + 1];
+        corr_i += s_i * carrier_re[i] + s_q * carrier_re[i + 1];
+        corr_q += s_i * carrier_im[i] + s_q * carrier_im[i + 1];
+    }
+}
+
+// Same scheme as correlateInt8AVX on 16 bytes
+GPS_TARGET_SSE4
+void correlateInt8SSE4(const int8_t* __restrict__ samples,
+                       const int8_t* __restrict__ code,
+                       const int8_t* __restrict__ carrier_re,
+                       const int8_t* __restrict__ carrier_im,
+                       size_t length,
+                       int32_t& corr_i,
+                       int32_t& corr_q) {
+    const size_t num_bytes = length * 2;
+    const __m128i ones = _mm_set1_epi16(1);
+    __m128i sum_i = _mm_setzero_si128();
+    __m128i sum_q = _mm_setzero_si128();
+
+    size_t simd_bytes = num_bytes & ~static_cast<size_t>(15);
+    for (size_t i = 0; i < simd_bytes; i += 16) {
+        __m128i samp = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&samples[i]));
+        __m128i code_vec = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&code[i]));
+        __m128i carr_re = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&carrier_re[i]));
+        __m128i carr_im = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&carrier_im[i]));
+
+        __m128i x = _mm_sign_epi8(samp, code_vec);
+        __m128i x_abs = _mm_abs_epi8(x);
+
+        __m128i real = _mm_maddubs_epi16(x_abs, _mm_sign_epi8(carr_re, x));
+        __m128i imag = _mm_maddubs_epi16(x_abs, _mm_sign_epi8(carr_im, x));
+
+        sum_i = _mm_add_epi32(sum_i, _mm_madd_epi16(real, ones));
+        sum_q = _mm_add_epi32(sum_q, _mm_madd_epi16(imag, ones));
+    }
+
+    __m128i result = _mm_hadd_epi32(sum_i, sum_q);
+    result = _mm_hadd_epi32(result, result);
+    corr_i = _mm_cvtsi128_si32(result);
+    corr_q = _mm_extract_epi32(result, 1);
+
+    for (size_t i = simd_bytes; i < num_bytes; i += 2) {
+        int s_i = samples[i] * code[i];
+        int s_q = samples[i + 1] * code[i + 1];
+        corr_i += s_i * carrier_re[i] + s_q * carrier_re[i + 1];
+        corr_q += s_i * carrier_im[i] + s_q * carrier_im[i + 1];
+    }
+}
+
+}
+
+GPS_TARGET_AVX2
+void correlateAVX(const float* __restrict__ samples_i,
+                  const float* __restrict__ samples_q,
+                  const float* __restrict__ code,
+                  const float* __restrict__ carrier_i,
+                  const float* __restrict__ carrier_q,
+                  size_t length,
+                  float& corr_i,
+                  float& corr_q) {
+    __m256 sum_i = _mm256_setzero_ps();
+    __m256 sum_q = _mm256_setzero_ps();
+
+
+    size_t simd_length = length & ~7;
+
+    for (size_t i = 0; i < simd_length; i += 8) {
+
+        __m256 samp_i = _mm256_loadu_ps(&samples_i[i]);
+        __m256 samp_q = _mm256_loadu_ps(&samples_q[i]);
+
+
+        __m256 code_vec = _mm256_loadu_ps(&code[i]);
+
+
+        __m256 carr_i = _mm256_loadu_ps(&carrier_i[i]);
+        __m256 carr_q = _mm256_loadu_ps(&carrier_q[i]);
+
+        // Complex multiplication: (samp_i + j*samp_q) * (carr_i - j*carr_q) * code
+        // Real part: (samp_i * carr_i + samp_q * carr_q) * code
+        __m256 real = _mm256_mul_ps(samp_i, carr_i);
+        real = _mm256_fmadd_ps(samp_q, carr_q, real);
+        real = _mm256_mul_ps(real, code_vec);
+
+        // Imaginary part: (samp_q * carr_i - samp_i * carr_q) * code
+        __m256 imag = _mm256_mul_ps(samp_q, carr_i);
+        imag = _mm256_fnmadd_ps(samp_i, carr_q, imag);
+        imag = _mm256_mul_ps(imag, code_vec);
+
+        // Accumulate
+        sum_i = _mm256_add_ps(sum_i, real);
+        sum_q = _mm256_add_ps(sum_q, imag);
+    }
+
+    // Horizontal sum
+    __m256 temp = _mm256_hadd_ps(sum_i, sum_q);
+    temp = _mm256_hadd_ps(temp, temp);
+    __m128 hi = _mm256_extractf128_ps(temp, 1);
+    __m128 lo = _mm256_castps256_ps128(temp);
+    __m128 result = _mm_add_ps(hi, lo);
+
+    corr_i = _mm_cvtss_f32(result);
+    corr_q = _mm_cvtss_f32(_mm_shuffle_ps(result, result, 1));
+
+    // Handle remaining samples
+    for (size_t i = simd_length; i < length; ++i) {
+        float mix_i = samples_i[i] * carrier_i[i] + samples_q[i] * carrier_q[i];
+        float mix_q = samples_q[i] * carrier_i[i] - samples_i[i] * carrier_q[i];
+        corr_i += mix_i * code[i];
+        corr_q += mix_q * code[i];
+    }
+}
+
+GPS_TARGET_AVX2
+void correlateInt8AVX(const int8_t* __restrict__ samples,
+                      const int8_t* __restrict__ code,
+                      const int8_t* __restrict__ carrier_re,
+                      const int8_t* __restrict__ carrier_im,
+                      size_t length,
+                      int32_t& corr_i,
+                      int32_t& corr_q) {
+    const size_t num_bytes = length * 2;
+    const __m256i ones = _mm256_set1_epi16(1);
+    __m256i sum_i = _mm256_setzero_si256();
+    __m256i sum_q = _mm256_setzero_si256();
+
+    size_t simd_bytes = num_bytes & ~static_cast<size_t>(31);
+
+    for (size_t i = 0; i < simd_bytes; i += 32) {
+        __m256i samp = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&samples[i]));
+        __m256i code_vec = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&code[i]));
+        __m256i carr_re = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&carrier_re[i]));
+        __m256i carr_im = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&carrier_im[i]));
+
+        // Code wipe-off
+        __m256i x = _mm256_sign_epi8(samp, code_vec);
+        __m256i x_abs = _mm256_abs_epi8(x);
+
+        // Real: I*cos + Q*sin, imaginary: Q*cos - I*sin (int16 per sample)
+        __m256i real = _mm256_maddubs_epi16(x_abs, _mm256_sign_epi8(carr_re, x));
+        __m256i imag = _mm256_maddubs_epi16(x_abs, _mm256_sign_epi8(carr_im, x));
+
+        // Widen to int32 and accumulate
+        sum_i = _mm256_add_epi32(sum_i, _mm256_madd_epi16(real, ones));
+        sum_q = _mm256_add_epi32(sum_q, _mm256_madd_epi16(imag, ones));
+    }
+
+    // Horizontal sum
+    __m256i temp = _mm256_hadd_epi32(sum_i, sum_q);
+    temp = _mm256_hadd_epi32(temp, temp);
+    __m128i result = _mm_add_epi32(_mm256_castsi256_si128(temp),
+                                   _mm256_extracti128_si256(temp, 1));
+
+    corr_i = _mm_cvtsi128_si32(result);
+    corr_q = _mm_extract_epi32(result, 1);
+
+    // Handle remaining samples
+    for (size_t i = simd_bytes; i < num_bytes; i += 2) {
+        int s_i = samples[i] * code[i];
+        int s_q = samples[i + 1] * code[i + 1];
+        corr_i += s_i * carrier_re[i] + s_q * carrier_re[i + 1];
+        corr_q += s_i * carrier_im[i] + s_q * carrier_im[i + 1];
+    }
+}
+
+// AVX-512 has no byte sign instruction, so int8 stops at AVX2
+const KernelSet<CorrelateKernel> kCorrelateKernels = {
+    correlateScalar, correlateSSE4, correlateAVX, correlateAVX512};
+const KernelSet<CorrelateInt8Kernel> kCorrelateInt8Kernels = {
+    correlateInt8Scalar, correlateInt8SSE4, correlateInt8AVX, nullptr};
+
+Correlator::Correlator(int prn, double sample_rate)
+    : prn_(prn)
+    , sample_rate_(sample_rate)
+    , carrier_nco_(sample_rate, NCOMode::ROTATOR)
+    , code_nco_(prn, sample_rate) {
+}
+
+void Correlator::generateCarrier(double phase, double freq, size_t length,
+                                 std::vector<float>& carrier_i,
+                                 std::vector<float>& carrier_q) {
+    carrier_i.resize(length);
+    carrier_q.resize(length);
+
+    carrier_nco_.setPhase(phase);
+    carrier_nco_.setFrequency(freq);
+    carrier_nco_.generate(length, carrier_i.data(), carrier_q.data());
+}
+
+void Correlator::generateCarrier8(double phase, double freq, size_t length) {
+    carrier_re8_.resize(length * 2);
+    carrier_im8_.resize(length * 2);
+
+    // 32-bit phase accumulator, top 8 bits (rounded) index the sine table
+    uint32_t acc = CarrierNCO::toPhaseWord(phase);
+    const uint32_t step = CarrierNCO::toPhaseStep(freq, sample_rate_);
+
+    for (size_t i = 0; i < length; ++i) {
+        uint8_t index = static_cast<uint8_t>((acc + (1u << 23)) >> 24);
+        int8_t s = kSineTable8.values[index];
+        int8_t c = kSineTable8.values[static_cast<uint8_t>(index + 64)];
+
+        carrier_re8_[2 * i] = c;
+        carrier_re8_[2 * i + 1] = s;
+        carrier_im8_[2 * i] = static_cast<int8_t>(-s);
+        carrier_im8_[2 * i + 1] = c;
+        acc += step;
+    }
+}
+
+CorrelationResult Correlator::correlate(const IQBuffer& samples,
+                                        double code_phase,
+                                        double carrier_phase,
+                                        double carrier_freq) {
+    return correlate(samples.data(), samples.size(), code_phase, carrier_phase, carrier_freq);
+}
+
+CorrelationResult Correlator::correlate(const IQSample* samples,
+                                        size_t length,
+                                        double code_phase,
+                                        double carrier_phase,
+                                        double carrier_freq) {
+    samples_i_.resize(length);
+    samples_q_.resize(length);
+    for (size_t i = 0; i < length; ++i) {
+        samples_i_[i] = samples[i].real();
+        samples_q_[i] = samples[i].imag();
+    }
+
+    generateCarrier(carrier_phase, carrier_freq, length, carrier_i_, carrier_q_);
+
+    // One extended replica; early leads the prompt view, late lags it
+    code_nco_.setPhase(code_phase);
+    code_nco_.generate(length);
+
+    CorrelationResult result;
+    correlateSIMD(samples_i_.data(), samples_q_.data(), code_nco_.early(),
+                  carrier_i_.data(), carrier_q_.data(), length, result.early);
+    correlateSIMD(samples_i_.data(), samples_q_.data(), code_nco_.prompt(),
+                  carrier_i_.data(), carrier_q_.data(), length, result.prompt);
+    correlateSIMD(samples_i_.data(), samples_q_.data(), code_nco_.late(),
+                  carrier_i_.data(), carrier_q_.data(), length, result.late);
+
+    result.power_early = std::norm(result.early);
+    result.power_prompt = std::norm(result.prompt);
+    result.power_late = std::norm(result.late);
+    return result;
+}
+
+CorrelationResult Correlator::correlate(const IQSample8* samples,
+                                        size_t length,
+                                        double code_phase,
+                                        double carrier_phase,
+                                        double carrier_freq) {
+    generateCarrier8(carrier_phase, carrier_freq, length);
+
+    code_nco_.setPhase(code_phase);
+    code_nco_.generate8(length);
+
+    const int8_t* raw = reinterpret_cast<const int8_t*>(samples);
+    const float scale = 1.0f / (INT8_SAMPLE_SCALE * INT8_CARRIER_SCALE);
+
+    static const CorrelateInt8Kernel kernel = kCorrelateInt8Kernels.select();
+    auto run = [&](const int8_t* code) {
+        int32_t corr_i = 0;
+        int32_t corr_q = 0;
+        kernel(raw, code, carrier_re8_.data(), carrier_im8_.data(),
+               length, corr_i, corr_q);
+        return std::complex<float>(corr_i * scale, corr_q * scale);
+    };
+
+    CorrelationResult result;
+    result.early = run(code_nco_.early8());
+    result.prompt = run(code_nco_.prompt8());
+    result.late = run(code_nco_.late8());
+
+    result.power_early = std::norm(result.early);
+    result.power_prompt = std::norm(result.prompt);
+    result.power_late = std::norm(result.late);
+    return result;
+}
+
+void Correlator::correlateSIMD(const float* samples_i,
+                               const float* samples_q,
+                               const float* code,
+                               const float* carrier_i,
+                               const float* carrier_q,
+                               size_t length,
+                               std::complex<float>& result) {
+    float corr_i = 0.0f;
+    float corr_q = 0.0f;
+    static const CorrelateKernel kernel = kCorrelateKernels.select();
+    kernel(samples_i, samples_q, code, carrier_i, carrier_q, length, corr_i, corr_q);
+    result = std::complex<float>(corr_i, corr_q);
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,693 @@
+#include "tracking/gps_tracker.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <utility>
+
+namespace gps {
+
+namespace {
+
+// Second-order loop filter coefficients, tau1 = k / wn^2 and tau2 = 2 zeta / wn
+struct LoopCoefficients {
+    double tau1;
+    double tau2;
+};
+
+LoopCoefficients loopCoefficients(double bandwidth, double zeta, double gain) {
+    const double wn = bandwidth * 8.0 * zeta / (4.0 * zeta * zeta + 1.0);
+    return {gain / (wn * wn), 2.0 * zeta / wn};
+}
+
+constexpr double LOOP_DAMPING = 0.7;
+constexpr double PLL_GAIN = 0.25;
+constexpr double DLL_GAIN = 1.0;
+constexpr double FLL_GAIN = 0.1;
+
+inline bool sameState(const SatelliteInfo& a, const SatelliteInfo& b) {
+    return a.prn == b.prn && a.doppler_shift == b.doppler_shift && a.code_phase == b.code_phase
+        && a.carrier_phase == b.carrier_phase && a.cn0 == b.cn0
+        && a.is_tracked == b.is_tracked && a.has_ephemeris == b.has_ephemeris;
+}
+
+inline bool validPRN(int prn) {
+    return prn >= 1 && prn <= GPS_MAX_SATELLITES;
+}
+
+inline double wrapCodePhase(double chips) {
+    chips = std::fmod(chips, static_cast<double>(GPS_CA_CODE_LENGTH));
+    return chips < 0.0 ? chips + GPS_CA_CODE_LENGTH : chips;
+}
+
+}
+
+TrackingChannel::TrackingChannel(int prn, double sample_rate)
+    : state_(ChannelState::IDLE)
+    , sat_info_{}
+    , correlator_(std::make_unique<Correlator>(prn, sample_rate))
+    , carrier_freq_(0.0)
+    , carrier_phase_(0.0)
+    , code_freq_(GPS_CA_CODE_FREQ_HZ)
+    , epoch_sample_(0)
+    , epoch_fraction_(0.0)
+    , span_{0, 0}
+    , replica_{prn, 0.0, GPS_CA_CODE_FREQ_HZ, 0.0, 0.0}
+    , pll_nco_(0.0)
+    , dll_nco_(0.0)
+    , carrier_freq_basis_(0.0)
+    , last_phase_error_(0.0)
+    , last_code_error_(0.0)
+    , last_prompt_(0.0f, 0.0f)
+    , bit_sync_counter_(0)
+    , bit_transitions_{}
+    , bit_edge_(-1)
+    , bit_sum_(0.0f)
+    , tracked_ms_(0)
+    , acquisition_holdoff_(0)
+    , acquisition_enabled_(true)
+    , doppler_hint_(0.0)
+    , doppler_uncertainty_(0.0)
+    , sample_rate_(sample_rate)
+    , prn_(prn) {
+    if (prn < 1 || prn > GPS_MAX_SATELLITES) {
+        throw std::invalid_argument("Invalid PRN number");
+    }
+    sat_info_.prn = prn;
+}
+
+TrackingChannel::~TrackingChannel() = default;
+
+void TrackingChannel::startAcquisition(const IQBuffer& samples, uint64_t first_sample) {
+    state_ = ChannelState::ACQUIRING;
+    performAcquisition(samples, first_sample);
+}
+
+bool TrackingChannel::readyForAcquisition() {
+    if (state_ == ChannelState::TRACKING) {
+        return false;
+    }
+    if (acquisition_holdoff_ > 0) {
+        --acquisition_holdoff_;
+        return false;
+    }
+    return acquisition_enabled_;
+}
+
+void TrackingChannel::setDopplerHint(double doppler, double uncertainty) {
+    doppler_hint_ = doppler;
+    doppler_uncertainty_ = std::max(0.0, uncertainty);
+}
+
+bool TrackingChannel::performAcquisition(const IQBuffer& samples, uint64_t first_sample) {
+    double doppler_min = -DOPPLER_SEARCH_RANGE;
+    double doppler_max = DOPPLER_SEARCH_RANGE;
+    if (hasDopplerHint()) {
+        doppler_min = std::max(doppler_min, doppler_hint_ - doppler_uncertainty_);
+        doppler_max = std::min(doppler_max, doppler_hint_ + doppler_uncertainty_);
+    }
+    SignalAcquisition acquisition(sample_rate_);
+    AcquisitionResult result = acquisition.searchSatellite(
+        samples, prn_, doppler_min, doppler_max, DOPPLER_SEARCH_STEP / 2.0);
+    return handoff(result, first_sample);
+}
+
+bool TrackingChannel::handoff(const AcquisitionResult& result, uint64_t first_sample) {
+    // A hint is good for one search
+    const bool hinted = hasDopplerHint();
+    doppler_uncertainty_ = 0.0;
+
+    if (!result.found || result.prn != prn_) {
+        state_ = ChannelState::IDLE;
+        // A narrow search that missed goes straight on to a full one
+        acquisition_holdoff_ = hinted ? 0 : ACQUISITION_RETRY_MS;
+        return false;
+    }
+
+    carrier_freq_ = result.doppler_shift;
+    carrier_freq_basis_ = result.doppler_shift;
+    carrier_phase_ = 0.0;
+    code_freq_ = GPS_CA_CODE_FREQ_HZ * (1.0 + carrier_freq_ / GPS_L1_FREQ_HZ);
+
+    // Tracking starts at the first code epoch in the block searched
+    const double code_phase = wrapCodePhase(result.code_phase);
+    epoch_sample_ = first_sample;
+    epoch_fraction_ = 0.0;
+    if (code_phase > 0.0) {
+        advanceEpoch((GPS_CA_CODE_LENGTH - code_phase) / code_freq_ * sample_rate_);
+    }
+
+    pll_nco_ = 0.0;
+    dll_nco_ = 0.0;
+    last_phase_error_ = 0.0;
+    last_code_error_ = 0.0;
+    last_prompt_ = std::complex<float>(0.0f, 0.0f);
+    correlation_history_.clear();
+    bit_sync_counter_ = 0;
+    bit_transitions_.fill(0);
+    bit_edge_ = -1;
+    bit_sum_ = 0.0f;
+    nav_bits_.clear();
+    tracked_ms_ = 0;
+
+    sat_info_.doppler_shift = carrier_freq_;
+    sat_info_.code_phase = code_phase;
+    sat_info_.carrier_phase = carrier_phase_;
+    sat_info_.cn0 = 0.0;
+    sat_info_.is_tracked = true;
+    state_ = ChannelState::TRACKING;
+    return true;
+}
+
+void TrackingChannel::advanceEpoch(double samples) {
+    carrier_phase_ = std::fmod(carrier_phase_ + 2.0 * M_PI * carrier_freq_ * samples / sample_rate_,
+                               2.0 * M_PI);
+    epoch_fraction_ += samples;
+    const double whole = std::floor(epoch_fraction_);
+    epoch_sample_ += static_cast<uint64_t>(whole);
+    epoch_fraction_ -= whole;
+}
+
+bool TrackingChannel::prepareSpan(uint64_t window_begin, uint64_t window_end) {
+    if (state_ != ChannelState::TRACKING) {
+        return false;
+    }
+
+    const double period = GPS_CA_CODE_LENGTH / code_freq_ * sample_rate_;
+    uint64_t first = epoch_sample_ + (epoch_fraction_ > 0.0 ? 1 : 0);
+    while (first < window_begin) {
+        advanceEpoch(period);
+        first = epoch_sample_ + (epoch_fraction_ > 0.0 ? 1 : 0);
+    }
+
+    // Reported code phase is at the end of the window, the next block
+    const double since_epoch = static_cast<double>(static_cast<int64_t>(window_end - epoch_sample_))
+                             - epoch_fraction_;
+    sat_info_.code_phase = wrapCodePhase(since_epoch * code_freq_ / sample_rate_);
+
+    // The period ends before the first sample at or after the next epoch
+    const uint64_t last = epoch_sample_ + static_cast<uint64_t>(std::ceil(epoch_fraction_ + period));
+    if (last > window_end) {
+        return false;
+    }
+
+    // Replica at the first sample, a fraction of a sample past the epoch
+    const double lead = static_cast<double>(first - epoch_sample_) - epoch_fraction_;
+    span_ = {static_cast<size_t>(first - window_begin), static_cast<size_t>(last - first)};
+    replica_ = {prn_, lead * code_freq_ / sample_rate_, code_freq_,
+                std::fmod(carrier_phase_ + 2.0 * M_PI * carrier_freq_ * lead / sample_rate_, 2.0 * M_PI),
+                carrier_freq_};
+    return true;
+}
+
+void TrackingChannel::updateTracking(const IQSample* window) {
+    if (state_ != ChannelState::TRACKING) {
+        return;
+    }
+    CorrelationResult result = correlator_->correlate(window + span_.offset, span_.length,
+                                                      replica_.code_phase, replica_.carrier_phase,
+                                                      replica_.carrier_freq);
+    applyCorrelation(result);
+}
+
+void TrackingChannel::updateTracking(const IQSample8* window) {
+    if (state_ != ChannelState::TRACKING) {
+        return;
+    }
+    CorrelationResult result = correlator_->correlate(window + span_.offset, span_.length,
+                                                      replica_.code_phase, replica_.carrier_phase,
+                                                      replica_.carrier_freq);
+    applyCorrelation(result);
+}
+
+size_t TrackingChannel::trackBatch(const IQSample* window, uint64_t window_begin,
+                                   uint64_t window_end, MultiChannelCorrelator& correlator) {
+    const size_t length = static_cast<size_t>(window_end - window_begin);
+    size_t count = 0;
+    while (prepareSpan(window_begin, window_end)) {
+        const CorrelationResult result = correlator.correlate(window, length, replica_, span_);
+        applyCorrelation(result);
+        epochs_.push_back({prn_, window_begin + span_.offset, result.early, result.prompt,
+                           result.late, carrier_freq_, code_freq_,
+                           static_cast<float>(carrier_phase_), static_cast<float>(sat_info_.cn0)});
+        ++count;
+    }
+    return count;
+}
+
+void TrackingChannel::applyCorrelation(const CorrelationResult& result) {
+    if (state_ != ChannelState::TRACKING) {
+        return;
+    }
+
+    // On to the next code epoch, at the rate the period was tracked with
+    const uint64_t period_start = epoch_sample_;
+    advanceEpoch(GPS_CA_CODE_LENGTH / replica_.code_rate * sample_rate_);
+
+    if (tracked_ms_ < FLL_PULL_IN_MS) {
+        updateFLL(result.prompt);
+        if (tracked_ms_ + 1 == FLL_PULL_IN_MS) {
+            carrier_freq_basis_ = carrier_freq_;
+            pll_nco_ = 0.0;
+            last_phase_error_ = 0.0;
+        }
+    } else {
+        updatePLL(calculatePhaseError(result.prompt));
+        updateBitSync(result.prompt.real(), period_start);
+    }
+    updateDLL(calculateCodeError(result.early, result.prompt, result.late));
+    updateLockDetector(result.prompt);
+
+    last_prompt_ = result.prompt;
+    ++tracked_ms_;
+
+    sat_info_.doppler_shift = carrier_freq_;
+    sat_info_.carrier_phase = carrier_phase_;
+}
+
+double TrackingChannel::calculatePhaseError(std::complex<float> prompt) {
+    // Costas discriminator, insensitive to data bit flips (cycles)
+    if (prompt.real() == 0.0f) {
+        return 0.0;
+    }
+    return std::atan(prompt.imag() / prompt.real()) / (2.0 * M_PI);
+}
+
+double TrackingChannel::calculateCodeError(std::complex<float> early,
+                                           std::complex<float> prompt,
+                                           std::complex<float> late) {
+    (void)prompt;
+    const double e = std::abs(early);
+    const double l = std::abs(late);
+    if (e + l == 0.0) {
+        return 0.0;
+    }
+    return (e - l) / (e + l);
+}
+
+void TrackingChannel::updateFLL(std::complex<float> prompt) {
+    if (last_prompt_ == std::complex<float>(0.0f, 0.0f)) {
+        return;
+    }
+    // Cross/dot discriminator; atan keeps it blind to bit transitions
+    const double dot = last_prompt_.real() * prompt.real() + last_prompt_.imag() * prompt.imag();
+    const double cross = last_prompt_.real() * prompt.imag() - last_prompt_.imag() * prompt.real();
+    if (dot == 0.0) {
+        return;
+    }
+    const double freq_error = std::atan(cross / dot) / (2.0 * M_PI * TRACKING_INTEGRATION_TIME);
+    carrier_freq_ += FLL_GAIN * freq_error;
+    code_freq_ = GPS_CA_CODE_FREQ_HZ * (1.0 + carrier_freq_ / GPS_L1_FREQ_HZ) + dll_nco_;
+}
+
+void TrackingChannel::updatePLL(double phase_error) {
+    static const LoopCoefficients coeff = loopCoefficients(PLL_BANDWIDTH, LOOP_DAMPING, PLL_GAIN);
+    pll_nco_ += coeff.tau2 / coeff.tau1 * (phase_error - last_phase_error_)
+              + phase_error * (TRACKING_INTEGRATION_TIME / coeff.tau1);
+    last_phase_error_ = phase_error;
+    carrier_freq_ = carrier_freq_basis_ + pll_nco_;
+}
+
+void TrackingChannel::updateDLL(double code_error) {
+    static const LoopCoefficients coeff = loopCoefficients(DLL_BANDWIDTH, LOOP_DAMPING, DLL_GAIN);
+    dll_nco_ += coeff.tau2 / coeff.tau1 * (code_error - last_code_error_)
+              + code_error * (TRACKING_INTEGRATION_TIME / coeff.tau1);
+    last_code_error_ = code_error;
+
+    // Early leads the prompt: a stronger early arm means the replica lags
+    code_freq_ = GPS_CA_CODE_FREQ_HZ * (1.0 + carrier_freq_ / GPS_L1_FREQ_HZ) + dll_nco_;
+}
+
+void TrackingChannel::updateLockDetector(std::complex<float> prompt) {
+    correlation_history_.push_back(std::norm(prompt));
+    if (correlation_history_.size() < static_cast<size_t>(CN0_WINDOW_MS)) {
+        return;
+    }
+
+    // Moment method: signal power from the spread of the prompt power
+    double m2 = 0.0;
+    double m4 = 0.0;
+    for (double p : correlation_history_) {
+        m2 += p;
+        m4 += p * p;
+    }
+    m2 /= correlation_history_.size();
+    m4 /= correlation_history_.size();
+    correlation_history_.clear();
+
+    const double signal = std::sqrt(std::max(0.0, 2.0 * m2 * m2 - m4));
+    const double noise = m2 - signal;
+    if (signal > 0.0 && noise > 0.0) {
+        sat_info_.cn0 = 10.0 * std::log10(signal / noise / TRACKING_INTEGRATION_TIME);
+    } else {
+        sat_info_.cn0 = 0.0;
+    }
+
+    if (tracked_ms_ >= FLL_PULL_IN_MS && sat_info_.cn0 < CN0_LOSS_THRESHOLD) {
+        state_ = ChannelState::LOST;
+        sat_info_.is_tracked = false;
+        acquisition_holdoff_ = 0;
+    }
+}
+
+void TrackingChannel::updateBitSync(float prompt_i, uint64_t period_start) {
+    const int ms = bit_sync_counter_++;
+
+    if (bit_edge_ < 0) {
+        if ((prompt_i < 0.0f) != (last_prompt_.real() < 0.0f)) {
+            ++bit_transitions_[ms % 20];
+        }
+        if (ms + 1 >= BIT_SYNC_MS) {
+            auto best = std::max_element(bit_transitions_.begin(), bit_transitions_.end());
+            if (*best > 0) {
+                bit_edge_ = static_cast<int>(best - bit_transitions_.begin());
+            }
+            bit_transitions_.fill(0);
+            bit_sync_counter_ = 0;
+            bit_sum_ = 0.0f;
+        }
+        return;
+    }
+
+    if (ms % 20 == bit_edge_ && bit_sum_ != 0.0f) {
+        nav_bits_.push_back(NavigationBit{bit_sum_ > 0.0f, period_start});
+        bit_sum_ = 0.0f;
+    }
+    bit_sum_ += prompt_i;
+}
+
+bool TrackingChannel::hasNavigationBit() const {
+    return !nav_bits_.empty();
+}
+
+NavigationBit TrackingChannel::getNavigationBit() {
+    if (nav_bits_.empty()) {
+        return NavigationBit{false, 0};
+    }
+    NavigationBit bit = nav_bits_.front();
+    nav_bits_.pop_front();
+    return bit;
+}
+
+GPSTracker::GPSTracker(double sample_rate, const TrackingSchedulerConfig& scheduler_config)
+    : scheduler_config_(scheduler_config)
+    , period_samples_(static_cast<size_t>(std::ceil(sample_rate * TRACKING_INTEGRATION_TIME)))
+    , acquisition_(std::make_unique<SignalAcquisition>(sample_rate))
+    , is_running_(false)
+    , published_{}
+    , sample_rate_(sample_rate) {
+}
+
+GPSTracker::~GPSTracker() {
+    stopTracking();
+}
+
+void GPSTracker::initialize(const std::vector<int>& prn_list) {
+    channels_.clear();
+    for (int prn : prn_list) {
+        channels_.push_back(std::make_unique<TrackingChannel>(prn, sample_rate_));
+        published_[prn] = channels_.back()->getSatelliteInfo();
+        snapshots_[prn].info.store(published_[prn]);
+    }
+    acquisition_->setNonCoherentBlocks(ACQUISITION_DWELL_BLOCKS);
+    searching_channels_.clear();
+}
+
+void GPSTracker::startTracking() {
+    if (!scheduler_) {
+        scheduler_ = std::make_unique<TrackingScheduler>(sample_rate_, scheduler_config_);
+    }
+    is_running_ = true;
+}
+
+void GPSTracker::stopTracking() {
+    is_running_ = false;
+    scheduler_.reset();
+}
+
+void GPSTracker::distributesamples(const IQBuffer& samples, uint64_t first_sample) {
+    // Hold-offs tick every block; due channels join the next dwell
+    const bool start_dwell = searching_channels_.empty();
+    bool hinted = false;
+    for (auto& channel : channels_) {
+        if (channel->readyForAcquisition() && start_dwell) {
+            searching_channels_.push_back(channel.get());
+            hinted = hinted || channel->hasDopplerHint();
+        }
+    }
+    if (start_dwell) {
+        if (searching_channels_.empty()) {
+            return;
+        }
+
+        // Hinted channels go first, each over its own window; the others
+        // wait for the next dwell
+        if (hinted) {
+            searching_channels_.erase(
+                std::remove_if(searching_channels_.begin(), searching_channels_.end(),
+                               [](const TrackingChannel* channel) { return !channel->hasDopplerHint(); }),
+                searching_channels_.end());
+        }
+
+        std::vector<int> prns;
+        std::vector<DopplerWindow> windows;
+        for (const TrackingChannel* channel : searching_channels_) {
+            DopplerWindow window{-static_cast<double>(DOPPLER_SEARCH_RANGE),
+                                 static_cast<double>(DOPPLER_SEARCH_RANGE)};
+            if (channel->hasDopplerHint()) {
+                window.min = std::max(window.min, channel->getDopplerHint() - channel->getDopplerUncertainty());
+                window.max = std::min(window.max, channel->getDopplerHint() + channel->getDopplerUncertainty());
+            }
+            prns.push_back(channel->getPRN());
+            windows.push_back(window);
+        }
+        // Half-width bins keep the start-up error inside the FLL pull-in range
+        acquisition_->beginDwell(prns, windows, DOPPLER_SEARCH_STEP / 2.0);
+    }
+
+    if (samples.size() < acquisition_->getBlockSize()) {
+        return;
+    }
+    if (!acquisition_->accumulateBlock(samples)) {
+        return;
+    }
+
+    // Results are in dwell order, which is searching_channels_ order
+    std::vector<AcquisitionResult> results = acquisition_->getDwellResults();
+    for (size_t i = 0; i < searching_channels_.size() && i < results.size(); ++i) {
+        searching_channels_[i]->handoff(results[i], first_sample);
+    }
+    searching_channels_.clear();
+}
+
+bool GPSTracker::prepareChannels(uint64_t window_begin, uint64_t window_end) {
+    active_channels_.clear();
+    for (auto& channel : channels_) {
+        if (channel->prepareSpan(window_begin, window_end)) {
+            active_channels_.push_back(channel.get());
+        }
+    }
+    return !active_channels_.empty();
+}
+
+void GPSTracker::processSamples(const IQBuffer& samples) {
+    if (!is_running_ || samples.empty()) {
+        return;
+    }
+
+    history_.reserve(samples.size() + HISTORY_PERIODS * period_samples_);
+    history_.append(samples.data(), samples.size());
+
+    // A block completes no code period of a channel, one, or now and then two
+    while (prepareChannels(history_.begin(), history_.end())) {
+        // Taps use the period each channel is about to be tracked with
+        for (auto& monitor : tap_monitors_) {
+            for (TrackingChannel* channel : active_channels_) {
+                if (channel->getPRN() == monitor.prn) {
+                    const ChannelSpan& span = channel->getSpan();
+                    monitor.correlator->correlate(history_.data() + span.offset, span.length,
+                                                  channel->getReplica(), monitor.taps);
+                    monitor.valid = true;
+                }
+            }
+        }
+
+        scheduler_->runEpoch(history_.data(), history_.size(), active_channels_);
+    }
+
+    distributesamples(samples, history_.end() - samples.size());
+    publishSnapshots();
+}
+
+void GPSTracker::trackHistory() {
+    active_channels_.clear();
+    for (auto& channel : channels_) {
+        if (channel->getState() == ChannelState::TRACKING) {
+            active_channels_.push_back(channel.get());
+        }
+    }
+    scheduler_->runBatch(history_.data(), history_.size(), history_.begin(), active_channels_);
+}
+
+void GPSTracker::processBatch(const IQSample* samples, size_t num_samples,
+                              std::vector<TrackingEpoch>& epochs) {
+    epochs.clear();
+    if (!is_running_ || num_samples == 0) {
+        return;
+    }
+
+    history_.reserve(num_samples + HISTORY_PERIODS * period_samples_);
+    history_.append(samples, num_samples);
+    const uint64_t first_sample = history_.end() - num_samples;
+
+    for (auto& channel : channels_) {
+        channel->clearEpochs();
+    }
+    // Taps from before the span no longer describe the channel
+    for (auto& monitor : tap_monitors_) {
+        monitor.valid = false;
+    }
+    trackHistory();
+
+    // The dwell still takes one block at a time
+    bool searching = false;
+    for (auto& channel : channels_) {
+        searching = searching || channel->getState() != ChannelState::TRACKING;
+    }
+    if (searching) {
+        const size_t block = acquisition_->getBlockSize();
+        for (size_t start = 0; start + block <= num_samples; start += block) {
+            acquisition_buffer_.assign(samples + start, samples + start + block);
+            distributesamples(acquisition_buffer_, first_sample + start);
+        }
+        trackHistory();
+    }
+
+    publishSnapshots();
+
+    for (const auto& channel : channels_) {
+        const std::vector<TrackingEpoch>& channel_epochs = channel->getEpochs();
+        epochs.insert(epochs.end(), channel_epochs.begin(), channel_epochs.end());
+    }
+}
+
+void GPSTracker::processSamples(const IQSample8* samples, size_t num_samples) {
+    if (!is_running_ || num_samples == 0) {
+        return;
+    }
+
+    history8_.reserve(num_samples + HISTORY_PERIODS * period_samples_);
+    history8_.append(samples, num_samples);
+
+    while (prepareChannels(history8_.begin(), history8_.end())) {
+        scheduler_->runEpoch(history8_.data(), history8_.size(), active_channels_);
+    }
+
+    // Acquisition still runs on float samples
+    bool searching = false;
+    for (auto& channel : channels_) {
+        searching = searching || channel->getState() != ChannelState::TRACKING;
+    }
+    if (searching) {
+        acquisition_buffer_.resize(num_samples);
+        for (size_t i = 0; i < num_samples; ++i) {
+            acquisition_buffer_[i] = IQSample(samples[i].i / INT8_SAMPLE_SCALE,
+                                              samples[i].q / INT8_SAMPLE_SCALE);
+        }
+        distributesamples(acquisition_buffer_, history8_.end() - num_samples);
+    }
+    publishSnapshots();
+}
+
+void GPSTracker::publishSnapshots() {
+    for (const auto& channel : channels_) {
+        const SatelliteInfo info = channel->getSatelliteInfo();
+        SatelliteInfo& published = published_[info.prn];
+        if (!sameState(info, published)) {
+            published = info;
+            snapshots_[info.prn].info.store(info);
+        }
+
+        // A bit every 20 ms; without a handler they are dropped, not queued
+        while (channel->hasNavigationBit()) {
+            const NavigationBit bit = channel->getNavigationBit();
+            if (nav_bit_handler_) {
+                nav_bit_handler_(info.prn, bit.value, bit.end_sample / sample_rate_);
+            }
+        }
+    }
+}
+
+uint64_t GPSTracker::readState(int prn, SatelliteInfo& info) const {
+    if (!validPRN(prn) || snapshots_[prn].info.version() == 0) {
+        return 0;
+    }
+    return snapshots_[prn].info.load(info);
+}
+
+uint64_t GPSTracker::getStateVersion(int prn) const {
+    return validPRN(prn) ? snapshots_[prn].info.version() : 0;
+}
+
+std::vector<SatelliteInfo> GPSTracker::getTrackedSatellites() const {
+    std::vector<SatelliteInfo> satellites;
+    satellites.reserve(channels_.size());
+    for (const auto& channel : channels_) {
+        satellites.push_back(channel->getSatelliteInfo());
+    }
+    return satellites;
+}
+
+void GPSTracker::setTapMonitor(int prn, const MultiTapConfig& config) {
+    clearTapMonitor(prn);
+    tap_monitors_.push_back(TapMonitor{prn, std::make_unique<MultiTapCorrelator>(sample_rate_, config),
+                                       TapCorrelation{}, false});
+}
+
+void GPSTracker::clearTapMonitor(int prn) {
+    tap_monitors_.erase(std::remove_if(tap_monitors_.begin(), tap_monitors_.end(),
+                                       [prn](const TapMonitor& monitor) { return monitor.prn == prn; }),
+                        tap_monitors_.end());
+}
+
+bool GPSTracker::getTapCorrelation(int prn, TapCorrelation& taps) const {
+    for (const auto& monitor : tap_monitors_) {
+        if (monitor.prn == prn && monitor.valid) {
+            taps = monitor.taps;
+            return true;
+        }
+    }
+    return false;
+}
+
+void GPSTracker::setNavigationBitHandler(NavigationBitHandler handler) {
+    nav_bit_handler_ = std::move(handler);
+}
+
+void GPSTracker::setDopplerHint(int prn, double doppler, double uncertainty) {
+    for (auto& channel : channels_) {
+        if (channel->getPRN() == prn) {
+            channel->setDopplerHint(doppler, uncertainty);
+        }
+    }
+}
+
+bool GPSTracker::getDopplerHint(int prn, double& doppler, double& uncertainty) const {
+    for (const auto& channel : channels_) {
+        if (channel->getPRN() == prn && channel->hasDopplerHint()) {
+            doppler = channel->getDopplerHint();
+            uncertainty = channel->getDopplerUncertainty();
+            return true;
+        }
+    }
+    return false;
+}
+
+void GPSTracker::setAcquisitionEnabled(int prn, bool enable) {
+    for (auto& channel : channels_) {
+        if (channel->getPRN() == prn) {
+            channel->setAcquisitionEnabled(enable);
+        }
+    }
+}
+
+}
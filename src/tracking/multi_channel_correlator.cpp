@@ -0,0 +1,356 @@
+#include "tracking/multi_channel_correlator.h"
+#include <immintrin.h>
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace gps {
+
+namespace {
+
+using AccumulateKernel = void (*)(const float*, const float*, const float*, const float*,
+                                  const float*, const float*, const float*, size_t, float*);
+
+// Per-sample tail shared by every tier
+inline void accumulateTail(const float* __restrict__ samples_i,
+                           const float* __restrict__ samples_q,
+                           const float* __restrict__ carrier_i,
+                           const float* __restrict__ carrier_q,
+                           const float* __restrict__ early,
+                           const float* __restrict__ prompt,
+                           const float* __restrict__ late,
+                           size_t begin,
+                           size_t end,
+                           float acc[6]) {
+    for (size_t i = begin; i < end; ++i) {
+        const float mi = samples_i[i] * carrier_i[i] + samples_q[i] * carrier_q[i];
+        const float mq = samples_q[i] * carrier_i[i] - samples_i[i] * carrier_q[i];
+        acc[0] += mi * early[i];
+        acc[1] += mq * early[i];
+        acc[2] += mi * prompt[i];
+        acc[3] += mq * prompt[i];
+        acc[4] += mi * late[i];
+        acc[5] += mq * late[i];
+    }
+}
+
+void accumulateEPLScalar(const float* __restrict__ samples_i,
+                         const float* __restrict__ samples_q,
+                         const float* __restrict__ carrier_i,
+                         const float* __restrict__ carrier_q,
+                         const float* __restrict__ early,
+                         const float* __restrict__ prompt,
+                         const float* __restrict__ late,
+                         size_t length,
+                         float acc[6]) {
+    accumulateTail(samples_i, samples_q, carrier_i, carrier_q, early, prompt, late,
+                   0, length, acc);
+}
+
+GPS_TARGET_SSE4
+inline float horizontalSum(__m128 v) {
+    v = _mm_hadd_ps(v, v);
+    v = _mm_hadd_ps(v, v);
+    return _mm_cvtss_f32(v);
+}
+
+GPS_TARGET_SSE4
+void accumulateEPLSSE4(const float* __restrict__ samples_i,
+                       const float* __restrict__ samples_q,
+                       const float* __restrict__ carrier_i,
+                       const float* __restrict__ carrier_q,
+                       const float* __restrict__ early,
+                       const float* __restrict__ prompt,
+                       const float* __restrict__ late,
+                       size_t length,
+                       float acc[6]) {
+    __m128 e_i = _mm_setzero_ps();
+    __m128 e_q = _mm_setzero_ps();
+    __m128 p_i = _mm_setzero_ps();
+    __m128 p_q = _mm_setzero_ps();
+    __m128 l_i = _mm_setzero_ps();
+    __m128 l_q = _mm_setzero_ps();
+
+    size_t simd_length = length & ~static_cast<size_t>(3);
+    for (size_t i = 0; i < simd_length; i += 4) {
+        __m128 si = _mm_loadu_ps(&samples_i[i]);
+        __m128 sq = _mm_loadu_ps(&samples_q[i]);
+        __m128 ci = _mm_loadu_ps(&carrier_i[i]);
+        __m128 cq = _mm_loadu_ps(&carrier_q[i]);
+
+        __m128 mi = _mm_add_ps(_mm_mul_ps(si, ci), _mm_mul_ps(sq, cq));
+        __m128 mq = _mm_sub_ps(_mm_mul_ps(sq, ci), _mm_mul_ps(si, cq));
+        __m128 ce = _mm_loadu_ps(&early[i]);
+        __m128 cp = _mm_loadu_ps(&prompt[i]);
+        __m128 cl = _mm_loadu_ps(&late[i]);
+
+        e_i = _mm_add_ps(e_i, _mm_mul_ps(mi, ce));
+        e_q = _mm_add_ps(e_q, _mm_mul_ps(mq, ce));
+        p_i = _mm_add_ps(p_i, _mm_mul_ps(mi, cp));
+        p_q = _mm_add_ps(p_q, _mm_mul_ps(mq, cp));
+        l_i = _mm_add_ps(l_i, _mm_mul_ps(mi, cl));
+        l_q = _mm_add_ps(l_q, _mm_mul_ps(mq, cl));
+    }
+
+    acc[0] += horizontalSum(e_i);
+    acc[1] += horizontalSum(e_q);
+    acc[2] += horizontalSum(p_i);
+    acc[3] += horizontalSum(p_q);
+    acc[4] += horizontalSum(l_i);
+    acc[5] += horizontalSum(l_q);
+
+    accumulateTail(samples_i, samples_q, carrier_i, carrier_q, early, prompt, late,
+                   simd_length, length, acc);
+}
+
+GPS_TARGET_AVX2
+inline float horizontalSum(__m256 v) {
+    __m128 sum = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+    sum = _mm_hadd_ps(sum, sum);
+    sum = _mm_hadd_ps(sum, sum);
+    return _mm_cvtss_f32(sum);
+}
+
+// Carrier wipe-off in registers, then six accumulators from the one mix
+GPS_TARGET_AVX2
+void accumulateEPLAVX2(const float* __restrict__ samples_i,
+                       const float* __restrict__ samples_q,
+                       const float* __restrict__ carrier_i,
+                       const float* __restrict__ carrier_q,
+                       const float* __restrict__ early,
+                       const float* __restrict__ prompt,
+                       const float* __restrict__ late,
+                       size_t length,
+                       float acc[6]) {
+    __m256 e_i = _mm256_setzero_ps();
+    __m256 e_q = _mm256_setzero_ps();
+    __m256 p_i = _mm256_setzero_ps();
+    __m256 p_q = _mm256_setzero_ps();
+    __m256 l_i = _mm256_setzero_ps();
+    __m256 l_q = _mm256_setzero_ps();
+
+    size_t simd_length = length & ~static_cast<size_t>(7);
+    for (size_t i = 0; i < simd_length; i += 8) {
+        __m256 si = _mm256_loadu_ps(&samples_i[i]);
+        __m256 sq = _mm256_loadu_ps(&samples_q[i]);
+        __m256 ci = _mm256_loadu_ps(&carrier_i[i]);
+        __m256 cq = _mm256_loadu_ps(&carrier_q[i]);
+
+        // Sample times conj(carrier)
+        __m256 mi = _mm256_fmadd_ps(si, ci, _mm256_mul_ps(sq, cq));
+        __m256 mq = _mm256_fmsub_ps(sq, ci, _mm256_mul_ps(si, cq));
+        __m256 ce = _mm256_loadu_ps(&early[i]);
+        __m256 cp = _mm256_loadu_ps(&prompt[i]);
+        __m256 cl = _mm256_loadu_ps(&late[i]);
+
+        e_i = _mm256_fmadd_ps(mi, ce, e_i);
+        e_q = _mm256_fmadd_ps(mq, ce, e_q);
+        p_i = _mm256_fmadd_ps(mi, cp, p_i);
+        p_q = _mm256_fmadd_ps(mq, cp, p_q);
+        l_i = _mm256_fmadd_ps(mi, cl, l_i);
+        l_q = _mm256_fmadd_ps(mq, cl, l_q);
+    }
+
+    acc[0] += horizontalSum(e_i);
+    acc[1] += horizontalSum(e_q);
+    acc[2] += horizontalSum(p_i);
+    acc[3] += horizontalSum(p_q);
+    acc[4] += horizontalSum(l_i);
+    acc[5] += horizontalSum(l_q);
+
+    accumulateTail(samples_i, samples_q, carrier_i, carrier_q, early, prompt, late,
+                   simd_length, length, acc);
+}
+
+GPS_AVX512_BEGIN
+GPS_TARGET_AVX512
+void accumulateEPLAVX512(const float* __restrict__ samples_i,
+                         const float* __restrict__ samples_q,
+                         const float* __restrict__ carrier_i,
+                         const float* __restrict__ carrier_q,
+                         const float* __restrict__ early,
+                         const float* __restrict__ prompt,
+                         const float* __restrict__ late,
+                         size_t length,
+                         float acc[6]) {
+    __m512 e_i = _mm512_setzero_ps();
+    __m512 e_q = _mm512_setzero_ps();
+    __m512 p_i = _mm512_setzero_ps();
+    __m512 p_q = _mm512_setzero_ps();
+    __m512 l_i = _mm512_setzero_ps();
+    __m512 l_q = _mm512_setzero_ps();
+
+    size_t simd_length = length & ~static_cast<size_t>(15);
+    for (size_t i = 0; i < simd_length; i += 16) {
+        __m512 si = _mm512_loadu_ps(&samples_i[i]);
+        __m512 sq = _mm512_loadu_ps(&samples_q[i]);
+        __m512 ci = _mm512_loadu_ps(&carrier_i[i]);
+        __m512 cq = _mm512_loadu_ps(&carrier_q[i]);
+
+        __m512 mi = _mm512_fmadd_ps(si, ci, _mm512_mul_ps(sq, cq));
+        __m512 mq = _mm512_fmsub_ps(sq, ci, _mm512_mul_ps(si, cq));
+        __m512 ce = _mm512_loadu_ps(&early[i]);
+        __m512 cp = _mm512_loadu_ps(&prompt[i]);
+        __m512 cl = _mm512_loadu_ps(&late[i]);
+
+        e_i = _mm512_fmadd_ps(mi, ce, e_i);
+        e_q = _mm512_fmadd_ps(mq, ce, e_q);
+        p_i = _mm512_fmadd_ps(mi, cp, p_i);
+        p_q = _mm512_fmadd_ps(mq, cp, p_q);
+        l_i = _mm512_fmadd_ps(mi, cl, l_i);
+        l_q = _mm512_fmadd_ps(mq, cl, l_q);
+    }
+
+    acc[0] += _mm512_reduce_add_ps(e_i);
+    acc[1] += _mm512_reduce_add_ps(e_q);
+    acc[2] += _mm512_reduce_add_ps(p_i);
+    acc[3] += _mm512_reduce_add_ps(p_q);
+    acc[4] += _mm512_reduce_add_ps(l_i);
+    acc[5] += _mm512_reduce_add_ps(l_q);
+
+    accumulateTail(samples_i, samples_q, carrier_i, carrier_q, early, prompt, late,
+                   simd_length, length, acc);
+}
+GPS_AVX512_END
+
+const KernelSet<AccumulateKernel> kAccumulateKernels = {
+    accumulateEPLScalar, accumulateEPLSSE4, accumulateEPLAVX2, accumulateEPLAVX512};
+
+}
+
+MultiChannelCorrelator::MultiChannelCorrelator(double sample_rate)
+    : sample_rate_(sample_rate)
+    , carrier_nco_(sample_rate, NCOMode::ROTATOR)
+    , code_nco_(1, sample_rate)
+    , tile_i_(TILE_SIZE)
+    , tile_q_(TILE_SIZE)
+    , carrier_i_(TILE_SIZE)
+    , carrier_q_(TILE_SIZE) {
+}
+
+void MultiChannelCorrelator::correlate(const IQSample* samples,
+                                       size_t length,
+                                       const std::vector<ChannelReplica>& channels,
+                                       std::vector<CorrelationResult>& results) {
+    full_spans_.assign(channels.size(), ChannelSpan{0, length});
+    correlate(samples, length, channels, full_spans_, results);
+}
+
+CorrelationResult MultiChannelCorrelator::correlate(const IQSample* samples,
+                                                    size_t length,
+                                                    const ChannelReplica& channel,
+                                                    const ChannelSpan& span) {
+    single_channel_.assign(1, channel);
+    single_span_.assign(1, span);
+    correlate(samples, length, single_channel_, single_span_, single_result_);
+    return single_result_[0];
+}
+
+void MultiChannelCorrelator::correlate(const IQSample* samples,
+                                       size_t length,
+                                       const std::vector<ChannelReplica>& channels,
+                                       const std::vector<ChannelSpan>& spans,
+                                       std::vector<CorrelationResult>& results) {
+    const size_t num_channels = channels.size();
+    results.resize(num_channels);
+    if (num_channels == 0) {
+        return;
+    }
+    if (spans.size() != num_channels) {
+        throw std::invalid_argument("One span per channel required");
+    }
+
+    code_phase_.resize(num_channels);
+    code_rate_.resize(num_channels);
+    carrier_phase_.resize(num_channels);
+    carrier_freq_.resize(num_channels);
+    acc_early_i_.assign(num_channels, 0.0f);
+    acc_early_q_.assign(num_channels, 0.0f);
+    acc_prompt_i_.assign(num_channels, 0.0f);
+    acc_prompt_q_.assign(num_channels, 0.0f);
+    acc_late_i_.assign(num_channels, 0.0f);
+    acc_late_q_.assign(num_channels, 0.0f);
+
+    for (size_t ch = 0; ch < num_channels; ++ch) {
+        if (channels[ch].prn < 1 || channels[ch].prn > GPS_MAX_SATELLITES) {
+            throw std::invalid_argument("Invalid PRN number");
+        }
+        if (spans[ch].offset + spans[ch].length > length) {
+            throw std::invalid_argument("Channel span outside the block");
+        }
+        code_phase_[ch] = CodeNCO::toPhaseWord(channels[ch].code_phase);
+        code_rate_[ch] = channels[ch].code_rate;
+        carrier_phase_[ch] = CarrierNCO::toPhaseWord(channels[ch].carrier_phase);
+        carrier_freq_[ch] = channels[ch].carrier_freq;
+    }
+
+    static const AccumulateKernel accumulateEPL = kAccumulateKernels.select();
+
+    // Only the samples some channel integrates over are walked
+    size_t first = length;
+    size_t last = 0;
+    for (const ChannelSpan& span : spans) {
+        if (span.length > 0) {
+            first = std::min(first, span.offset);
+            last = std::max(last, span.offset + span.length);
+        }
+    }
+
+    for (size_t start = first; start < last; start += TILE_SIZE) {
+        const size_t n = std::min(TILE_SIZE, last - start);
+
+        // Split the tile into I and Q once for all channels
+        for (size_t i = 0; i < n; ++i) {
+            tile_i_[i] = samples[start + i].real();
+            tile_q_[i] = samples[start + i].imag();
+        }
+
+        for (size_t ch = 0; ch < num_channels; ++ch) {
+            // Part of the tile inside the channel's span
+            const size_t begin = std::max(start, spans[ch].offset);
+            const size_t end = std::min(start + n, spans[ch].offset + spans[ch].length);
+            if (begin >= end) {
+                continue;
+            }
+            const size_t m = end - begin;
+            const size_t skip = begin - start;
+
+            // The NCO phase word carries each channel from tile to tile
+            carrier_nco_.setPhaseWord(carrier_phase_[ch]);
+            carrier_nco_.setFrequency(carrier_freq_[ch]);
+            carrier_nco_.generate(m, carrier_i_.data(), carrier_q_.data());
+            carrier_phase_[ch] = carrier_nco_.getPhaseWord();
+
+            // One extended replica; early and late are views into it
+            code_nco_.setPRN(channels[ch].prn);
+            code_nco_.setPhaseWord(code_phase_[ch]);
+            code_nco_.setRate(code_rate_[ch]);
+            code_nco_.generate(m);
+            code_phase_[ch] = code_nco_.getPhaseWord();
+
+            float acc[6] = {0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f};
+            accumulateEPL(tile_i_.data() + skip, tile_q_.data() + skip,
+                          carrier_i_.data(), carrier_q_.data(),
+                          code_nco_.early(), code_nco_.prompt(), code_nco_.late(), m, acc);
+
+            acc_early_i_[ch] += acc[0];
+            acc_early_q_[ch] += acc[1];
+            acc_prompt_i_[ch] += acc[2];
+            acc_prompt_q_[ch] += acc[3];
+            acc_late_i_[ch] += acc[4];
+            acc_late_q_[ch] += acc[5];
+        }
+    }
+
+    for (size_t ch = 0; ch < num_channels; ++ch) {
+        CorrelationResult& result = results[ch];
+        result.early = std::complex<float>(acc_early_i_[ch], acc_early_q_[ch]);
+        result.prompt = std::complex<float>(acc_prompt_i_[ch], acc_prompt_q_[ch]);
+        result.late = std::complex<float>(acc_late_i_[ch], acc_late_q_[ch]);
+        result.power_early = std::norm(result.early);
+        result.power_prompt = std::norm(result.prompt);
+        result.power_late = std::norm(result.late);
+    }
+}
+
+}
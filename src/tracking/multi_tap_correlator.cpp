@@ -0,0 +1,343 @@
+#include "tracking/multi_tap_correlator.h"
+#include <immintrin.h>
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include "utils/simd_dispatch.h"
+
+namespace gps {
+
+namespace {
+
+// Baseband = samples times conj(carrier), split I/Q
+using WipeOffKernel = void (*)(const float*, const float*, const float*, const float*,
+                               size_t, float*, float*);
+// acc_i[t] += sum(bb_i * code[t]), acc_q[t] += sum(bb_q * code[t])
+using TapKernel = void (*)(const float*, const float*, const float* const*, size_t,
+                           size_t, float*, float*);
+
+void wipeOffScalar(const float* __restrict__ samples_i,
+                   const float* __restrict__ samples_q,
+                   const float* __restrict__ carrier_i,
+                   const float* __restrict__ carrier_q,
+                   size_t length,
+                   float* __restrict__ baseband_i,
+                   float* __restrict__ baseband_q) {
+    for (size_t n = 0; n < length; ++n) {
+        baseband_i[n] = samples_i[n] * carrier_i[n] + samples_q[n] * carrier_q[n];
+        baseband_q[n] = samples_q[n] * carrier_i[n] - samples_i[n] * carrier_q[n];
+    }
+}
+
+void tapsScalar(const float* __restrict__ baseband_i,
+                const float* __restrict__ baseband_q,
+                const float* const* codes,
+                size_t num_taps,
+                size_t length,
+                float* acc_i,
+                float* acc_q) {
+    for (size_t t = 0; t < num_taps; ++t) {
+        const float* code = codes[t];
+        float sum_i = 0.0f;
+        float sum_q = 0.0f;
+        for (size_t n = 0; n < length; ++n) {
+            sum_i += baseband_i[n] * code[n];
+            sum_q += baseband_q[n] * code[n];
+        }
+        acc_i[t] += sum_i;
+        acc_q[t] += sum_q;
+    }
+}
+
+GPS_TARGET_AVX2
+inline float horizontalSum(__m256 v) {
+    __m128 sum = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+    sum = _mm_hadd_ps(sum, sum);
+    sum = _mm_hadd_ps(sum, sum);
+    return _mm_cvtss_f32(sum);
+}
+
+GPS_TARGET_AVX2
+void wipeOffAVX2(const float* __restrict__ samples_i,
+                 const float* __restrict__ samples_q,
+                 const float* __restrict__ carrier_i,
+                 const float* __restrict__ carrier_q,
+                 size_t length,
+                 float* __restrict__ baseband_i,
+                 float* __restrict__ baseband_q) {
+    size_t n = 0;
+    for (; n + 8 <= length; n += 8) {
+        __m256 si = _mm256_loadu_ps(&samples_i[n]);
+        __m256 sq = _mm256_loadu_ps(&samples_q[n]);
+        __m256 ci = _mm256_loadu_ps(&carrier_i[n]);
+        __m256 cq = _mm256_loadu_ps(&carrier_q[n]);
+        _mm256_storeu_ps(&baseband_i[n], _mm256_fmadd_ps(si, ci, _mm256_mul_ps(sq, cq)));
+        _mm256_storeu_ps(&baseband_q[n], _mm256_fmsub_ps(sq, ci, _mm256_mul_ps(si, cq)));
+    }
+    wipeOffScalar(samples_i + n, samples_q + n, carrier_i + n, carrier_q + n, length - n,
+                  baseband_i + n, baseband_q + n);
+}
+
+// Four taps per pass, so each baseband load feeds eight multiply-adds
+GPS_TARGET_AVX2
+void tapsAVX2(const float* __restrict__ baseband_i,
+              const float* __restrict__ baseband_q,
+              const float* const* codes,
+              size_t num_taps,
+              size_t length,
+              float* acc_i,
+              float* acc_q) {
+    const size_t simd_length = length & ~static_cast<size_t>(7);
+
+    size_t t = 0;
+    for (; t + 4 <= num_taps; t += 4) {
+        const float* c0 = codes[t];
+        const float* c1 = codes[t + 1];
+        const float* c2 = codes[t + 2];
+        const float* c3 = codes[t + 3];
+        __m256 i0 = _mm256_setzero_ps(), q0 = _mm256_setzero_ps();
+        __m256 i1 = _mm256_setzero_ps(), q1 = _mm256_setzero_ps();
+        __m256 i2 = _mm256_setzero_ps(), q2 = _mm256_setzero_ps();
+        __m256 i3 = _mm256_setzero_ps(), q3 = _mm256_setzero_ps();
+
+        for (size_t n = 0; n < simd_length; n += 8) {
+            const __m256 bi = _mm256_loadu_ps(&baseband_i[n]);
+            const __m256 bq = _mm256_loadu_ps(&baseband_q[n]);
+            __m256 c = _mm256_loadu_ps(&c0[n]);
+            i0 = _mm256_fmadd_ps(bi, c, i0);
+            q0 = _mm256_fmadd_ps(bq, c, q0);
+            c = _mm256_loadu_ps(&c1[n]);
+            i1 = _mm256_fmadd_ps(bi, c, i1);
+            q1 = _mm256_fmadd_ps(bq, c, q1);
+            c = _mm256_loadu_ps(&c2[n]);
+            i2 = _mm256_fmadd_ps(bi, c, i2);
+            q2 = _mm256_fmadd_ps(bq, c, q2);
+            c = _mm256_loadu_ps(&c3[n]);
+            i3 = _mm256_fmadd_ps(bi, c, i3);
+            q3 = _mm256_fmadd_ps(bq, c, q3);
+        }
+
+        acc_i[t] += horizontalSum(i0);
+        acc_q[t] += horizontalSum(q0);
+        acc_i[t + 1] += horizontalSum(i1);
+        acc_q[t + 1] += horizontalSum(q1);
+        acc_i[t + 2] += horizontalSum(i2);
+        acc_q[t + 2] += horizontalSum(q2);
+        acc_i[t + 3] += horizontalSum(i3);
+        acc_q[t + 3] += horizontalSum(q3);
+    }
+
+    for (; t < num_taps; ++t) {
+        const float* code = codes[t];
+        __m256 vi = _mm256_setzero_ps(), vq = _mm256_setzero_ps();
+        for (size_t n = 0; n < simd_length; n += 8) {
+            const __m256 c = _mm256_loadu_ps(&code[n]);
+            vi = _mm256_fmadd_ps(_mm256_loadu_ps(&baseband_i[n]), c, vi);
+            vq = _mm256_fmadd_ps(_mm256_loadu_ps(&baseband_q[n]), c, vq);
+        }
+        acc_i[t] += horizontalSum(vi);
+        acc_q[t] += horizontalSum(vq);
+    }
+
+    // Sample tail for every tap
+    for (size_t tap = 0; tap < num_taps; ++tap) {
+        for (size_t n = simd_length; n < length; ++n) {
+            acc_i[tap] += baseband_i[n] * codes[tap][n];
+            acc_q[tap] += baseband_q[n] * codes[tap][n];
+        }
+    }
+}
+
+GPS_AVX512_BEGIN
+
+GPS_TARGET_AVX512
+void tapsAVX512(const float* __restrict__ baseband_i,
+                const float* __restrict__ baseband_q,
+                const float* const* codes,
+                size_t num_taps,
+                size_t length,
+                float* acc_i,
+                float* acc_q) {
+    const size_t simd_length = length & ~static_cast<size_t>(15);
+
+    size_t t = 0;
+    for (; t + 4 <= num_taps; t += 4) {
+        __m512 vi[4], vq[4];
+        for (int k = 0; k < 4; ++k) {
+            vi[k] = _mm512_setzero_ps();
+            vq[k] = _mm512_setzero_ps();
+        }
+        for (size_t n = 0; n < simd_length; n += 16) {
+            const __m512 bi = _mm512_loadu_ps(&baseband_i[n]);
+            const __m512 bq = _mm512_loadu_ps(&baseband_q[n]);
+            for (int k = 0; k < 4; ++k) {
+                const __m512 c = _mm512_loadu_ps(&codes[t + k][n]);
+                vi[k] = _mm512_fmadd_ps(bi, c, vi[k]);
+                vq[k] = _mm512_fmadd_ps(bq, c, vq[k]);
+            }
+        }
+        for (int k = 0; k < 4; ++k) {
+            acc_i[t + k] += _mm512_reduce_add_ps(vi[k]);
+            acc_q[t + k] += _mm512_reduce_add_ps(vq[k]);
+        }
+    }
+
+    for (; t < num_taps; ++t) {
+        __m512 vi = _mm512_setzero_ps(), vq = _mm512_setzero_ps();
+        for (size_t n = 0; n < simd_length; n += 16) {
+            const __m512 c = _mm512_loadu_ps(&codes[t][n]);
+            vi = _mm512_fmadd_ps(_mm512_loadu_ps(&baseband_i[n]), c, vi);
+            vq = _mm512_fmadd_ps(_mm512_loadu_ps(&baseband_q[n]), c, vq);
+        }
+        acc_i[t] += _mm512_reduce_add_ps(vi);
+        acc_q[t] += _mm512_reduce_add_ps(vq);
+    }
+
+    for (size_t tap = 0; tap < num_taps; ++tap) {
+        for (size_t n = simd_length; n < length; ++n) {
+            acc_i[tap] += baseband_i[n] * codes[tap][n];
+            acc_q[tap] += baseband_q[n] * codes[tap][n];
+        }
+    }
+}
+
+GPS_AVX512_END
+
+// Wipe-off is one pass per tile; wider than AVX2 buys nothing there
+const KernelSet<WipeOffKernel> kWipeOffKernels = {wipeOffScalar, nullptr, wipeOffAVX2, nullptr};
+const KernelSet<TapKernel> kTapKernels = {tapsScalar, nullptr, tapsAVX2, tapsAVX512};
+
+}
+
+MultiTapCorrelator::MultiTapCorrelator(double sample_rate, const MultiTapConfig& config)
+    : sample_rate_(sample_rate)
+    , carrier_nco_(sample_rate, NCOMode::ROTATOR)
+    , code_nco_(1, sample_rate)
+    , phases_(1)
+    , extension_(1)
+    , tile_i_(TILE_SIZE)
+    , tile_q_(TILE_SIZE)
+    , carrier_i_(TILE_SIZE)
+    , carrier_q_(TILE_SIZE)
+    , baseband_i_(TILE_SIZE)
+    , baseband_q_(TILE_SIZE) {
+
+    if (config.num_taps == 0 || config.num_taps > MAX_TAPS) {
+        throw std::invalid_argument("Tap count must be between 1 and MAX_TAPS");
+    }
+
+    // Tap spacing in samples decides how many sub-sample replicas we need
+    const size_t num_taps = config.num_taps;
+    long step = 0;
+    if (num_taps > 1) {
+        const double spacing = 2.0 * config.span_chips / (num_taps - 1) * sample_rate / GPS_CA_CODE_FREQ_HZ;
+        if (!(spacing > 0.0)) {
+            throw std::invalid_argument("Tap span must be positive");
+        }
+        // Fewest phases that hit the spacing within 1%, else the closest
+        double best_error = HUGE_VAL;
+        const size_t min_phases = std::min(MAX_PHASES, static_cast<size_t>(std::ceil(1.0 / spacing - 1e-9)));
+        for (size_t p = std::max<size_t>(1, min_phases); p <= MAX_PHASES; ++p) {
+            const long candidate = std::max(1L, std::lround(spacing * p));
+            const double error = std::abs(static_cast<double>(candidate) / p - spacing) / spacing;
+            if (error < best_error) {
+                best_error = error;
+                phases_ = p;
+                step = candidate;
+            }
+            if (error < 0.01) {
+                break;
+            }
+        }
+    }
+
+    // Symmetric about prompt; an even count puts prompt between two taps
+    const long center = std::lround((num_taps - 1) * step / 2.0);
+    long widest = 0;
+    for (size_t t = 0; t < num_taps; ++t) {
+        const long offset = static_cast<long>(t) * step - center;
+        tap_offsets_.push_back(offset);
+        widest = std::max(widest, std::abs(offset));
+    }
+    extension_ = static_cast<size_t>((widest + phases_ - 1) / phases_) + 1;
+
+    // offset + extension_ * phases_ = shift * phases_ + phase
+    for (long offset : tap_offsets_) {
+        const size_t position = static_cast<size_t>(offset + static_cast<long>(extension_ * phases_));
+        tap_phase_.push_back(position % phases_);
+        tap_shift_.push_back(position / phases_);
+    }
+
+    replicas_.resize(phases_ * (TILE_SIZE + 2 * extension_));
+    views_.resize(num_taps);
+    acc_i_.resize(num_taps);
+    acc_q_.resize(num_taps);
+}
+
+double MultiTapCorrelator::tapSpacing() const {
+    if (tap_offsets_.size() < 2) {
+        return 0.0;
+    }
+    return static_cast<double>(tap_offsets_[1] - tap_offsets_[0]) / phases_ * GPS_CA_CODE_FREQ_HZ / sample_rate_;
+}
+
+double MultiTapCorrelator::tapOffset(size_t tap) const {
+    return static_cast<double>(tap_offsets_[tap]) / phases_ * GPS_CA_CODE_FREQ_HZ / sample_rate_;
+}
+
+void MultiTapCorrelator::correlate(const IQSample* samples,
+                                   size_t length,
+                                   const ChannelReplica& replica,
+                                   TapCorrelation& result) {
+    static const WipeOffKernel wipeOff = kWipeOffKernels.select();
+    static const TapKernel accumulateTaps = kTapKernels.select();
+
+    const size_t num_taps = tap_offsets_.size();
+    std::fill(acc_i_.begin(), acc_i_.end(), 0.0f);
+    std::fill(acc_q_.begin(), acc_q_.end(), 0.0f);
+
+    code_nco_.setPRN(replica.prn);
+    code_nco_.setRate(replica.code_rate);
+    carrier_nco_.setPhase(replica.carrier_phase);
+    carrier_nco_.setFrequency(replica.carrier_freq);
+
+    const uint64_t step = code_nco_.getPhaseStep();
+    const uint64_t back = (extension_ * step) % CodeNCO::PHASE_PERIOD;
+    const size_t row = TILE_SIZE + 2 * extension_;
+    uint64_t phase = CodeNCO::toPhaseWord(replica.code_phase);
+
+    for (size_t start = 0; start < length; start += TILE_SIZE) {
+        const size_t n = std::min(TILE_SIZE, length - start);
+
+        for (size_t i = 0; i < n; ++i) {
+            tile_i_[i] = samples[start + i].real();
+            tile_q_[i] = samples[start + i].imag();
+        }
+        carrier_nco_.generate(n, carrier_i_.data(), carrier_q_.data());
+        wipeOff(tile_i_.data(), tile_q_.data(), carrier_i_.data(), carrier_q_.data(), n,
+                baseband_i_.data(), baseband_q_.data());
+
+        // Replica p starts extension_ samples early, p / phases_ of a sample on
+        const uint64_t first = phase + CodeNCO::PHASE_PERIOD - back;
+        for (size_t p = 0; p < phases_; ++p) {
+            code_nco_.fill(first + p * step / phases_, n + 2 * extension_, &replicas_[p * row]);
+        }
+        for (size_t t = 0; t < num_taps; ++t) {
+            views_[t] = &replicas_[tap_phase_[t] * row + tap_shift_[t]];
+        }
+
+        accumulateTaps(baseband_i_.data(), baseband_q_.data(), views_.data(), num_taps, n,
+                       acc_i_.data(), acc_q_.data());
+
+        phase = (phase + (n * step) % CodeNCO::PHASE_PERIOD) % CodeNCO::PHASE_PERIOD;
+    }
+
+    result.spacing = tapSpacing();
+    result.first_offset = tapOffset(0);
+    result.taps.resize(num_taps);
+    for (size_t t = 0; t < num_taps; ++t) {
+        result.taps[t] = std::complex<float>(acc_i_[t], acc_q_[t]);
+    }
+}
+
+}
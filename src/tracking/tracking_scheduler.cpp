@@ -0,0 +1,286 @@
+#include "tracking/tracking_scheduler.h"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <immintrin.h>
+#include "tracking/gps_tracker.h"
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace gps {
+
+TrackingScheduler::TrackingScheduler(double sample_rate, const TrackingSchedulerConfig& config)
+    : num_workers_(config.num_workers)
+    , samples_(nullptr)
+    , samples8_(nullptr)
+    , num_samples_(0)
+    , batch_(false)
+    , window_begin_(0)
+    , epoch_(0)
+    , pending_(0)
+    , stop_(false) {
+
+    // Spinning workers only pay off with a core each
+    const unsigned num_cores = std::thread::hardware_concurrency();
+    if (num_workers_ == 0) {
+        num_workers_ = std::max(1u, std::min(num_cores, MAX_DEFAULT_WORKERS));
+    } else if (num_cores > 0 && num_workers_ > num_cores) {
+        std::cerr << "Limiting tracking workers to " << num_cores << " cores\n";
+        num_workers_ = num_cores;
+    }
+
+    worker_of_.fill(-1);
+    channel_cost_.fill(0.0);
+
+    workers_.resize(num_workers_);
+    for (auto& worker : workers_) {
+        worker.correlator = std::make_unique<MultiChannelCorrelator>(sample_rate);
+    }
+
+    threads_.reserve(num_workers_ - 1);
+    for (unsigned w = 1; w < num_workers_; ++w) {
+        const bool pin = config.pin_cores;
+        const unsigned core = config.first_core + w - 1;
+        threads_.emplace_back([this, w, pin, core] {
+            if (pin) {
+                pinToCore(core);
+            }
+            workerLoop(w);
+        });
+    }
+}
+
+TrackingScheduler::~TrackingScheduler() {
+    {
+        std::lock_guard<std::mutex> lock(wake_mutex_);
+        stop_ = true;
+    }
+    wake_cv_.notify_all();
+
+    for (auto& thread : threads_) {
+        thread.join();
+    }
+}
+
+void TrackingScheduler::pinToCore(unsigned core) {
+#ifdef __linux__
+    const unsigned num_cores = std::max(1u, std::thread::hardware_concurrency());
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(core % num_cores, &set);
+    if (pthread_setaffinity_np(pthread_self(), sizeof(set), &set) != 0) {
+        std::cerr << "Could not pin tracking worker to core " << core % num_cores << "\n";
+    }
+#else
+    (void)core;
+#endif
+}
+
+void TrackingScheduler::runEpoch(const IQSample* samples, size_t num_samples,
+                                 const std::vector<TrackingChannel*>& channels) {
+    std::lock_guard<std::mutex> run_lock(run_mutex_);
+    samples_ = samples;
+    samples8_ = nullptr;
+    num_samples_ = num_samples;
+    batch_ = false;
+    dispatch(channels);
+}
+
+void TrackingScheduler::runEpoch(const IQSample8* samples, size_t num_samples,
+                                 const std::vector<TrackingChannel*>& channels) {
+    std::lock_guard<std::mutex> run_lock(run_mutex_);
+    samples_ = nullptr;
+    samples8_ = samples;
+    num_samples_ = num_samples;
+    batch_ = false;
+    dispatch(channels);
+}
+
+void TrackingScheduler::runBatch(const IQSample* samples, size_t num_samples, uint64_t window_begin,
+                                 const std::vector<TrackingChannel*>& channels) {
+    std::lock_guard<std::mutex> run_lock(run_mutex_);
+    samples_ = samples;
+    samples8_ = nullptr;
+    num_samples_ = num_samples;
+    batch_ = true;
+    window_begin_ = window_begin;
+    dispatch(channels);
+}
+
+void TrackingScheduler::dispatch(const std::vector<TrackingChannel*>& channels) {
+    assignChannels(channels);
+
+    pending_.store(num_workers_ - 1, std::memory_order_relaxed);
+    {
+        std::lock_guard<std::mutex> lock(wake_mutex_);
+        epoch_.fetch_add(1, std::memory_order_release);
+    }
+    wake_cv_.notify_all();
+
+    runWorker(0);
+
+    // Barrier: the others normally finish within the spin window
+    for (int spin = 0; spin < SPIN_ITERATIONS && pending_.load(std::memory_order_acquire) != 0; ++spin) {
+        _mm_pause();
+    }
+    if (pending_.load(std::memory_order_acquire) != 0) {
+        std::unique_lock<std::mutex> lock(wake_mutex_);
+        done_cv_.wait(lock, [this] { return pending_.load(std::memory_order_acquire) == 0; });
+    }
+
+    updateCosts();
+    if (getEpoch() % REBALANCE_EPOCHS == 0) {
+        rebalance();
+    }
+}
+
+void TrackingScheduler::workerLoop(unsigned worker) {
+    uint64_t seen = 0;
+
+    while (true) {
+        uint64_t epoch = epoch_.load(std::memory_order_acquire);
+        for (int spin = 0; spin < SPIN_ITERATIONS && epoch == seen; ++spin) {
+            _mm_pause();
+            epoch = epoch_.load(std::memory_order_acquire);
+        }
+
+        if (epoch == seen) {
+            std::unique_lock<std::mutex> lock(wake_mutex_);
+            wake_cv_.wait(lock, [&] { return stop_ || epoch_.load(std::memory_order_relaxed) != seen; });
+            if (stop_) {
+                return;
+            }
+            epoch = epoch_.load(std::memory_order_acquire);
+        }
+        seen = epoch;
+
+        runWorker(worker);
+
+        if (pending_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            std::lock_guard<std::mutex> lock(wake_mutex_);
+            done_cv_.notify_one();
+        }
+    }
+}
+
+void TrackingScheduler::runWorker(unsigned index) {
+    using Clock = std::chrono::steady_clock;
+    const auto micros = [](Clock::duration d) { return std::chrono::duration<double, std::micro>(d).count(); };
+
+    Worker& worker = workers_[index];
+    const auto start = Clock::now();
+    worker.channel_us.assign(worker.channels.size(), 0.0);
+
+    if (batch_) {
+        for (size_t i = 0; i < worker.channels.size(); ++i) {
+            const auto begin = Clock::now();
+            worker.channels[i]->trackBatch(samples_, window_begin_, window_begin_ + num_samples_,
+                                           *worker.correlator);
+            worker.channel_us[i] = micros(Clock::now() - begin);
+        }
+    } else if (samples_) {
+        worker.replicas.clear();
+        worker.spans.clear();
+        size_t total_length = 0;
+        for (TrackingChannel* channel : worker.channels) {
+            worker.replicas.push_back(channel->getReplica());
+            worker.spans.push_back(channel->getSpan());
+            total_length += channel->getSpan().length;
+        }
+        const auto pass = Clock::now();
+        worker.correlator->correlate(samples_, num_samples_, worker.replicas, worker.spans,
+                                     worker.results);
+        const double pass_us = micros(Clock::now() - pass);
+
+        for (size_t i = 0; i < worker.channels.size(); ++i) {
+            // Carrier, code and accumulation run over each channel's own span
+            if (total_length > 0) {
+                worker.channel_us[i] = pass_us * worker.spans[i].length / total_length;
+            }
+            const auto begin = Clock::now();
+            worker.channels[i]->applyCorrelation(worker.results[i]);
+            worker.channel_us[i] += micros(Clock::now() - begin);
+        }
+    } else {
+        for (size_t i = 0; i < worker.channels.size(); ++i) {
+            const auto begin = Clock::now();
+            worker.channels[i]->updateTracking(samples8_);
+            worker.channel_us[i] = micros(Clock::now() - begin);
+        }
+    }
+
+    worker.elapsed_us = micros(Clock::now() - start);
+}
+
+void TrackingScheduler::assignChannels(const std::vector<TrackingChannel*>& channels) {
+    std::vector<double> load(num_workers_, 0.0);
+    for (auto& worker : workers_) {
+        worker.channels.clear();
+    }
+
+    // Channels keep their worker; costs of the new ones are not known yet
+    std::vector<TrackingChannel*> unassigned;
+    double known_cost = 0.0;
+    for (TrackingChannel* channel : channels) {
+        const int prn = channel->getPRN();
+        if (worker_of_[prn] >= 0) {
+            workers_[worker_of_[prn]].channels.push_back(channel);
+            load[worker_of_[prn]] += channel_cost_[prn];
+            known_cost = std::max(known_cost, channel_cost_[prn]);
+        } else {
+            unassigned.push_back(channel);
+        }
+    }
+
+    for (TrackingChannel* channel : unassigned) {
+        const int prn = channel->getPRN();
+        const unsigned w = static_cast<unsigned>(std::min_element(load.begin(), load.end()) - load.begin());
+        worker_of_[prn] = static_cast<int>(w);
+        workers_[w].channels.push_back(channel);
+        // Even without a measurement, spread new channels over the workers
+        load[w] += known_cost > 0.0 ? known_cost : 1.0;
+    }
+}
+
+void TrackingScheduler::updateCosts() {
+    for (const auto& worker : workers_) {
+        for (size_t i = 0; i < worker.channels.size(); ++i) {
+            const double sample = worker.channel_us[i];
+            double& cost = channel_cost_[worker.channels[i]->getPRN()];
+            cost = cost > 0.0 ? cost + COST_ALPHA * (sample - cost) : sample;
+        }
+    }
+}
+
+void TrackingScheduler::rebalance() {
+    std::vector<int> prns;
+    for (const auto& worker : workers_) {
+        for (TrackingChannel* channel : worker.channels) {
+            prns.push_back(channel->getPRN());
+        }
+    }
+    std::sort(prns.begin(), prns.end(), [this](int a, int b) {
+        return channel_cost_[a] > channel_cost_[b];
+    });
+
+    std::vector<double> load(num_workers_, 0.0);
+    for (int prn : prns) {
+        const unsigned w = static_cast<unsigned>(std::min_element(load.begin(), load.end()) - load.begin());
+        worker_of_[prn] = static_cast<int>(w);
+        load[w] += channel_cost_[prn];
+    }
+}
+
+std::vector<double> TrackingScheduler::getWorkerLoad() const {
+    std::vector<double> load;
+    load.reserve(workers_.size());
+    for (const auto& worker : workers_) {
+        load.push_back(worker.elapsed_us);
+    }
+    return load;
+}
+
+}
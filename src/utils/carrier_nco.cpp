@@ -0,0 +1,276 @@
+#include "utils/carrier_nco.h"
+#include <immintrin.h>
+#include <algorithm>
+#include <cmath>
+#include "utils/simd_dispatch.h"
+
+namespace gps {
+
+namespace {
+
+constexpr double CYCLES_TO_WORD = 4294967296.0;
+constexpr size_t TABLE_SIZE = size_t(1) << CarrierNCO::TABLE_BITS;
+
+// One sine period, cos is read a quarter period later
+struct SineTable {
+    std::array<float, TABLE_SIZE> values;
+
+    SineTable() {
+        for (size_t n = 0; n < TABLE_SIZE; ++n) {
+            values[n] = static_cast<float>(std::sin(2.0 * M_PI * n / TABLE_SIZE));
+        }
+    }
+};
+
+const SineTable kSineTable;
+
+uint32_t cyclesToWord(double cycles) {
+    const double fraction = cycles - std::floor(cycles);
+    return static_cast<uint32_t>(static_cast<uint64_t>(std::llround(fraction * CYCLES_TO_WORD)));
+}
+
+// sin/cos of phases in cycles: quadrant by rounding 4 * phase, then
+// minimax polynomials on [-pi/4, pi/4]
+GPS_TARGET_AVX2
+inline void sincosCycles(__m256 cycles, __m256& s, __m256& c) {
+    const int nearest = _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC;
+    cycles = _mm256_sub_ps(cycles, _mm256_round_ps(cycles, nearest));
+
+    const __m256 quadrant = _mm256_round_ps(_mm256_mul_ps(cycles, _mm256_set1_ps(4.0f)), nearest);
+    const __m256 r = _mm256_mul_ps(_mm256_fnmadd_ps(quadrant, _mm256_set1_ps(0.25f), cycles),
+                                   _mm256_set1_ps(static_cast<float>(2.0 * M_PI)));
+    const __m256 r2 = _mm256_mul_ps(r, r);
+
+    __m256 sin_poly = _mm256_fmadd_ps(r2, _mm256_set1_ps(-1.9515295891e-4f),
+                                      _mm256_set1_ps(8.3321608736e-3f));
+    sin_poly = _mm256_fmadd_ps(r2, sin_poly, _mm256_set1_ps(-1.6666654611e-1f));
+    sin_poly = _mm256_fmadd_ps(_mm256_mul_ps(r, r2), sin_poly, r);
+
+    __m256 cos_poly = _mm256_fmadd_ps(r2, _mm256_set1_ps(2.443315711809948e-5f),
+                                      _mm256_set1_ps(-1.388731625493765e-3f));
+    cos_poly = _mm256_fmadd_ps(r2, cos_poly, _mm256_set1_ps(4.166664568298827e-2f));
+    cos_poly = _mm256_fmadd_ps(_mm256_mul_ps(r2, r2), cos_poly,
+                               _mm256_fnmadd_ps(r2, _mm256_set1_ps(0.5f), _mm256_set1_ps(1.0f)));
+
+    // Odd quadrants swap sin and cos; signs follow the quadrant bits
+    const __m256i q = _mm256_cvtps_epi32(quadrant);
+    const __m256i one = _mm256_set1_epi32(1);
+    const __m256i two = _mm256_set1_epi32(2);
+    const __m256 swap = _mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_and_si256(q, one), one));
+    const __m256 sin_sign = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(q, two), 30));
+    const __m256 cos_sign = _mm256_castsi256_ps(
+        _mm256_slli_epi32(_mm256_and_si256(_mm256_add_epi32(q, one), two), 30));
+
+    s = _mm256_xor_ps(_mm256_blendv_ps(sin_poly, cos_poly, swap), sin_sign);
+    c = _mm256_xor_ps(_mm256_blendv_ps(cos_poly, sin_poly, swap), cos_sign);
+}
+
+// Phase words read as signed fractions of a cycle in [-0.5, 0.5)
+GPS_TARGET_AVX2
+inline void sincosWords(__m256i words, __m256& s, __m256& c) {
+    const __m256 cycles = _mm256_mul_ps(_mm256_cvtepi32_ps(words),
+                                        _mm256_set1_ps(static_cast<float>(1.0 / CYCLES_TO_WORD)));
+    sincosCycles(cycles, s, c);
+}
+
+GPS_TARGET_AVX2
+inline __m256i laneWords(uint32_t phase, uint32_t step) {
+    const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    return _mm256_add_epi32(_mm256_set1_epi32(static_cast<int>(phase)),
+                            _mm256_mullo_epi32(_mm256_set1_epi32(static_cast<int>(step)), lanes));
+}
+
+inline void scalarSincos(uint32_t word, float& s, float& c) {
+    const double theta = 2.0 * M_PI * static_cast<int32_t>(word) / CYCLES_TO_WORD;
+    s = static_cast<float>(std::sin(theta));
+    c = static_cast<float>(std::cos(theta));
+}
+
+// Exact sin/cos for samples begin..end of a run starting at phase
+void sincosTail(uint32_t phase, uint32_t step, size_t begin, size_t end,
+                float* cos_out, float* sin_out) {
+    for (size_t i = begin; i < end; ++i) {
+        scalarSincos(phase + static_cast<uint32_t>(step * static_cast<uint64_t>(i)),
+                     sin_out[i], cos_out[i]);
+    }
+}
+
+using GenerateKernel = void (*)(uint32_t, uint32_t, size_t, float*, float*);
+using SincosKernel = void (*)(const float*, float*, float*, size_t);
+
+// One complex rotator, re-anchored like the vector lanes
+void rotatorScalar(uint32_t phase, uint32_t step, size_t length, float* cos_out, float* sin_out) {
+    float rot_im, rot_re;
+    scalarSincos(step, rot_im, rot_re);
+
+    size_t i = 0;
+    while (i < length) {
+        float re, im;
+        scalarSincos(phase + static_cast<uint32_t>(step * static_cast<uint64_t>(i)), im, re);
+
+        const size_t end = std::min(length, i + CarrierNCO::RENORM_INTERVAL);
+        for (; i < end; ++i) {
+            cos_out[i] = re;
+            sin_out[i] = im;
+
+            const float next_re = re * rot_re - im * rot_im;
+            im = re * rot_im + im * rot_re;
+            re = next_re;
+        }
+    }
+}
+
+void polynomialScalar(uint32_t phase, uint32_t step, size_t length, float* cos_out, float* sin_out) {
+    sincosTail(phase, step, 0, length, cos_out, sin_out);
+}
+
+void sincosScalar(const float* radians, float* sin_out, float* cos_out, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        sin_out[i] = std::sin(radians[i]);
+        cos_out[i] = std::cos(radians[i]);
+    }
+}
+
+GPS_TARGET_AVX2
+void rotatorAVX2(uint32_t phase, uint32_t step, size_t length, float* cos_out, float* sin_out) {
+    const size_t simd_length = length & ~static_cast<size_t>(7);
+
+    // Eight samples per step
+    __m256 rot_re, rot_im;
+    sincosWords(_mm256_set1_epi32(static_cast<int>(step * 8u)), rot_im, rot_re);
+
+    size_t i = 0;
+    while (i < simd_length) {
+        // Re-anchor every lane from the accumulator
+        __m256 re, im;
+        sincosWords(laneWords(phase + static_cast<uint32_t>(step * static_cast<uint64_t>(i)), step),
+                    im, re);
+
+        const size_t end = std::min(simd_length, i + CarrierNCO::RENORM_INTERVAL);
+        for (; i < end; i += 8) {
+            _mm256_storeu_ps(&cos_out[i], re);
+            _mm256_storeu_ps(&sin_out[i], im);
+
+            const __m256 next_re = _mm256_fmsub_ps(re, rot_re, _mm256_mul_ps(im, rot_im));
+            im = _mm256_fmadd_ps(re, rot_im, _mm256_mul_ps(im, rot_re));
+            re = next_re;
+        }
+    }
+
+    sincosTail(phase, step, i, length, cos_out, sin_out);
+}
+
+GPS_TARGET_AVX2
+void polynomialAVX2(uint32_t phase, uint32_t step, size_t length, float* cos_out, float* sin_out) {
+    const size_t simd_length = length & ~static_cast<size_t>(7);
+    const __m256i advance = _mm256_set1_epi32(static_cast<int>(step * 8u));
+
+    __m256i words = laneWords(phase, step);
+    size_t i = 0;
+    for (; i < simd_length; i += 8) {
+        __m256 s, c;
+        sincosWords(words, s, c);
+        _mm256_storeu_ps(&cos_out[i], c);
+        _mm256_storeu_ps(&sin_out[i], s);
+        words = _mm256_add_epi32(words, advance);
+    }
+
+    sincosTail(phase, step, i, length, cos_out, sin_out);
+}
+
+GPS_TARGET_AVX2
+void sincosAVX2(const float* radians, float* sin_out, float* cos_out, size_t n) {
+    const __m256 to_cycles = _mm256_set1_ps(static_cast<float>(1.0 / (2.0 * M_PI)));
+    const size_t simd_length = n & ~static_cast<size_t>(7);
+
+    size_t i = 0;
+    for (; i < simd_length; i += 8) {
+        __m256 s, c;
+        sincosCycles(_mm256_mul_ps(_mm256_loadu_ps(&radians[i]), to_cycles), s, c);
+        _mm256_storeu_ps(&sin_out[i], s);
+        _mm256_storeu_ps(&cos_out[i], c);
+    }
+
+    sincosScalar(radians + i, sin_out + i, cos_out + i, n - i);
+}
+
+// The polynomials need FMA and variable blends, so there is no SSE4 tier
+const KernelSet<GenerateKernel> kRotatorKernels = {rotatorScalar, nullptr, rotatorAVX2, nullptr};
+const KernelSet<GenerateKernel> kPolynomialKernels = {polynomialScalar, nullptr, polynomialAVX2, nullptr};
+const KernelSet<SincosKernel> kSincosKernels = {sincosScalar, nullptr, sincosAVX2, nullptr};
+
+}
+
+CarrierNCO::CarrierNCO(double sample_rate, NCOMode mode)
+    : sample_rate_(sample_rate)
+    , mode_(mode)
+    , phase_(0)
+    , step_(0) {
+}
+
+uint32_t CarrierNCO::toPhaseWord(double radians) {
+    return cyclesToWord(radians / (2.0 * M_PI));
+}
+
+uint32_t CarrierNCO::toPhaseStep(double frequency, double sample_rate) {
+    return cyclesToWord(frequency / sample_rate);
+}
+
+double CarrierNCO::getPhase() const {
+    return 2.0 * M_PI * phase_ / CYCLES_TO_WORD;
+}
+
+void CarrierNCO::generate(size_t length, float* cos_out, float* sin_out) {
+    switch (mode_) {
+        case NCOMode::TABLE:
+            generateTable(length, cos_out, sin_out);
+            break;
+        case NCOMode::ROTATOR:
+            generateRotator(length, cos_out, sin_out);
+            break;
+        case NCOMode::POLYNOMIAL:
+            generatePolynomial(length, cos_out, sin_out);
+            break;
+    }
+    phase_ += static_cast<uint32_t>(step_ * static_cast<uint64_t>(length));
+}
+
+void CarrierNCO::generate(size_t length, IQSample* out) {
+    cos_buffer_.resize(length);
+    sin_buffer_.resize(length);
+    generate(length, cos_buffer_.data(), sin_buffer_.data());
+    for (size_t i = 0; i < length; ++i) {
+        out[i] = IQSample(cos_buffer_[i], sin_buffer_[i]);
+    }
+}
+
+void CarrierNCO::generateTable(size_t length, float* cos_out, float* sin_out) const {
+    constexpr int shift = 32 - TABLE_BITS;
+    constexpr uint32_t round = 1u << (shift - 1);
+    constexpr uint32_t mask = TABLE_SIZE - 1;
+
+    uint32_t acc = phase_;
+    for (size_t i = 0; i < length; ++i) {
+        const uint32_t index = (acc + round) >> shift;
+        sin_out[i] = kSineTable.values[index & mask];
+        cos_out[i] = kSineTable.values[(index + TABLE_SIZE / 4) & mask];
+        acc += step_;
+    }
+}
+
+void CarrierNCO::generateRotator(size_t length, float* cos_out, float* sin_out) const {
+    static const GenerateKernel kernel = kRotatorKernels.select();
+    kernel(phase_, step_, length, cos_out, sin_out);
+}
+
+void CarrierNCO::generatePolynomial(size_t length, float* cos_out, float* sin_out) const {
+    static const GenerateKernel kernel = kPolynomialKernels.select();
+    kernel(phase_, step_, length, cos_out, sin_out);
+}
+
+void CarrierNCO::sincos(const float* radians, float* sin_out, float* cos_out, size_t n) {
+    static const SincosKernel kernel = kSincosKernels.select();
+    kernel(radians, sin_out, cos_out, n);
+}
+
+}
@@ -0,0 +1,122 @@
+#include "utils/code_nco.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <stdexcept>
+#include "utils/prn_generator.h"
+
+namespace gps {
+
+namespace {
+
+// All 32 codes as +/-1, float and int8
+struct CodeTables {
+    std::array<std::vector<float>, GPS_MAX_SATELLITES> codes;
+    std::array<std::vector<int8_t>, GPS_MAX_SATELLITES> codes8;
+
+    CodeTables() {
+        PRNGenerator generator;
+        for (int prn = 1; prn <= GPS_MAX_SATELLITES; ++prn) {
+            codes[prn - 1] = generator.generateCodeFloat(prn);
+            codes8[prn - 1].resize(codes[prn - 1].size());
+            for (size_t i = 0; i < codes[prn - 1].size(); ++i) {
+                codes8[prn - 1][i] = codes[prn - 1][i] > 0.0f ? 1 : -1;
+            }
+        }
+    }
+};
+
+const CodeTables& codeTables() {
+    static const CodeTables tables;
+    return tables;
+}
+
+// Walk the table in runs that end at the code period, so the inner loop
+// has no wrap check
+template <typename T, int REPEAT>
+void fillReplica(const T* table, uint64_t phase, uint64_t step, size_t count, T* out) {
+    size_t i = 0;
+    while (i < count) {
+        const uint64_t to_wrap = step ? (CodeNCO::PHASE_PERIOD - phase + step - 1) / step : count;
+        const size_t run = static_cast<size_t>(std::min<uint64_t>(count - i, to_wrap));
+        for (size_t k = 0; k < run; ++k) {
+            const T chip = table[(phase + k * step) >> 32];
+            for (int r = 0; r < REPEAT; ++r) {
+                out[REPEAT * (i + k) + r] = chip;
+            }
+        }
+        phase += run * step;
+        if (phase >= CodeNCO::PHASE_PERIOD) {
+            phase -= CodeNCO::PHASE_PERIOD;
+        }
+        i += run;
+    }
+}
+
+}
+
+CodeNCO::CodeNCO(int prn, double sample_rate)
+    : prn_(0)
+    , sample_rate_(sample_rate)
+    , spacing_(std::max<long>(1, std::lround(CORRELATOR_SPACING * sample_rate / GPS_CA_CODE_FREQ_HZ)))
+    , phase_(0)
+    , step_(0)
+    , table_(nullptr)
+    , table8_(nullptr) {
+    setPRN(prn);
+    setRate(GPS_CA_CODE_FREQ_HZ);
+}
+
+void CodeNCO::setPRN(int prn) {
+    if (prn < 1 || prn > GPS_MAX_SATELLITES) {
+        throw std::invalid_argument("Invalid PRN number");
+    }
+    prn_ = prn;
+    table_ = codeTables().codes[prn - 1].data();
+    table8_ = codeTables().codes8[prn - 1].data();
+}
+
+uint64_t CodeNCO::toPhaseWord(double chips) {
+    chips = std::fmod(chips, static_cast<double>(GPS_CA_CODE_LENGTH));
+    if (chips < 0.0) {
+        chips += GPS_CA_CODE_LENGTH;
+    }
+    uint64_t word = static_cast<uint64_t>(std::llround(chips * PHASE_ONE));
+    return word >= PHASE_PERIOD ? word - PHASE_PERIOD : word;
+}
+
+void CodeNCO::setPhase(double chips) {
+    phase_ = toPhaseWord(chips);
+}
+
+void CodeNCO::setRate(double chips_per_second) {
+    step_ = static_cast<uint64_t>(std::llround(chips_per_second / sample_rate_ * PHASE_ONE));
+}
+
+double CodeNCO::getPhase() const {
+    return static_cast<double>(phase_) / PHASE_ONE;
+}
+
+uint64_t CodeNCO::startPhase() const {
+    // Late edge of the extended replica, spacing_ samples before prompt
+    const uint64_t back = (spacing_ * step_) % PHASE_PERIOD;
+    return phase_ >= back ? phase_ - back : phase_ + PHASE_PERIOD - back;
+}
+
+void CodeNCO::generate(size_t length) {
+    replica_.resize(length + 2 * spacing_);
+    fillReplica<float, 1>(table_, startPhase(), step_, replica_.size(), replica_.data());
+    phase_ = (phase_ + (length * step_) % PHASE_PERIOD) % PHASE_PERIOD;
+}
+
+void CodeNCO::fill(uint64_t phase, size_t count, float* out) const {
+    fillReplica<float, 1>(table_, phase % PHASE_PERIOD, step_, count, out);
+}
+
+void CodeNCO::generate8(size_t length) {
+    replica8_.resize(2 * (length + 2 * spacing_));
+    fillReplica<int8_t, 2>(table8_, startPhase(), step_, length + 2 * spacing_, replica8_.data());
+    phase_ = (phase_ + (length * step_) % PHASE_PERIOD) % PHASE_PERIOD;
+}
+
+}
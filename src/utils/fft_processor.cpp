@@ -0,0 +1,553 @@
+#include "utils/fft_processor.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <utility>
+#include <immintrin.h>
+#include "utils/simd_dispatch.h"
+
+namespace gps {
+
+namespace {
+
+// Radices in stage order: small radices first so the expensive generic
+// butterflies run at a stride wide enough for the vector path.
+std::vector<size_t> factorize(size_t n) {
+    std::vector<size_t> twos_fours;
+    std::vector<size_t> odd;
+
+    size_t twos = 0;
+    while (n % 2 == 0) {
+        n /= 2;
+        twos++;
+    }
+    if (twos % 2) {
+        twos_fours.push_back(2);
+    }
+    for (size_t i = 0; i < twos / 2; i++) {
+        twos_fours.push_back(4);
+    }
+
+    for (size_t p = 3; p * p <= n; p += 2) {
+        while (n % p == 0) {
+            odd.push_back(p);
+            n /= p;
+        }
+    }
+    if (n > 1) {
+        odd.push_back(n);
+    }
+
+    twos_fours.insert(twos_fours.end(), odd.begin(), odd.end());
+    return twos_fours;
+}
+
+// exp(sign * 2*pi*i * num / den), with num reduced first for accuracy
+IQSample unitRoot(int sign, size_t num, size_t den) {
+    num %= den;
+    double angle = sign * 2.0 * M_PI * static_cast<double>(num) / static_cast<double>(den);
+    return IQSample(static_cast<float>(std::cos(angle)), static_cast<float>(std::sin(angle)));
+}
+
+// Multiply by -i (forward) or +i (inverse)
+inline IQSample rotateQuarter(const IQSample& v, bool forward) {
+    return forward ? IQSample(v.imag(), -v.real()) : IQSample(-v.imag(), v.real());
+}
+
+// Four complex floats times four complex floats
+GPS_TARGET_AVX2
+inline __m256 cmul(__m256 a, __m256 b) {
+    __m256 b_re = _mm256_moveldup_ps(b);
+    __m256 b_im = _mm256_movehdup_ps(b);
+    __m256 a_swap = _mm256_permute_ps(a, 0xB1);
+    return _mm256_fmaddsub_ps(a, b_re, _mm256_mul_ps(a_swap, b_im));
+}
+
+// Same complex value in all four lanes
+GPS_TARGET_AVX2
+inline __m256 broadcast(const IQSample& v) {
+    double bits;
+    std::memcpy(&bits, &v, sizeof(bits));
+    return _mm256_castpd_ps(_mm256_set1_pd(bits));
+}
+
+GPS_TARGET_AVX2
+inline __m256 rotateQuarter(__m256 v, bool forward) {
+    // Swap re/im, then negate the new imaginary (forward) or real (inverse)
+    __m256 swapped = _mm256_permute_ps(v, 0xB1);
+    const __m256 mask = forward ? _mm256_setr_ps(0.0f, -0.0f, 0.0f, -0.0f, 0.0f, -0.0f, 0.0f, -0.0f)
+                                : _mm256_setr_ps(-0.0f, 0.0f, -0.0f, 0.0f, -0.0f, 0.0f, -0.0f, 0.0f);
+    return _mm256_xor_ps(swapped, mask);
+}
+
+GPS_TARGET_AVX2
+inline __m256 load4(const IQSample* p) {
+    return _mm256_loadu_ps(reinterpret_cast<const float*>(p));
+}
+
+GPS_TARGET_AVX2
+inline void store4(IQSample* p, __m256 v) {
+    _mm256_storeu_ps(reinterpret_cast<float*>(p), v);
+}
+
+// Vector butterflies over q = 0, 4, 8... of one stride group; each returns
+// the first q it left for the scalar loop
+
+GPS_TARGET_AVX2
+size_t radix2AVX2(const IQSample* x0, const IQSample* x1, IQSample* y0, IQSample* y1,
+                  const IQSample& w, size_t s) {
+    const __m256 vw = broadcast(w);
+    size_t q = 0;
+    for (; q + 4 <= s; q += 4) {
+        __m256 a = load4(x0 + q);
+        __m256 b = load4(x1 + q);
+        store4(y0 + q, _mm256_add_ps(a, b));
+        store4(y1 + q, cmul(_mm256_sub_ps(a, b), vw));
+    }
+    return q;
+}
+
+GPS_TARGET_AVX2
+size_t radix4AVX2(const IQSample* const x[4], IQSample* const y[4],
+                  const IQSample* w, size_t s, bool forward) {
+    const __m256 vw1 = broadcast(w[0]);
+    const __m256 vw2 = broadcast(w[1]);
+    const __m256 vw3 = broadcast(w[2]);
+    size_t q = 0;
+    for (; q + 4 <= s; q += 4) {
+        __m256 a = load4(x[0] + q);
+        __m256 b = load4(x[1] + q);
+        __m256 c = load4(x[2] + q);
+        __m256 d = load4(x[3] + q);
+
+        __m256 t0 = _mm256_add_ps(a, c);
+        __m256 t1 = _mm256_sub_ps(a, c);
+        __m256 t2 = _mm256_add_ps(b, d);
+        __m256 t3 = rotateQuarter(_mm256_sub_ps(b, d), forward);
+
+        store4(y[0] + q, _mm256_add_ps(t0, t2));
+        store4(y[1] + q, cmul(_mm256_add_ps(t1, t3), vw1));
+        store4(y[2] + q, cmul(_mm256_sub_ps(t0, t2), vw2));
+        store4(y[3] + q, cmul(_mm256_sub_ps(t1, t3), vw3));
+    }
+    return q;
+}
+
+GPS_TARGET_AVX2
+size_t radixGenericAVX2(const IQSample* xp, IQSample* yp, const IQSample* w,
+                        const IQSample* roots, size_t p, size_t s, size_t m) {
+    size_t q = 0;
+    for (; q + 4 <= s; q += 4) {
+        for (size_t r = 0; r < p; r++) {
+            __m256 acc = load4(xp + q);
+            size_t idx = 0;
+            for (size_t k = 1; k < p; k++) {
+                idx += r;
+                if (idx >= p) {
+                    idx -= p;
+                }
+                acc = _mm256_add_ps(acc, cmul(load4(xp + k * s * m + q), broadcast(roots[idx])));
+            }
+            if (r > 0) {
+                acc = cmul(acc, broadcast(w[r - 1]));
+            }
+            store4(yp + r * s + q, acc);
+        }
+    }
+    return q;
+}
+
+} // namespace
+
+FFTPlan::FFTPlan(size_t n, FFTDirection direction)
+    : n_(n),
+      direction_(direction),
+      vector_(activeSimdLevel() >= SimdLevel::AVX2) {
+
+    if (n == 0) {
+        throw std::invalid_argument("FFT size must be positive");
+    }
+
+    const int sign = (direction == FFTDirection::FORWARD) ? -1 : 1;
+    std::vector<size_t> radices = factorize(n);
+
+    if (!radices.empty() && radices.back() > MAX_DIRECT_RADIX) {
+        // Bluestein: X_k = c_k * sum_j (x_j c_j) conj(c_{k-j}),
+        // c_j = exp(sign * pi*i * j^2 / n), as a circular convolution
+        size_t m = 1;
+        while (m < 2 * n - 1) {
+            m <<= 1;
+        }
+
+        chirp_.resize(n);
+        for (size_t j = 0; j < n; j++) {
+            // j^2 mod 2n keeps the angle small before it reaches floating point
+            size_t j2 = (j * j) % (2 * n);
+            chirp_[j] = unitRoot(sign, j2, 2 * n);
+        }
+
+        bluestein_forward_.reset(new FFTPlan(m, FFTDirection::FORWARD));
+        bluestein_inverse_.reset(new FFTPlan(m, FFTDirection::INVERSE));
+
+        // Fold the 1/m normalization of the convolution into the kernel
+        IQBuffer kernel(m, IQSample(0.0f, 0.0f));
+        const float scale = 1.0f / static_cast<float>(m);
+        kernel[0] = std::conj(chirp_[0]) * scale;
+        for (size_t j = 1; j < n; j++) {
+            kernel[j] = std::conj(chirp_[j]) * scale;
+            kernel[m - j] = kernel[j];
+        }
+
+        chirp_spectrum_.resize(m);
+        bluestein_forward_->execute(kernel.data(), chirp_spectrum_.data());
+        return;
+    }
+
+    size_t stride = 1;
+    size_t remaining = n;
+    for (size_t radix : radices) {
+        Stage stage;
+        stage.radix = radix;
+        stage.stride = stride;
+        stage.m = remaining / radix;
+        stage.twiddle_offset = twiddles_.size();
+        stage.root_offset = roots_.size();
+
+        // w^(r * pidx) for the sub-transform of length remaining
+        for (size_t pidx = 0; pidx < stage.m; pidx++) {
+            for (size_t r = 1; r < radix; r++) {
+                twiddles_.push_back(unitRoot(sign, r * pidx, remaining));
+            }
+        }
+
+        if (radix != 2 && radix != 4) {
+            for (size_t j = 0; j < radix; j++) {
+                roots_.push_back(unitRoot(sign, j, radix));
+            }
+        }
+
+        stages_.push_back(stage);
+        stride *= radix;
+        remaining /= radix;
+    }
+}
+
+void FFTPlan::execute(const IQSample* in, IQSample* out) const {
+    if (bluestein_forward_) {
+        executeBluestein(in, out);
+        return;
+    }
+
+    if (stages_.empty()) {
+        out[0] = in[0];
+        return;
+    }
+
+    thread_local IQBuffer scratch;
+    if (scratch.size() < 2 * n_) {
+        scratch.resize(2 * n_);
+    }
+
+    // Stages ping-pong between out and scratch; with an odd stage count the
+    // first write lands in out, so an aliased input must be copied first.
+    if (in == out && stages_.size() % 2 == 1) {
+        IQSample* copy = scratch.data() + n_;
+        std::copy(in, in + n_, copy);
+        runStages(copy, out, scratch.data());
+    } else {
+        runStages(in, out, scratch.data());
+    }
+}
+
+void FFTPlan::executeBatch(const IQSample* in, IQSample* out, size_t count, size_t distance) const {
+    for (size_t b = 0; b < count; b++) {
+        execute(in + b * distance, out + b * distance);
+    }
+}
+
+void FFTPlan::runStages(const IQSample* in, IQSample* out, IQSample* scratch) const {
+    const size_t num_stages = stages_.size();
+    const IQSample* src = in;
+
+    for (size_t s = 0; s < num_stages; s++) {
+        IQSample* dst = ((num_stages - 1 - s) % 2 == 0) ? out : scratch;
+        runStage(stages_[s], src, dst);
+        src = dst;
+    }
+}
+
+void FFTPlan::runStage(const Stage& stage, const IQSample* x, IQSample* y) const {
+    switch (stage.radix) {
+        case 2:
+            radix2(stage, x, y);
+            break;
+        case 4:
+            radix4(stage, x, y);
+            break;
+        default:
+            radixGeneric(stage, x, y);
+            break;
+    }
+}
+
+// Stockham stage: inputs x[q + s*(pidx + k*m)], outputs
+// y[q + s*(p*pidx + r)] = w^(r*pidx) * sum_k x_k * omega_p^(r*k)
+
+void FFTPlan::radix2(const Stage& stage, const IQSample* x, IQSample* y) const {
+    const size_t s = stage.stride;
+    const size_t m = stage.m;
+    const IQSample* tw = twiddles_.data() + stage.twiddle_offset;
+
+    for (size_t pidx = 0; pidx < m; pidx++) {
+        const IQSample* x0 = x + s * pidx;
+        const IQSample* x1 = x + s * (pidx + m);
+        IQSample* y0 = y + s * (2 * pidx);
+        IQSample* y1 = y0 + s;
+        const IQSample w = tw[pidx];
+
+        size_t q = vector_ ? radix2AVX2(x0, x1, y0, y1, w, s) : 0;
+        for (; q < s; q++) {
+            IQSample a = x0[q];
+            IQSample b = x1[q];
+            y0[q] = a + b;
+            y1[q] = (a - b) * w;
+        }
+    }
+}
+
+void FFTPlan::radix4(const Stage& stage, const IQSample* x, IQSample* y) const {
+    const size_t s = stage.stride;
+    const size_t m = stage.m;
+    const IQSample* tw = twiddles_.data() + stage.twiddle_offset;
+    const bool forward = (direction_ == FFTDirection::FORWARD);
+
+    for (size_t pidx = 0; pidx < m; pidx++) {
+        const IQSample* x0 = x + s * pidx;
+        const IQSample* x1 = x + s * (pidx + m);
+        const IQSample* x2 = x + s * (pidx + 2 * m);
+        const IQSample* x3 = x + s * (pidx + 3 * m);
+        IQSample* y0 = y + s * (4 * pidx);
+        IQSample* y1 = y0 + s;
+        IQSample* y2 = y1 + s;
+        IQSample* y3 = y2 + s;
+        const IQSample w1 = tw[3 * pidx];
+        const IQSample w2 = tw[3 * pidx + 1];
+        const IQSample w3 = tw[3 * pidx + 2];
+
+        size_t q = 0;
+        if (vector_) {
+            const IQSample* const xs[4] = {x0, x1, x2, x3};
+            IQSample* const ys[4] = {y0, y1, y2, y3};
+            q = radix4AVX2(xs, ys, tw + 3 * pidx, s, forward);
+        }
+        for (; q < s; q++) {
+            IQSample a = x0[q];
+            IQSample b = x1[q];
+            IQSample c = x2[q];
+            IQSample d = x3[q];
+
+            IQSample t0 = a + c;
+            IQSample t1 = a - c;
+            IQSample t2 = b + d;
+            IQSample t3 = rotateQuarter(b - d, forward);
+
+            y0[q] = t0 + t2;
+            y1[q] = (t1 + t3) * w1;
+            y2[q] = (t0 - t2) * w2;
+            y3[q] = (t1 - t3) * w3;
+        }
+    }
+}
+
+void FFTPlan::radixGeneric(const Stage& stage, const IQSample* x, IQSample* y) const {
+    const size_t p = stage.radix;
+    const size_t s = stage.stride;
+    const size_t m = stage.m;
+    const IQSample* tw = twiddles_.data() + stage.twiddle_offset;
+    const IQSample* roots = roots_.data() + stage.root_offset;
+
+    for (size_t pidx = 0; pidx < m; pidx++) {
+        const IQSample* xp = x + s * pidx;
+        IQSample* yp = y + s * (p * pidx);
+        const IQSample* w = tw + (p - 1) * pidx;
+
+        size_t q = vector_ ? radixGenericAVX2(xp, yp, w, roots, p, s, m) : 0;
+        for (; q < s; q++) {
+            for (size_t r = 0; r < p; r++) {
+                IQSample acc = xp[q];
+                size_t idx = 0;
+                for (size_t k = 1; k < p; k++) {
+                    idx += r;
+                    if (idx >= p) {
+                        idx -= p;
+                    }
+                    acc += xp[k * s * m + q] * roots[idx];
+                }
+                if (r > 0) {
+                    acc *= w[r - 1];
+                }
+                yp[r * s + q] = acc;
+            }
+        }
+    }
+}
+
+void FFTPlan::executeBluestein(const IQSample* in, IQSample* out) const {
+    const size_t m = chirp_spectrum_.size();
+
+    thread_local IQBuffer work;
+    if (work.size() < m) {
+        work.resize(m);
+    }
+
+    for (size_t j = 0; j < n_; j++) {
+        work[j] = in[j] * chirp_[j];
+    }
+    std::fill(work.begin() + n_, work.begin() + m, IQSample(0.0f, 0.0f));
+
+    bluestein_forward_->execute(work.data());
+    for (size_t k = 0; k < m; k++) {
+        work[k] *= chirp_spectrum_[k];
+    }
+    bluestein_inverse_->execute(work.data());
+
+    for (size_t k = 0; k < n_; k++) {
+        out[k] = work[k] * chirp_[k];
+    }
+}
+
+RealFFTPlan::RealFFTPlan(size_t n)
+    : n_(n) {
+
+    if (n < 2 || n % 2 != 0) {
+        throw std::invalid_argument("Real FFT size must be even");
+    }
+
+    const size_t half = n / 2;
+    half_forward_ = FFTProcessor::getPlan(half, FFTDirection::FORWARD);
+    half_inverse_ = FFTProcessor::getPlan(half, FFTDirection::INVERSE);
+
+    twiddles_.resize(half + 1);
+    for (size_t k = 0; k <= half; k++) {
+        twiddles_[k] = unitRoot(-1, k, n);
+    }
+}
+
+void RealFFTPlan::forward(const float* in, IQSample* out) const {
+    const size_t half = n_ / 2;
+
+    // Even/odd samples packed as one complex sequence; out holds n/2 + 1
+    // bins so the half-size transform can run in place there.
+    std::memcpy(reinterpret_cast<float*>(out), in, n_ * sizeof(float));
+    half_forward_->execute(out);
+
+    // X_k = E_k + W^k O_k with E/O split from Z_k and conj(Z_{h-k})
+    const IQSample z0 = out[0];
+    out[0] = IQSample(z0.real() + z0.imag(), 0.0f);
+    out[half] = IQSample(z0.real() - z0.imag(), 0.0f);
+
+    for (size_t k = 1; k <= half / 2; k++) {
+        const size_t j = half - k;
+        const IQSample zk = out[k];
+        const IQSample zj = out[j];
+
+        const IQSample ek = 0.5f * (zk + std::conj(zj));
+        const IQSample ok = IQSample(0.0f, -0.5f) * (zk - std::conj(zj));
+        const IQSample ej = 0.5f * (zj + std::conj(zk));
+        const IQSample oj = IQSample(0.0f, -0.5f) * (zj - std::conj(zk));
+
+        out[k] = ek + twiddles_[k] * ok;
+        out[j] = ej + twiddles_[j] * oj;
+    }
+}
+
+void RealFFTPlan::inverse(const IQSample* in, float* out) const {
+    const size_t half = n_ / 2;
+
+    thread_local IQBuffer packed;
+    if (packed.size() < half) {
+        packed.resize(half);
+    }
+
+    // Z_k = E_k + i O_k, unscaled so the result is n times the input
+    for (size_t k = 0; k < half; k++) {
+        const IQSample xk = in[k];
+        const IQSample xj = std::conj(in[half - k]);
+        const IQSample ek = xk + xj;
+        const IQSample ok = (xk - xj) * std::conj(twiddles_[k]);
+        packed[k] = ek + IQSample(0.0f, 1.0f) * ok;
+    }
+
+    half_inverse_->execute(packed.data());
+    std::memcpy(out, packed.data(), n_ * sizeof(float));
+}
+
+namespace {
+
+std::mutex& cacheMutex() {
+    static std::mutex mutex;
+    return mutex;
+}
+
+std::map<std::pair<size_t, FFTDirection>, std::shared_ptr<const FFTPlan>>& planCache() {
+    static std::map<std::pair<size_t, FFTDirection>, std::shared_ptr<const FFTPlan>> cache;
+    return cache;
+}
+
+std::map<size_t, std::shared_ptr<const RealFFTPlan>>& realPlanCache() {
+    static std::map<size_t, std::shared_ptr<const RealFFTPlan>> cache;
+    return cache;
+}
+
+} // namespace
+
+std::shared_ptr<const FFTPlan> FFTProcessor::getPlan(size_t n, FFTDirection direction) {
+    auto key = std::make_pair(n, direction);
+    {
+        std::lock_guard<std::mutex> lock(cacheMutex());
+        auto it = planCache().find(key);
+        if (it != planCache().end()) {
+            return it->second;
+        }
+    }
+
+    // Build outside the lock; if two threads race, the first insert wins
+    auto plan = std::make_shared<const FFTPlan>(n, direction);
+
+    std::lock_guard<std::mutex> lock(cacheMutex());
+    return planCache().emplace(key, plan).first->second;
+}
+
+std::shared_ptr<const RealFFTPlan> FFTProcessor::getRealPlan(size_t n) {
+    {
+        std::lock_guard<std::mutex> lock(cacheMutex());
+        auto it = realPlanCache().find(n);
+        if (it != realPlanCache().end()) {
+            return it->second;
+        }
+    }
+
+    auto plan = std::make_shared<const RealFFTPlan>(n);
+
+    std::lock_guard<std::mutex> lock(cacheMutex());
+    return realPlanCache().emplace(n, plan).first->second;
+}
+
+void FFTProcessor::forward(const IQSample* in, IQSample* out, size_t n) {
+    getPlan(n, FFTDirection::FORWARD)->execute(in, out);
+}
+
+void FFTProcessor::inverse(const IQSample* in, IQSample* out, size_t n) {
+    getPlan(n, FFTDirection::INVERSE)->execute(in, out);
+}
+
+void FFTProcessor::clearCache() {
+    std::lock_guard<std::mutex> lock(cacheMutex());
+    planCache().clear();
+    realPlanCache().clear();
+}
+
+}
@@ -0,0 +1,246 @@
+#include "utils/hot_start.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+namespace gps {
+
+namespace {
+
+static_assert(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__,
+              "Hot start records are stored in host byte order");
+
+constexpr uint32_t HOT_START_MAGIC = 0x54534847;   // "GHST"
+// Bump whenever a record below changes
+constexpr uint16_t HOT_START_VERSION = 2;
+
+struct FileHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t header_size;
+    uint32_t payload_size;
+    uint32_t checksum;      // CRC-32 of the payload
+    double saved_time;
+};
+static_assert(sizeof(FileHeader) == 24, "Hot start header layout changed");
+
+struct EphemerisRecord {
+    int32_t prn;
+    uint32_t valid;
+    double toe;
+    double sqrt_a;
+    double ecc;
+    double i0;
+    double omega0;
+    double w;
+    double m0;
+};
+static_assert(sizeof(EphemerisRecord) == 64, "Ephemeris record layout changed");
+
+struct ChannelRecord {
+    int32_t prn;
+    uint32_t tracked;
+    double doppler_shift;
+    double code_phase;
+    double carrier_phase;
+    double cn0;
+};
+static_assert(sizeof(ChannelRecord) == 40, "Channel record layout changed");
+
+struct AlmanacRecord {
+    int32_t prn;
+    uint32_t valid;
+    int32_t health;
+    uint32_t reserved;
+    double toa;
+    double ecc;
+    double i0;
+    double omega_dot;
+    double sqrt_a;
+    double omega0;
+    double w;
+    double m0;
+    double af0;
+    double af1;
+};
+static_assert(sizeof(AlmanacRecord) == 96, "Almanac record layout changed");
+
+// PRN 1 first
+struct Payload {
+    EphemerisRecord ephemeris[GPS_MAX_SATELLITES];
+    ChannelRecord channels[GPS_MAX_SATELLITES];
+    AlmanacRecord almanac[GPS_MAX_SATELLITES];
+};
+
+struct CrcTable {
+    uint32_t entries[256];
+
+    constexpr CrcTable() : entries{} {
+        for (uint32_t n = 0; n < 256; ++n) {
+            uint32_t c = n;
+            for (int k = 0; k < 8; ++k) {
+                c = (c & 1u) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            }
+            entries[n] = c;
+        }
+    }
+};
+
+constexpr CrcTable CRC_TABLE;
+
+bool writeAll(int fd, const void* data, size_t length) {
+    const char* bytes = static_cast<const char*>(data);
+    while (length > 0) {
+        const ssize_t written = ::write(fd, bytes, length);
+        if (written <= 0) {
+            return false;
+        }
+        bytes += written;
+        length -= static_cast<size_t>(written);
+    }
+    return true;
+}
+
+}
+
+uint32_t crc32(const void* data, size_t length) {
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    uint32_t crc = 0xFFFFFFFFu;
+    for (size_t i = 0; i < length; ++i) {
+        crc = CRC_TABLE.entries[(crc ^ bytes[i]) & 0xFFu] ^ (crc >> 8);
+    }
+    return crc ^ 0xFFFFFFFFu;
+}
+
+bool ephemerisCurrent(const EphemerisData& ephemeris, double time_of_week) {
+    double from_toe = std::fabs(time_of_week - ephemeris.toe);
+    if (from_toe > GPS_WEEK_SECONDS / 2) {
+        from_toe = GPS_WEEK_SECONDS - from_toe;
+    }
+    return from_toe <= HOT_START_EPHEMERIS_AGE / 2;
+}
+
+bool saveHotStart(const std::string& path, const HotStartState& state) {
+    Payload payload;
+    std::memset(&payload, 0, sizeof(payload));
+    for (int prn = 1; prn <= GPS_MAX_SATELLITES; ++prn) {
+        const EphemerisData& eph = state.ephemeris[prn];
+        payload.ephemeris[prn - 1] = EphemerisRecord{
+            prn, state.ephemeris_valid[prn] ? 1u : 0u,
+            eph.toe, eph.sqrt_a, eph.ecc, eph.i0, eph.omega0, eph.w, eph.m0};
+
+        const SatelliteInfo& info = state.channels[prn];
+        payload.channels[prn - 1] = ChannelRecord{
+            prn, info.is_tracked ? 1u : 0u,
+            info.doppler_shift, info.code_phase, info.carrier_phase, info.cn0};
+
+        const AlmanacData& alm = state.almanac[prn];
+        payload.almanac[prn - 1] = AlmanacRecord{
+            prn, state.almanac_valid[prn] ? 1u : 0u, alm.health, 0u,
+            alm.toa, alm.ecc, alm.i0, alm.omega_dot, alm.sqrt_a, alm.omega0, alm.w, alm.m0,
+            alm.af0, alm.af1};
+    }
+
+    FileHeader header;
+    std::memset(&header, 0, sizeof(header));
+    header.magic = HOT_START_MAGIC;
+    header.version = HOT_START_VERSION;
+    header.header_size = sizeof(FileHeader);
+    header.payload_size = sizeof(Payload);
+    header.checksum = crc32(&payload, sizeof(payload));
+    header.saved_time = state.saved_time;
+
+    const std::string temp_path = path + ".tmp";
+    const int fd = ::open(temp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        std::cerr << "Failed to create hot start file: " << temp_path << std::endl;
+        return false;
+    }
+    const bool written = writeAll(fd, &header, sizeof(header))
+                      && writeAll(fd, &payload, sizeof(payload))
+                      && ::fsync(fd) == 0;
+    ::close(fd);
+
+    if (!written || std::rename(temp_path.c_str(), path.c_str()) != 0) {
+        std::cerr << "Failed to write hot start file: " << path << std::endl;
+        ::unlink(temp_path.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool loadHotStart(const std::string& path, HotStartState& state) {
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) < 0 || static_cast<size_t>(st.st_size) < sizeof(FileHeader)) {
+        std::cerr << "Hot start file is truncated: " << path << std::endl;
+        ::close(fd);
+        return false;
+    }
+    const size_t map_size = static_cast<size_t>(st.st_size);
+    void* addr = mmap(nullptr, map_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (addr == MAP_FAILED) {
+        std::cerr << "Failed to map hot start file: " << path << std::endl;
+        return false;
+    }
+    const uint8_t* map = static_cast<const uint8_t*>(addr);
+
+    FileHeader header;
+    std::memcpy(&header, map, sizeof(header));
+
+    bool valid = false;
+    if (header.magic != HOT_START_MAGIC) {
+        std::cerr << "Not a hot start file: " << path << std::endl;
+    } else if (header.version != HOT_START_VERSION) {
+        std::cerr << "Hot start file has format version " << header.version
+                  << ", expected " << HOT_START_VERSION << std::endl;
+    } else if (header.header_size != sizeof(FileHeader) || header.payload_size != sizeof(Payload)
+               || map_size != sizeof(FileHeader) + sizeof(Payload)) {
+        std::cerr << "Hot start file is truncated: " << path << std::endl;
+    } else if (crc32(map + sizeof(FileHeader), sizeof(Payload)) != header.checksum) {
+        std::cerr << "Hot start file checksum mismatch: " << path << std::endl;
+    } else {
+        valid = true;
+    }
+
+    if (valid) {
+        Payload payload;
+        std::memcpy(&payload, map + sizeof(FileHeader), sizeof(payload));
+
+        HotStartState loaded;
+        loaded.saved_time = header.saved_time;
+        for (int prn = 1; prn <= GPS_MAX_SATELLITES; ++prn) {
+            const EphemerisRecord& eph = payload.ephemeris[prn - 1];
+            loaded.ephemeris[prn] = EphemerisData{prn, eph.toe, eph.sqrt_a, eph.ecc,
+                                                  eph.i0, eph.omega0, eph.w, eph.m0};
+            loaded.ephemeris_valid[prn] = eph.valid != 0;
+
+            const ChannelRecord& channel = payload.channels[prn - 1];
+            loaded.channels[prn] = SatelliteInfo{prn, channel.doppler_shift, channel.code_phase,
+                                                 channel.carrier_phase, channel.cn0,
+                                                 channel.tracked != 0, eph.valid != 0};
+
+            const AlmanacRecord& alm = payload.almanac[prn - 1];
+            loaded.almanac[prn] = AlmanacData{prn, alm.health, alm.toa, alm.ecc, alm.i0,
+                                              alm.omega_dot, alm.sqrt_a, alm.omega0, alm.w,
+                                              alm.m0, alm.af0, alm.af1};
+            loaded.almanac_valid[prn] = alm.valid != 0;
+        }
+        state = loaded;
+    }
+
+    munmap(addr, map_size);
+    return valid;
+}
+
+}
@@ -0,0 +1,434 @@
+#include "utils/iq_converter.h"
+#include <algorithm>
+#include <cmath>
+#include <immintrin.h>
+#include "utils/simd_dispatch.h"
+
+namespace gps {
+
+namespace {
+
+constexpr float RTL_OFFSET = 127.5f;
+constexpr float RTL_SCALE = 1.0f / 127.5f;
+
+// Largest phase imbalance we are willing to correct (~30 degrees)
+constexpr float MAX_PHASE_ERROR = 0.52f;
+
+// Front-end correction applied by the corrected kernels
+struct Correction {
+    float dc_i;
+    float dc_q;
+    float a;
+    float b;
+};
+
+// Each kernel converts a vector-sized prefix and returns how many samples
+// (bytes for int8) it handled; the caller finishes the tail with the
+// lookup table. Statistics are written to sums as I, Q, II, QQ, IQ.
+using PlainKernel = size_t (*)(const uint8_t*, size_t, float*);
+using CorrectedKernel = size_t (*)(const uint8_t*, size_t, float*, const Correction&, float*);
+using Int8Kernel = size_t (*)(const uint8_t*, size_t, int8_t*);
+
+size_t convertPlainScalar(const uint8_t*, size_t, float*) {
+    return 0;
+}
+
+size_t convertCorrectedScalar(const uint8_t*, size_t, float*, const Correction&, float* sums) {
+    std::fill(sums, sums + 5, 0.0f);
+    return 0;
+}
+
+size_t convertInt8Scalar(const uint8_t*, size_t, int8_t*) {
+    return 0;
+}
+
+// Widen 8 bytes (4 IQ pairs) to two vectors of 4 floats
+GPS_TARGET_SSE4
+inline void loadBytesSSE(const uint8_t* p, __m128& lo, __m128& hi) {
+    const __m128i zero = _mm_setzero_si128();
+    __m128i bytes = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(p));
+    __m128i words = _mm_unpacklo_epi8(bytes, zero);
+    lo = _mm_cvtepi32_ps(_mm_unpacklo_epi16(words, zero));
+    hi = _mm_cvtepi32_ps(_mm_unpackhi_epi16(words, zero));
+}
+
+GPS_TARGET_SSE4
+inline __m128 dupI(__m128 v) { return _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 2, 0, 0)); }
+GPS_TARGET_SSE4
+inline __m128 dupQ(__m128 v) { return _mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 3, 1, 1)); }
+
+GPS_TARGET_SSE4
+inline float sumEven(__m128 v) {
+    alignas(16) float lanes[4];
+    _mm_store_ps(lanes, v);
+    return lanes[0] + lanes[2];
+}
+
+GPS_TARGET_SSE4
+inline float sumOdd(__m128 v) {
+    alignas(16) float lanes[4];
+    _mm_store_ps(lanes, v);
+    return lanes[1] + lanes[3];
+}
+
+GPS_TARGET_SSE4
+size_t convertPlainSSE4(const uint8_t* raw_data, size_t num_samples, float* out) {
+    const __m128 scale = _mm_set1_ps(RTL_SCALE);
+    const __m128 bias = _mm_set1_ps(-1.0f);
+
+    size_t n = 0;
+    for (; n + 4 <= num_samples; n += 4) {
+        __m128 lo, hi;
+        loadBytesSSE(raw_data + 2 * n, lo, hi);
+        _mm_storeu_ps(out + 2 * n, _mm_add_ps(_mm_mul_ps(lo, scale), bias));
+        _mm_storeu_ps(out + 2 * n + 4, _mm_add_ps(_mm_mul_ps(hi, scale), bias));
+    }
+    return n;
+}
+
+GPS_TARGET_SSE4
+size_t convertCorrectedSSE4(const uint8_t* raw_data, size_t num_samples, float* out,
+                            const Correction& c, float* sums) {
+    const __m128 scale = _mm_set1_ps(RTL_SCALE);
+    const __m128 bias = _mm_setr_ps(-1.0f - c.dc_i, -1.0f - c.dc_q, -1.0f - c.dc_i, -1.0f - c.dc_q);
+    const __m128 coef_a = _mm_setr_ps(0.0f, c.a, 0.0f, c.a);
+    const __m128 coef_b = _mm_setr_ps(1.0f, c.b, 1.0f, c.b);
+
+    __m128 acc_sum = _mm_setzero_ps();
+    __m128 acc_sq = _mm_setzero_ps();
+    __m128 acc_xy = _mm_setzero_ps();
+
+    size_t n = 0;
+    for (; n + 4 <= num_samples; n += 4) {
+        __m128 raw[2];
+        loadBytesSSE(raw_data + 2 * n, raw[0], raw[1]);
+
+        for (int h = 0; h < 2; ++h) {
+            __m128 y = _mm_add_ps(_mm_mul_ps(raw[h], scale), bias);
+            __m128 y_i = dupI(y);
+
+            acc_sum = _mm_add_ps(acc_sum, y);
+            acc_sq = _mm_add_ps(acc_sq, _mm_mul_ps(y, y));
+            acc_xy = _mm_add_ps(acc_xy, _mm_mul_ps(y_i, dupQ(y)));
+
+            __m128 corrected = _mm_add_ps(_mm_mul_ps(y_i, coef_a), _mm_mul_ps(y, coef_b));
+            _mm_storeu_ps(out + 2 * n + 4 * h, corrected);
+        }
+    }
+
+    sums[0] = sumEven(acc_sum);
+    sums[1] = sumOdd(acc_sum);
+    sums[2] = sumEven(acc_sq);
+    sums[3] = sumOdd(acc_sq);
+    sums[4] = sumEven(acc_xy);
+    return n;
+}
+
+// max(u, 1) ^ 0x80 maps 0..255 to -127..127, keeping -128 out of the
+// integer correlators where negating it would overflow
+GPS_TARGET_SSE4
+size_t convertInt8SSE4(const uint8_t* raw_data, size_t num_bytes, int8_t* out) {
+    const __m128i one = _mm_set1_epi8(1);
+    const __m128i flip = _mm_set1_epi8(static_cast<char>(0x80));
+
+    size_t n = 0;
+    for (; n + 16 <= num_bytes; n += 16) {
+        __m128i u = _mm_loadu_si128(reinterpret_cast<const __m128i*>(raw_data + n));
+        u = _mm_xor_si128(_mm_max_epu8(u, one), flip);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + n), u);
+    }
+    return n;
+}
+
+// Widen 8 bytes (4 IQ pairs) to 8 floats, still interleaved I,Q,I,Q...
+GPS_TARGET_AVX2
+inline __m256 loadBytesAVX(const uint8_t* p) {
+    __m128i bytes = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(p));
+    return _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(bytes));
+}
+
+GPS_TARGET_AVX2
+inline float sumEven(__m256 v) {
+    alignas(32) float lanes[8];
+    _mm256_store_ps(lanes, v);
+    return lanes[0] + lanes[2] + lanes[4] + lanes[6];
+}
+
+GPS_TARGET_AVX2
+inline float sumOdd(__m256 v) {
+    alignas(32) float lanes[8];
+    _mm256_store_ps(lanes, v);
+    return lanes[1] + lanes[3] + lanes[5] + lanes[7];
+}
+
+GPS_TARGET_AVX2
+size_t convertPlainAVX2(const uint8_t* raw_data, size_t num_samples, float* out) {
+    const __m256 scale = _mm256_set1_ps(RTL_SCALE);
+    const __m256 bias = _mm256_set1_ps(-1.0f);
+
+    // 8 samples (16 bytes) per iteration
+    size_t n = 0;
+    for (; n + 8 <= num_samples; n += 8) {
+        __m256 lo = loadBytesAVX(raw_data + 2 * n);
+        __m256 hi = loadBytesAVX(raw_data + 2 * n + 8);
+        _mm256_storeu_ps(out + 2 * n, _mm256_fmadd_ps(lo, scale, bias));
+        _mm256_storeu_ps(out + 2 * n + 8, _mm256_fmadd_ps(hi, scale, bias));
+    }
+    return n;
+}
+
+GPS_TARGET_AVX2
+size_t convertCorrectedAVX2(const uint8_t* raw_data, size_t num_samples, float* out,
+                            const Correction& c, float* sums) {
+    const __m256 scale = _mm256_set1_ps(RTL_SCALE);
+    const __m256 bias = _mm256_setr_ps(-1.0f - c.dc_i, -1.0f - c.dc_q, -1.0f - c.dc_i, -1.0f - c.dc_q,
+                                       -1.0f - c.dc_i, -1.0f - c.dc_q, -1.0f - c.dc_i, -1.0f - c.dc_q);
+    // Q' = a*I + b*Q, I' = I
+    const __m256 coef_a = _mm256_setr_ps(0.0f, c.a, 0.0f, c.a, 0.0f, c.a, 0.0f, c.a);
+    const __m256 coef_b = _mm256_setr_ps(1.0f, c.b, 1.0f, c.b, 1.0f, c.b, 1.0f, c.b);
+
+    __m256 acc_sum = _mm256_setzero_ps();
+    __m256 acc_sq = _mm256_setzero_ps();
+    __m256 acc_xy = _mm256_setzero_ps();
+
+    size_t n = 0;
+    for (; n + 4 <= num_samples; n += 4) {
+        // DC-removed samples
+        __m256 y = _mm256_fmadd_ps(loadBytesAVX(raw_data + 2 * n), scale, bias);
+        __m256 y_i = _mm256_moveldup_ps(y);
+
+        acc_sum = _mm256_add_ps(acc_sum, y);
+        acc_sq = _mm256_fmadd_ps(y, y, acc_sq);
+        acc_xy = _mm256_fmadd_ps(y_i, _mm256_movehdup_ps(y), acc_xy);
+
+        _mm256_storeu_ps(out + 2 * n, _mm256_fmadd_ps(y_i, coef_a, _mm256_mul_ps(y, coef_b)));
+    }
+
+    sums[0] = sumEven(acc_sum);
+    sums[1] = sumOdd(acc_sum);
+    sums[2] = sumEven(acc_sq);
+    sums[3] = sumOdd(acc_sq);
+    sums[4] = sumEven(acc_xy);
+    return n;
+}
+
+GPS_TARGET_AVX2
+size_t convertInt8AVX2(const uint8_t* raw_data, size_t num_bytes, int8_t* out) {
+    const __m256i one = _mm256_set1_epi8(1);
+    const __m256i flip = _mm256_set1_epi8(static_cast<char>(0x80));
+
+    size_t n = 0;
+    for (; n + 32 <= num_bytes; n += 32) {
+        __m256i u = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(raw_data + n));
+        u = _mm256_xor_si256(_mm256_max_epu8(u, one), flip);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + n), u);
+    }
+    return n;
+}
+
+GPS_AVX512_BEGIN
+
+GPS_TARGET_AVX512
+size_t convertPlainAVX512(const uint8_t* raw_data, size_t num_samples, float* out) {
+    const __m512 scale = _mm512_set1_ps(RTL_SCALE);
+    const __m512 bias = _mm512_set1_ps(-1.0f);
+
+    // 16 samples (32 bytes) per iteration
+    size_t n = 0;
+    for (; n + 16 <= num_samples; n += 16) {
+        __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(raw_data + 2 * n));
+        __m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(raw_data + 2 * n + 16));
+        __m512 lo_f = _mm512_cvtepi32_ps(_mm512_cvtepu8_epi32(lo));
+        __m512 hi_f = _mm512_cvtepi32_ps(_mm512_cvtepu8_epi32(hi));
+        _mm512_storeu_ps(out + 2 * n, _mm512_fmadd_ps(lo_f, scale, bias));
+        _mm512_storeu_ps(out + 2 * n + 16, _mm512_fmadd_ps(hi_f, scale, bias));
+    }
+    return n;
+}
+
+GPS_TARGET_AVX512
+size_t convertInt8AVX512(const uint8_t* raw_data, size_t num_bytes, int8_t* out) {
+    const __m512i one = _mm512_set1_epi8(1);
+    const __m512i flip = _mm512_set1_epi8(static_cast<char>(0x80));
+
+    size_t n = 0;
+    for (; n + 64 <= num_bytes; n += 64) {
+        __m512i u = _mm512_loadu_si512(raw_data + n);
+        u = _mm512_xor_si512(_mm512_max_epu8(u, one), flip);
+        _mm512_storeu_si512(out + n, u);
+    }
+    return n;
+}
+
+GPS_AVX512_END
+
+// The corrected path gathers I/Q statistics with lane shuffles that gain
+// nothing at 512 bits, so it tops out at AVX2
+const KernelSet<PlainKernel> kPlainKernels = {
+    convertPlainScalar, convertPlainSSE4, convertPlainAVX2, convertPlainAVX512};
+const KernelSet<CorrectedKernel> kCorrectedKernels = {
+    convertCorrectedScalar, convertCorrectedSSE4, convertCorrectedAVX2, nullptr};
+const KernelSet<Int8Kernel> kInt8Kernels = {
+    convertInt8Scalar, convertInt8SSE4, convertInt8AVX2, convertInt8AVX512};
+
+}
+
+IQConverter::IQConverter()
+    : dc_removal_(false)
+    , imbalance_correction_(false)
+    , dc_alpha_(0.1f)
+    , imbalance_alpha_(0.1f) {
+    for (int b = 0; b < 256; ++b) {
+        lut_[b] = (b - RTL_OFFSET) * RTL_SCALE;
+    }
+    reset();
+}
+
+void IQConverter::setDCRemoval(bool enable, float alpha) {
+    dc_removal_ = enable;
+    dc_alpha_ = alpha;
+    if (!enable) {
+        dc_i_ = 0.0f;
+        dc_q_ = 0.0f;
+    }
+}
+
+void IQConverter::setImbalanceCorrection(bool enable, float alpha) {
+    imbalance_correction_ = enable;
+    imbalance_alpha_ = alpha;
+    if (!enable) {
+        iq_a_ = 0.0f;
+        iq_b_ = 1.0f;
+    }
+}
+
+void IQConverter::reset() {
+    dc_i_ = 0.0f;
+    dc_q_ = 0.0f;
+    gain_ratio_ = 1.0f;
+    phase_error_ = 0.0f;
+    iq_a_ = 0.0f;
+    iq_b_ = 1.0f;
+    acc_i_ = acc_q_ = 0.0;
+    acc_ii_ = acc_qq_ = acc_iq_ = 0.0;
+    acc_count_ = 0;
+}
+
+void IQConverter::convert(const uint8_t* raw_data, size_t num_samples, IQSample* iq_data) {
+    if (!dc_removal_ && !imbalance_correction_) {
+        convertPlain(raw_data, num_samples, iq_data);
+        return;
+    }
+
+    // Apply estimates in chunks so they are refreshed every ESTIMATE_INTERVAL
+    while (num_samples > 0) {
+        size_t chunk = std::min(num_samples, ESTIMATE_INTERVAL - acc_count_);
+        convertCorrected(raw_data, chunk, iq_data);
+        acc_count_ += chunk;
+        if (acc_count_ >= ESTIMATE_INTERVAL) {
+            updateEstimates();
+        }
+        raw_data += chunk * 2;
+        iq_data += chunk;
+        num_samples -= chunk;
+    }
+}
+
+void IQConverter::convertInt8(const uint8_t* raw_data, size_t num_samples, IQSample8* iq_data) {
+    static const Int8Kernel kernel = kInt8Kernels.select();
+    int8_t* out = reinterpret_cast<int8_t*>(iq_data);
+    const size_t num_bytes = num_samples * 2;
+
+    for (size_t n = kernel(raw_data, num_bytes, out); n < num_bytes; ++n) {
+        out[n] = static_cast<int8_t>(std::max<int>(raw_data[n], 1) - 128);
+    }
+}
+
+void IQConverter::quantizeInt8(const IQSample* samples, size_t num_samples, IQSample8* iq_data) {
+    auto quantize = [](float x) {
+        float v = std::nearbyint(x * INT8_SAMPLE_SCALE);
+        return static_cast<int8_t>(std::max(-127.0f, std::min(127.0f, v)));
+    };
+
+    for (size_t n = 0; n < num_samples; ++n) {
+        iq_data[n].i = quantize(samples[n].real());
+        iq_data[n].q = quantize(samples[n].imag());
+    }
+}
+
+void IQConverter::convertPlain(const uint8_t* raw_data, size_t num_samples, IQSample* iq_data) {
+    static const PlainKernel kernel = kPlainKernels.select();
+    float* out = reinterpret_cast<float*>(iq_data);
+
+    for (size_t n = kernel(raw_data, num_samples, out); n < num_samples; ++n) {
+        out[2 * n] = lut_[raw_data[2 * n]];
+        out[2 * n + 1] = lut_[raw_data[2 * n + 1]];
+    }
+}
+
+void IQConverter::convertCorrected(const uint8_t* raw_data, size_t num_samples, IQSample* iq_data) {
+    static const CorrectedKernel kernel = kCorrectedKernels.select();
+    float* out = reinterpret_cast<float*>(iq_data);
+
+    float sums[5];
+    size_t n = kernel(raw_data, num_samples, out, Correction{dc_i_, dc_q_, iq_a_, iq_b_}, sums);
+    float sum_i = sums[0], sum_q = sums[1];
+    float sum_ii = sums[2], sum_qq = sums[3], sum_iq = sums[4];
+
+    for (; n < num_samples; ++n) {
+        float y_i = lut_[raw_data[2 * n]] - dc_i_;
+        float y_q = lut_[raw_data[2 * n + 1]] - dc_q_;
+
+        sum_i += y_i;
+        sum_q += y_q;
+        sum_ii += y_i * y_i;
+        sum_qq += y_q * y_q;
+        sum_iq += y_i * y_q;
+
+        out[2 * n] = y_i;
+        out[2 * n + 1] = iq_a_ * y_i + iq_b_ * y_q;
+    }
+
+    acc_i_ += sum_i;
+    acc_q_ += sum_q;
+    acc_ii_ += sum_ii;
+    acc_qq_ += sum_qq;
+    acc_iq_ += sum_iq;
+}
+
+void IQConverter::updateEstimates() {
+    const double count = static_cast<double>(acc_count_);
+    const double mean_i = acc_i_ / count;
+    const double mean_q = acc_q_ / count;
+
+    if (dc_removal_) {
+        dc_i_ += dc_alpha_ * static_cast<float>(mean_i);
+        dc_q_ += dc_alpha_ * static_cast<float>(mean_q);
+    }
+
+    if (imbalance_correction_) {
+        const double p_i = acc_ii_ / count - mean_i * mean_i;
+        const double p_q = acc_qq_ / count - mean_q * mean_q;
+        const double c_iq = acc_iq_ / count - mean_i * mean_q;
+
+        if (p_i > 0.0 && p_q > 0.0) {
+            float gain = static_cast<float>(std::sqrt(p_q / p_i));
+            float sin_phi = static_cast<float>(c_iq / std::sqrt(p_i * p_q));
+            float phase = std::asin(std::max(-1.0f, std::min(1.0f, sin_phi)));
+            phase = std::max(-MAX_PHASE_ERROR, std::min(MAX_PHASE_ERROR, phase));
+
+            gain_ratio_ += imbalance_alpha_ * (gain - gain_ratio_);
+            phase_error_ += imbalance_alpha_ * (phase - phase_error_);
+
+            // Q' = (Q / g - I sin(phi)) / cos(phi)
+            iq_a_ = -std::tan(phase_error_);
+            iq_b_ = 1.0f / (gain_ratio_ * std::cos(phase_error_));
+        }
+    }
+
+    acc_i_ = acc_q_ = 0.0;
+    acc_ii_ = acc_qq_ = acc_iq_ = 0.0;
+    acc_count_ = 0;
+}
+
+}
\ No newline at end of file
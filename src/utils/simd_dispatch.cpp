@@ -0,0 +1,113 @@
+#include "utils/simd_dispatch.h"
+#include <atomic>
+#include <cpuid.h>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+
+namespace gps {
+
+namespace {
+
+// XCR0: which register states the OS saves on context switch
+uint64_t readXCR0() {
+    uint32_t eax, edx;
+    __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+    return (static_cast<uint64_t>(edx) << 32) | eax;
+}
+
+SimdLevel probe() {
+    unsigned eax, ebx, ecx, edx;
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) {
+        return SimdLevel::SCALAR;
+    }
+
+    const bool sse4 = (ecx & bit_SSE4_1) && (ecx & bit_SSSE3);
+    if (!sse4) {
+        return SimdLevel::SCALAR;
+    }
+
+    const bool osxsave = ecx & bit_OSXSAVE;
+    const bool fma = ecx & bit_FMA;
+    if (!osxsave || __get_cpuid_max(0, nullptr) < 7) {
+        return SimdLevel::SSE4;
+    }
+
+    // XMM and YMM state, then opmask and ZMM state
+    const uint64_t xcr0 = readXCR0();
+    const bool ymm_state = (xcr0 & 0x6) == 0x6;
+    const bool zmm_state = (xcr0 & 0xE6) == 0xE6;
+
+    __cpuid_count(7, 0, eax, ebx, ecx, edx);
+    const bool avx2 = ymm_state && fma && (ebx & bit_AVX2);
+    const bool avx512 = avx2 && zmm_state && (ebx & bit_AVX512F) &&
+                        (ebx & bit_AVX512BW) && (ebx & bit_AVX512VL);
+
+    if (avx512) {
+        return SimdLevel::AVX512;
+    }
+    return avx2 ? SimdLevel::AVX2 : SimdLevel::SSE4;
+}
+
+SimdLevel initialLevel() {
+    SimdLevel level = detectSimdLevel();
+    if (const char* env = std::getenv("GPS_SIMD")) {
+        SimdLevel requested;
+        if (!parseSimdLevel(env, requested)) {
+            std::cerr << "Ignoring unknown GPS_SIMD level '" << env << "'\n";
+        } else if (requested > level) {
+            std::cerr << "GPS_SIMD=" << env << " not supported, using "
+                      << simdLevelName(level) << "\n";
+        } else {
+            level = requested;
+        }
+    }
+    return level;
+}
+
+std::atomic<SimdLevel>& activeLevel() {
+    static std::atomic<SimdLevel> level(initialLevel());
+    return level;
+}
+
+}
+
+SimdLevel detectSimdLevel() {
+    static const SimdLevel level = probe();
+    return level;
+}
+
+SimdLevel activeSimdLevel() {
+    return activeLevel().load(std::memory_order_relaxed);
+}
+
+SimdLevel setSimdLevel(SimdLevel level) {
+    if (level > detectSimdLevel()) {
+        level = detectSimdLevel();
+    }
+    activeLevel().store(level, std::memory_order_relaxed);
+    return level;
+}
+
+const char* simdLevelName(SimdLevel level) {
+    switch (level) {
+        case SimdLevel::SCALAR: return "scalar";
+        case SimdLevel::SSE4:   return "sse4";
+        case SimdLevel::AVX2:   return "avx2";
+        case SimdLevel::AVX512: return "avx512";
+    }
+    return "unknown";
+}
+
+bool parseSimdLevel(const std::string& name, SimdLevel& level) {
+    for (SimdLevel candidate : {SimdLevel::SCALAR, SimdLevel::SSE4,
+                                SimdLevel::AVX2, SimdLevel::AVX512}) {
+        if (name == simdLevelName(candidate)) {
+            level = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+}
@@ -0,0 +1,121 @@
+#include "utils/thread_pool.h"
+#include <algorithm>
+
+namespace gps {
+
+WorkStealingPool::WorkStealingPool(unsigned num_threads)
+    : num_workers_(num_threads)
+    , task_(nullptr)
+    , pending_(0)
+    , generation_(0)
+    , stop_(false) {
+
+    if (num_workers_ == 0) {
+        num_workers_ = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    queues_.reset(new TaskQueue[num_workers_]);
+
+    threads_.reserve(num_workers_ - 1);
+    for (unsigned w = 1; w < num_workers_; ++w) {
+        threads_.emplace_back(&WorkStealingPool::workerLoop, this, w);
+    }
+}
+
+WorkStealingPool::~WorkStealingPool() {
+    {
+        std::lock_guard<std::mutex> lock(wake_mutex_);
+        stop_ = true;
+    }
+    wake_cv_.notify_all();
+
+    for (auto& thread : threads_) {
+        thread.join();
+    }
+}
+
+void WorkStealingPool::parallelFor(size_t count, const std::function<void(size_t, unsigned)>& task) {
+    if (count == 0) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> run_lock(run_mutex_);
+
+    task_ = &task;
+    pending_.store(count, std::memory_order_relaxed);
+
+    for (size_t i = 0; i < count; ++i) {
+        TaskQueue& queue = queues_[i % num_workers_];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.tasks.push_back(i);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(wake_mutex_);
+        ++generation_;
+    }
+    wake_cv_.notify_all();
+
+    runTasks(0);
+
+    std::unique_lock<std::mutex> lock(wake_mutex_);
+    done_cv_.wait(lock, [this] { return pending_.load(std::memory_order_acquire) == 0; });
+    task_ = nullptr;
+}
+
+void WorkStealingPool::workerLoop(unsigned worker) {
+    uint64_t seen = 0;
+
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(wake_mutex_);
+            wake_cv_.wait(lock, [&] { return stop_ || generation_ != seen; });
+            if (stop_) {
+                return;
+            }
+            seen = generation_;
+        }
+
+        runTasks(worker);
+    }
+}
+
+void WorkStealingPool::runTasks(unsigned worker) {
+    size_t index;
+    while (popTask(worker, index)) {
+        (*task_)(index, worker);
+
+        if (pending_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            std::lock_guard<std::mutex> lock(wake_mutex_);
+            done_cv_.notify_all();
+        }
+    }
+}
+
+bool WorkStealingPool::popTask(unsigned worker, size_t& index) {
+    // Own queue first, newest task
+    {
+        TaskQueue& own = queues_[worker];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.tasks.empty()) {
+            index = own.tasks.back();
+            own.tasks.pop_back();
+            return true;
+        }
+    }
+
+    // Then steal the oldest task from the next non-empty queue
+    for (unsigned offset = 1; offset < num_workers_; ++offset) {
+        TaskQueue& victim = queues_[(worker + offset) % num_workers_];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            index = victim.tasks.front();
+            victim.tasks.pop_front();
+            return true;
+        }
+    }
+
+    return false;
+}
+
+}
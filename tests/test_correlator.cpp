@@ -1,8 +1,28 @@
 #include <gtest/gtest.h>
 #include <random>
 #include <chrono>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <thread>
+#include "acquisition/file_source.h"
+#include "acquisition/signal_acquisition.h"
+#include "acquisition/signal_generator.h"
+#include "acquisition/visibility_predictor.h"
+#include "decoding/nav_decoder.h"
 #include "tracking/correlator.h"
+#include "tracking/gps_tracker.h"
+#include "tracking/multi_channel_correlator.h"
+#include "tracking/multi_tap_correlator.h"
+#include "tracking/tracking_scheduler.h"
+#include "utils/carrier_nco.h"
+#include "utils/code_nco.h"
+#include "utils/fft_processor.h"
+#include "utils/hot_start.h"
+#include "utils/iq_converter.h"
 #include "utils/prn_generator.h"
+#include "utils/ring_buffer.h"
+#include "utils/seqlock.h"
 
 using namespace gps;
 
@@ -176,6 +196,210 @@ TEST_F(CorrelatorTest, EarlyPromptLateSpacing) {
     EXPECT_GT(code_error, 0.0);
 }
 
+TEST_F(CorrelatorTest, FixedPointMatchesFloat) {
+    // Back off from full scale so quantization does not clip
+    IQBuffer scaled_signal(test_signal_);
+    for (auto& sample : scaled_signal) {
+        sample *= 0.5f;
+    }
+    
+    IQBuffer8 fixed_signal(scaled_signal.size());
+    IQConverter::quantizeInt8(scaled_signal.data(), scaled_signal.size(), fixed_signal.data());
+    
+    const float peak = std::abs(correlator_->correlate(
+        scaled_signal, 100.5, M_PI / 4, 1000.0).prompt);
+    
+    for (double phase : {99.0, 99.5, 100.0, 100.5, 101.0}) {
+        CorrelationResult float_result = correlator_->correlate(
+            scaled_signal, phase, M_PI / 4, 1000.0);
+        CorrelationResult fixed_result = correlator_->correlate(
+            fixed_signal.data(), fixed_signal.size(), phase, M_PI / 4, 1000.0);
+        
+        // 8-bit samples and carrier stay within 1% of the float correlator
+        EXPECT_LT(std::abs(fixed_result.early - float_result.early), 0.01f * peak);
+        EXPECT_LT(std::abs(fixed_result.prompt - float_result.prompt), 0.01f * peak);
+        EXPECT_LT(std::abs(fixed_result.late - float_result.late), 0.01f * peak);
+    }
+}
+
+TEST_F(CorrelatorTest, IntegerKernelMatchesScalar) {
+    if (detectSimdLevel() < SimdLevel::AVX2) {
+        GTEST_SKIP() << "CPU lacks AVX2";
+    }
+    // Odd length exercises the scalar tail
+    const size_t length = 2047;
+    std::vector<int8_t> samples(2 * length), code(2 * length);
+    std::vector<int8_t> carrier_re(2 * length), carrier_im(2 * length);
+    
+    std::uniform_int_distribution<int> sample_dist(-127, 127);
+    for (size_t i = 0; i < length; ++i) {
+        samples[2 * i] = static_cast<int8_t>(sample_dist(rng_));
+        samples[2 * i + 1] = static_cast<int8_t>(sample_dist(rng_));
+        code[2 * i] = code[2 * i + 1] = (rng_() & 1) ? 1 : -1;
+        int8_t c = static_cast<int8_t>(sample_dist(rng_));
+        int8_t s = static_cast<int8_t>(sample_dist(rng_));
+        carrier_re[2 * i] = c;
+        carrier_re[2 * i + 1] = s;
+        carrier_im[2 * i] = static_cast<int8_t>(-s);
+        carrier_im[2 * i + 1] = c;
+    }
+    
+    int32_t expected_i = 0, expected_q = 0;
+    for (size_t i = 0; i < length; ++i) {
+        int s_i = samples[2 * i] * code[2 * i];
+        int s_q = samples[2 * i + 1] * code[2 * i];
+        expected_i += s_i * carrier_re[2 * i] + s_q * carrier_re[2 * i + 1];
+        expected_q += s_i * carrier_im[2 * i] + s_q * carrier_im[2 * i + 1];
+    }
+    
+    int32_t corr_i = 0, corr_q = 0;
+    correlateInt8AVX(samples.data(), code.data(), carrier_re.data(), carrier_im.data(),
+                     length, corr_i, corr_q);
+    
+    EXPECT_EQ(corr_i, expected_i);
+    EXPECT_EQ(corr_q, expected_q);
+}
+
+TEST_F(CorrelatorTest, EveryTierMatchesScalar) {
+    // Odd length exercises each tier's tail
+    const size_t length = 2047;
+    std::vector<float> samples_i(length), samples_q(length), code(length);
+    std::vector<float> carrier_i(length), carrier_q(length);
+    std::vector<int8_t> samples8(2 * length), code8(2 * length);
+    std::vector<int8_t> carrier_re8(2 * length), carrier_im8(2 * length);
+    
+    std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+    std::uniform_int_distribution<int> dist8(-127, 127);
+    for (size_t i = 0; i < length; ++i) {
+        samples_i[i] = dist(rng_);
+        samples_q[i] = dist(rng_);
+        code[i] = (rng_() & 1) ? 1.0f : -1.0f;
+        carrier_i[i] = dist(rng_);
+        carrier_q[i] = dist(rng_);
+        
+        samples8[2 * i] = static_cast<int8_t>(dist8(rng_));
+        samples8[2 * i + 1] = static_cast<int8_t>(dist8(rng_));
+        code8[2 * i] = code8[2 * i + 1] = code[i] > 0.0f ? 1 : -1;
+        int8_t c = static_cast<int8_t>(dist8(rng_));
+        int8_t s = static_cast<int8_t>(dist8(rng_));
+        carrier_re8[2 * i] = c;
+        carrier_re8[2 * i + 1] = s;
+        carrier_im8[2 * i] = static_cast<int8_t>(-s);
+        carrier_im8[2 * i + 1] = c;
+    }
+    
+    float expected_i = 0.0f, expected_q = 0.0f;
+    kCorrelateKernels.scalar(samples_i.data(), samples_q.data(), code.data(),
+                             carrier_i.data(), carrier_q.data(), length, expected_i, expected_q);
+    int32_t expected_i8 = 0, expected_q8 = 0;
+    kCorrelateInt8Kernels.scalar(samples8.data(), code8.data(), carrier_re8.data(),
+                                 carrier_im8.data(), length, expected_i8, expected_q8);
+    
+    for (SimdLevel level : {SimdLevel::SSE4, SimdLevel::AVX2, SimdLevel::AVX512}) {
+        if (level > detectSimdLevel()) {
+            break;
+        }
+        SCOPED_TRACE(simdLevelName(level));
+        
+        float corr_i = 0.0f, corr_q = 0.0f;
+        kCorrelateKernels.select(level)(samples_i.data(), samples_q.data(), code.data(),
+                                        carrier_i.data(), carrier_q.data(), length, corr_i, corr_q);
+        EXPECT_NEAR(corr_i, expected_i, 1e-3f * length);
+        EXPECT_NEAR(corr_q, expected_q, 1e-3f * length);
+        
+        int32_t corr_i8 = 0, corr_q8 = 0;
+        kCorrelateInt8Kernels.select(level)(samples8.data(), code8.data(), carrier_re8.data(),
+                                            carrier_im8.data(), length, corr_i8, corr_q8);
+        EXPECT_EQ(corr_i8, expected_i8);
+        EXPECT_EQ(corr_q8, expected_q8);
+    }
+}
+
+TEST_F(CorrelatorTest, MultiChannelMatchesSingleChannel) {
+    MultiChannelCorrelator multi(sample_rate_);
+    std::vector<ChannelReplica> channels = {
+        {prn_, 100.5, GPS_CA_CODE_FREQ_HZ, M_PI / 4, 1000.0},
+        {prn_, 99.75, GPS_CA_CODE_FREQ_HZ, 0.3, 1100.0},
+        {7, 512.25, GPS_CA_CODE_FREQ_HZ, -1.0, -2500.0},
+    };
+    
+    std::vector<CorrelationResult> results;
+    multi.correlate(test_signal_.data(), test_signal_.size(), channels, results);
+    ASSERT_EQ(results.size(), channels.size());
+    
+    for (size_t ch = 0; ch < channels.size(); ++ch) {
+        Correlator single(channels[ch].prn, sample_rate_);
+        CorrelationResult expected = single.correlate(test_signal_, channels[ch].code_phase,
+                                                      channels[ch].carrier_phase,
+                                                      channels[ch].carrier_freq);
+        const float tolerance = 1e-3f * test_signal_.size();
+        EXPECT_LT(std::abs(results[ch].early - expected.early), tolerance);
+        EXPECT_LT(std::abs(results[ch].prompt - expected.prompt), tolerance);
+        EXPECT_LT(std::abs(results[ch].late - expected.late), tolerance);
+    }
+}
+
+TEST_F(CorrelatorTest, MultiChannelSpansMatchSingleChannel) {
+    MultiChannelCorrelator multi(sample_rate_);
+    std::vector<ChannelReplica> channels = {
+        {prn_, 0.4, GPS_CA_CODE_FREQ_HZ, M_PI / 4, 1000.0},
+        {prn_, 0.1, GPS_CA_CODE_FREQ_HZ, 0.3, 1100.0},
+        {7, 0.25, GPS_CA_CODE_FREQ_HZ, -1.0, -2500.0},
+    };
+    // Starts and ends off the tile grid, one span inside a single tile
+    std::vector<ChannelSpan> spans = {{37, 1500}, {600, 1448}, {700, 100}};
+
+    std::vector<CorrelationResult> results;
+    multi.correlate(test_signal_.data(), test_signal_.size(), channels, spans, results);
+    ASSERT_EQ(results.size(), channels.size());
+
+    for (size_t ch = 0; ch < channels.size(); ++ch) {
+        Correlator single(channels[ch].prn, sample_rate_);
+        CorrelationResult expected = single.correlate(test_signal_.data() + spans[ch].offset,
+                                                      spans[ch].length, channels[ch].code_phase,
+                                                      channels[ch].carrier_phase,
+                                                      channels[ch].carrier_freq);
+        const float tolerance = 1e-3f * spans[ch].length;
+        EXPECT_LT(std::abs(results[ch].early - expected.early), tolerance);
+        EXPECT_LT(std::abs(results[ch].prompt - expected.prompt), tolerance);
+        EXPECT_LT(std::abs(results[ch].late - expected.late), tolerance);
+    }
+}
+
+TEST_F(CorrelatorTest, MultiTapMatchesEarlyPromptLate) {
+    const ChannelReplica replica{prn_, 100.5, GPS_CA_CODE_FREQ_HZ, M_PI / 4, 1000.0};
+    CorrelationResult expected = correlator_->correlate(test_signal_, replica.code_phase,
+                                                        replica.carrier_phase, replica.carrier_freq);
+    const float tolerance = 1e-3f * test_signal_.size();
+    
+    // Three taps at the correlator spacing land on the same samples as E/P/L
+    MultiTapCorrelator epl(sample_rate_, MultiTapConfig{3, CORRELATOR_SPACING});
+    TapCorrelation taps;
+    epl.correlate(test_signal_.data(), test_signal_.size(), replica, taps);
+    ASSERT_EQ(taps.taps.size(), 3u);
+    EXPECT_LT(std::abs(taps.taps[0] - expected.late), tolerance);
+    EXPECT_LT(std::abs(taps.taps[1] - expected.prompt), tolerance);
+    EXPECT_LT(std::abs(taps.taps[2] - expected.early), tolerance);
+    
+    // Sub-sample taps: prompt in the middle, a symmetric triangle around it
+    MultiTapCorrelator wide(sample_rate_, MultiTapConfig{33, 1.5});
+    wide.correlate(test_signal_.data(), test_signal_.size(), replica, taps);
+    ASSERT_EQ(taps.taps.size(), 33u);
+    EXPECT_NEAR(taps.first_offset, -1.5, taps.spacing);
+    EXPECT_NEAR(wide.tapOffset(16), 0.0, 1e-9);
+    EXPECT_LT(std::abs(taps.taps[16] - expected.prompt), tolerance);
+    
+    size_t peak = 0;
+    for (size_t t = 0; t < taps.taps.size(); ++t) {
+        if (std::norm(taps.taps[t]) > std::norm(taps.taps[peak])) {
+            peak = t;
+        }
+    }
+    EXPECT_NEAR(static_cast<double>(peak), 16.0, 1.0);
+    EXPECT_LT(std::abs(taps.taps.front()), 0.1f * std::abs(taps.taps[16]));
+    EXPECT_LT(std::abs(taps.taps.back()), 0.1f * std::abs(taps.taps[16]));
+}
+
 // Test fixture for PRN code properties
 class PRNTest : public ::testing::Test {
 protected:
@@ -216,6 +440,1322 @@ TEST_F(PRNTest, CrossCorrelation) {
     EXPECT_LT(std::abs(cross_corr), 0.1);
 }
 
+TEST(FFTTest, MixedRadixMatchesDFT) {
+    // Radix 2/3/generic (2046), radix 4/3/generic (4092) and Bluestein (1021)
+    std::mt19937 rng(7);
+    std::normal_distribution<float> noise(0.0f, 1.0f);
+
+    for (size_t n : {2046u, 4092u, 1021u}) {
+        IQBuffer input(n);
+        for (auto& v : input) {
+            v = IQSample(noise(rng), noise(rng));
+        }
+
+        IQBuffer output(n);
+        FFTProcessor::forward(input.data(), output.data(), n);
+
+        double max_error = 0.0;
+        for (size_t k = 0; k < n; k += 97) {
+            std::complex<double> expected = 0.0;
+            for (size_t j = 0; j < n; ++j) {
+                expected += std::complex<double>(input[j]) *
+                            std::polar(1.0, -2.0 * M_PI * ((j * k) % n) / n);
+            }
+            max_error = std::max(max_error, std::abs(expected - std::complex<double>(output[k])));
+        }
+        EXPECT_LT(max_error, 1e-3 * std::sqrt(static_cast<double>(n))) << "n = " << n;
+
+        // Unnormalized inverse, in place
+        FFTProcessor::getPlan(n, FFTDirection::INVERSE)->execute(output.data());
+        for (size_t i = 0; i < n; i += 31) {
+            EXPECT_NEAR(output[i].real() / n, input[i].real(), 1e-4);
+            EXPECT_NEAR(output[i].imag() / n, input[i].imag(), 1e-4);
+        }
+    }
+}
+
+TEST(FFTTest, RealTransformRoundTrip) {
+    const size_t n = 4092;
+    auto plan = FFTProcessor::getRealPlan(n);
+
+    std::vector<float> input(n);
+    IQBuffer complex_input(n);
+    for (size_t i = 0; i < n; ++i) {
+        input[i] = std::sin(0.01f * i * i);
+        complex_input[i] = input[i];
+    }
+
+    IQBuffer spectrum(n / 2 + 1);
+    IQBuffer reference(n);
+    plan->forward(input.data(), spectrum.data());
+    FFTProcessor::forward(complex_input.data(), reference.data(), n);
+
+    for (size_t k = 0; k <= n / 2; ++k) {
+        EXPECT_NEAR(spectrum[k].real(), reference[k].real(), 1e-2);
+        EXPECT_NEAR(spectrum[k].imag(), reference[k].imag(), 1e-2);
+    }
+
+    std::vector<float> output(n);
+    plan->inverse(spectrum.data(), output.data());
+    for (size_t i = 0; i < n; ++i) {
+        EXPECT_NEAR(output[i] / n, input[i], 1e-4);
+    }
+}
+
+TEST(IQConverterTest, CorrectionsConvergeOnKnownOffsetAndImbalance) {
+    // Q leaks I through phi and is scaled by g; both channels sit off zero
+    const double dc_i = 0.1;
+    const double dc_q = -0.05;
+    const double gain = 1.2;
+    const double phi = 0.1;
+    const size_t num_samples = 40 * IQConverter::ESTIMATE_INTERVAL;
+
+    std::mt19937 rng(5);
+    std::normal_distribution<double> noise(0.0, 0.2);
+    const auto toByte = [](double v) {
+        return static_cast<uint8_t>(std::max(0.0, std::min(255.0, std::round(127.5 + 127.5 * v))));
+    };
+    std::vector<uint8_t> raw(2 * num_samples);
+    for (size_t n = 0; n < num_samples; ++n) {
+        const double i = noise(rng);
+        const double q = noise(rng);
+        raw[2 * n] = toByte(dc_i + i);
+        raw[2 * n + 1] = toByte(dc_q + gain * (std::sin(phi) * i + std::cos(phi) * q));
+    }
+
+    IQConverter converter;
+    converter.setDCRemoval(true, 0.5f);
+    converter.setImbalanceCorrection(true, 0.5f);
+    // Blocks that do not line up with the estimate interval
+    IQBuffer out(num_samples);
+    const size_t block = 10007;
+    for (size_t start = 0; start < num_samples; start += block) {
+        const size_t n = std::min(block, num_samples - start);
+        converter.convert(raw.data() + 2 * start, n, out.data() + start);
+    }
+
+    EXPECT_NEAR(converter.getDCOffsetI(), dc_i, 0.005);
+    EXPECT_NEAR(converter.getDCOffsetQ(), dc_q, 0.005);
+    EXPECT_NEAR(converter.getGainImbalance(), gain, 0.01);
+    EXPECT_NEAR(converter.getPhaseImbalance(), phi, 0.01);
+
+    // The last interval comes out centred, balanced and orthogonal
+    double sum_i = 0.0, sum_q = 0.0, sum_ii = 0.0, sum_qq = 0.0, sum_iq = 0.0;
+    const size_t first = num_samples - IQConverter::ESTIMATE_INTERVAL;
+    for (size_t n = first; n < num_samples; ++n) {
+        sum_i += out[n].real();
+        sum_q += out[n].imag();
+        sum_ii += out[n].real() * out[n].real();
+        sum_qq += out[n].imag() * out[n].imag();
+        sum_iq += out[n].real() * out[n].imag();
+    }
+    const double count = static_cast<double>(num_samples - first);
+    EXPECT_NEAR(sum_i / count, 0.0, 0.005);
+    EXPECT_NEAR(sum_q / count, 0.0, 0.005);
+    EXPECT_NEAR(sum_qq / sum_ii, 1.0, 0.02);
+    EXPECT_NEAR(sum_iq / std::sqrt(sum_ii * sum_qq), 0.0, 0.02);
+
+    converter.reset();
+    EXPECT_EQ(converter.getDCOffsetI(), 0.0f);
+    EXPECT_EQ(converter.getGainImbalance(), 1.0f);
+}
+
+TEST(FileSourceTest, ReplaysRawBytes) {
+    const std::string path = ::testing::TempDir() + "file_source_u8.bin";
+    const std::vector<uint8_t> bytes = {0, 255, 128, 127, 10, 245, 200, 55, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12};
+    {
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+    }
+
+    FileSource source;
+    ASSERT_TRUE(source.open(path, SampleFileFormat::AUTO, 2.0e6, 1.5e9));
+    EXPECT_EQ(source.getFormat(), SampleFileFormat::UINT8_IQ);
+    EXPECT_EQ(source.getTotalSamples(), bytes.size() / 2);
+    EXPECT_EQ(source.getSampleRate(), 2.0e6);
+    EXPECT_EQ(source.getCenterFrequency(), 1.5e9);
+    ASSERT_TRUE(source.setSampleFormat(SampleFormat::FLOAT32));
+
+    SampleSpan<IQSample> span;
+    EXPECT_FALSE(source.readSamples(span, 4));
+    ASSERT_TRUE(source.startCapture());
+    EXPECT_FALSE(source.setSampleFormat(SampleFormat::INT8));
+
+    // Two reads of four, then a read past the end stops the replay
+    for (size_t start = 0; start < 8; start += 4) {
+        ASSERT_TRUE(source.readSamples(span, 4));
+        ASSERT_EQ(span.size, 4u);
+        for (size_t n = 0; n < 4; ++n) {
+            const size_t b = 2 * (start + n);
+            EXPECT_FLOAT_EQ(span.data[n].real(), (bytes[b] - 127.5f) / 127.5f);
+            EXPECT_FLOAT_EQ(span.data[n].imag(), (bytes[b + 1] - 127.5f) / 127.5f);
+        }
+        source.consumeSamples(4);
+    }
+    EXPECT_FALSE(source.isFinished());
+    EXPECT_FALSE(source.readSamples(span, 4));
+    EXPECT_TRUE(source.isFinished());
+
+    // A capture header is required to force complex64
+    source.close();
+    EXPECT_FALSE(source.open(path, SampleFileFormat::COMPLEX64));
+    std::remove(path.c_str());
+}
+
+TEST(FileSourceTest, ReplaysCaptureWithHeaderAndLoops) {
+    // scripts/capture_raw_data.py: uint32 count, double rate, double frequency, complex64
+    const std::string path = ::testing::TempDir() + "file_source_cf32.bin";
+    const uint32_t count = 5;
+    const double rate = 4.0e6;
+    const double frequency = GPS_L1_FREQ_HZ + 1000.0;
+    IQBuffer samples;
+    for (uint32_t n = 0; n < count; ++n) {
+        samples.emplace_back(0.5f * n, -0.25f * n);
+    }
+    {
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<const char*>(&count), sizeof(count));
+        out.write(reinterpret_cast<const char*>(&rate), sizeof(rate));
+        out.write(reinterpret_cast<const char*>(&frequency), sizeof(frequency));
+        out.write(reinterpret_cast<const char*>(samples.data()), samples.size() * sizeof(IQSample));
+    }
+
+    FileSource source;
+    ASSERT_TRUE(source.open(path));
+    EXPECT_EQ(source.getFormat(), SampleFileFormat::COMPLEX64);
+    EXPECT_EQ(source.getTotalSamples(), count);
+    EXPECT_EQ(source.getSampleRate(), rate);
+    EXPECT_EQ(source.getCenterFrequency(), frequency);
+    ASSERT_TRUE(source.setSampleFormat(SampleFormat::FLOAT32));
+    source.setLooping(true);
+    ASSERT_TRUE(source.startCapture());
+
+    // The partial tail is dropped so the second read starts over
+    SampleSpan<IQSample> span;
+    for (int pass = 0; pass < 2; ++pass) {
+        ASSERT_TRUE(source.readSamples(span, 3));
+        ASSERT_EQ(span.size, 3u);
+        for (size_t n = 0; n < 3; ++n) {
+            EXPECT_EQ(span.data[n], samples[n]);
+        }
+        source.consumeSamples(3);
+        EXPECT_FALSE(source.isFinished());
+    }
+    // Longer than the recording can never be served, even when looping
+    EXPECT_FALSE(source.readSamples(span, count + 1));
+
+    // The fixed-point path quantizes the same samples
+    source.close();
+    ASSERT_TRUE(source.open(path));
+    source.setLooping(false);
+    ASSERT_TRUE(source.setSampleFormat(SampleFormat::INT8));
+    ASSERT_TRUE(source.startCapture());
+    SampleSpan<IQSample8> span8;
+    ASSERT_TRUE(source.readSamples(span8, count));
+    IQBuffer8 expected(count);
+    IQConverter::quantizeInt8(samples.data(), count, expected.data());
+    for (size_t n = 0; n < count; ++n) {
+        EXPECT_EQ(span8.data[n].i, expected[n].i);
+        EXPECT_EQ(span8.data[n].q, expected[n].q);
+    }
+    source.consumeSamples(count);
+    EXPECT_TRUE(source.isFinished());
+    std::remove(path.c_str());
+}
+
+class AcquisitionTest : public ::testing::Test {
+protected:
+    static SyntheticSatellite satellite(int prn, double doppler, double code_phase, double cn0) {
+        SyntheticSatellite sat;
+        sat.prn = prn;
+        sat.doppler = doppler;
+        sat.code_phase = code_phase;
+        sat.cn0 = cn0;
+        sat.nav_data = false;
+        return sat;
+    }
+
+    IQBuffer makeSignal(const std::vector<SyntheticSatellite>& satellites, size_t milliseconds,
+                        uint64_t start_sample = 0) {
+        SignalGeneratorConfig config;
+        config.sample_rate = sample_rate_;
+        config.seed = 11;
+        config.num_threads = 1;
+        config.satellites = satellites;
+        SignalGenerator generator(config);
+        IQBuffer samples(milliseconds * code_samples_);
+        generator.generate(start_sample, samples.size(), samples.data());
+        return samples;
+    }
+
+    // Feeds consecutive blocks until the dwell ends; returns the blocks used
+    static int runDwell(SignalAcquisition& acquisition, const IQBuffer& samples) {
+        const size_t block = acquisition.getBlockSize();
+        int used = 0;
+        for (size_t start = 0; start + block <= samples.size(); start += block) {
+            ++used;
+            if (acquisition.accumulateBlock(IQBuffer(samples.begin() + start,
+                                                     samples.begin() + start + block))) {
+                break;
+            }
+        }
+        return used;
+    }
+
+    static void expectSameResult(const AcquisitionResult& a, const AcquisitionResult& b) {
+        EXPECT_EQ(a.prn, b.prn);
+        EXPECT_EQ(a.found, b.found);
+        EXPECT_EQ(a.code_phase, b.code_phase);
+        EXPECT_EQ(a.doppler_shift, b.doppler_shift);
+        EXPECT_EQ(a.peak_ratio, b.peak_ratio);
+        EXPECT_EQ(a.snr_estimate, b.snr_estimate);
+    }
+
+    const double sample_rate_ = DEFAULT_SAMPLE_RATE;
+    const size_t code_samples_ = 2048;
+};
+
+TEST_F(AcquisitionTest, GeneratorIsDeterministic) {
+    SignalGeneratorConfig config;
+    config.sample_rate = sample_rate_;
+    config.seed = 3;
+    config.num_threads = 1;
+    config.satellites = {satellite(5, 2500.0, 300.4, 45.0), satellite(14, -1500.0, 12.9, 42.0)};
+    config.satellites[0].nav_data = true;
+    config.satellites[1].doppler_rate = 0.8;
+    // Phase is re-anchored per sub-block from the start of each call, so
+    // calls only match when split on noise chunk boundaries
+    const size_t num_samples = 10 * SignalGenerator::NOISE_CHUNK;
+
+    SignalGenerator serial(config);
+    IQBuffer expected(num_samples);
+    serial.generate(1000, num_samples, expected.data());
+
+    // Same samples from a pool of workers and from separate calls
+    config.num_threads = 4;
+    SignalGenerator parallel(config);
+    for (int run = 0; run < 3; ++run) {
+        IQBuffer samples(num_samples);
+        parallel.generate(1000, num_samples, samples.data());
+        EXPECT_TRUE(samples == expected) << "run " << run;
+    }
+    IQBuffer pieces(num_samples);
+    const size_t split = 3 * SignalGenerator::NOISE_CHUNK;
+    parallel.generate(1000, split, pieces.data());
+    parallel.generate(1000 + split, num_samples - split, pieces.data() + split);
+    EXPECT_TRUE(pieces == expected);
+
+    // Streaming hands out the same stream from sample 0
+    IQBuffer head(num_samples);
+    parallel.generate(0, num_samples, head.data());
+    ASSERT_TRUE(parallel.setSampleFormat(SampleFormat::FLOAT32));
+    ASSERT_TRUE(parallel.startCapture());
+    SampleSpan<IQSample> span;
+    ASSERT_TRUE(parallel.readSamples(span, num_samples));
+    ASSERT_EQ(span.size, num_samples);
+    EXPECT_TRUE(std::equal(head.begin(), head.end(), span.data));
+    parallel.stopCapture();
+
+    config.seed = 4;
+    SignalGenerator reseeded(config);
+    IQBuffer other(num_samples);
+    reseeded.generate(1000, num_samples, other.data());
+    EXPECT_FALSE(other == expected);
+}
+
+TEST_F(AcquisitionTest, RecordingRoundTrip) {
+    SignalGeneratorConfig config;
+    config.sample_rate = sample_rate_;
+    config.center_freq = GPS_L1_FREQ_HZ - 2000.0;
+    config.seed = 9;
+    config.num_threads = 2;
+    config.satellites = {satellite(8, 900.0, 512.5, 48.0)};
+    SignalGenerator generator(config);
+
+    const double duration = 0.005;
+    const size_t num_samples = static_cast<size_t>(duration * sample_rate_);
+    IQBuffer expected(num_samples);
+    generator.generate(0, num_samples, expected.data());
+
+    // complex64 with the capture header comes back bit for bit
+    const std::string cf32_path = ::testing::TempDir() + "generator_cf32.bin";
+    ASSERT_TRUE(generator.writeRecording(cf32_path, SampleFileFormat::COMPLEX64, duration));
+    FileSource source;
+    ASSERT_TRUE(source.open(cf32_path));
+    EXPECT_EQ(source.getFormat(), SampleFileFormat::COMPLEX64);
+    EXPECT_EQ(source.getSampleRate(), config.sample_rate);
+    EXPECT_EQ(source.getCenterFrequency(), config.center_freq);
+    ASSERT_EQ(source.getTotalSamples(), num_samples);
+    ASSERT_TRUE(source.setSampleFormat(SampleFormat::FLOAT32));
+    ASSERT_TRUE(source.startCapture());
+    SampleSpan<IQSample> span;
+    ASSERT_TRUE(source.readSamples(span, num_samples));
+    EXPECT_TRUE(std::equal(expected.begin(), expected.end(), span.data));
+    source.close();
+    std::remove(cf32_path.c_str());
+
+    // rtl_sdr bytes come back within half a quantization step, clipped to full scale
+    const std::string u8_path = ::testing::TempDir() + "generator_u8.bin";
+    ASSERT_TRUE(generator.writeRecording(u8_path, SampleFileFormat::UINT8_IQ, duration));
+    ASSERT_TRUE(source.open(u8_path, SampleFileFormat::AUTO, config.sample_rate));
+    EXPECT_EQ(source.getFormat(), SampleFileFormat::UINT8_IQ);
+    ASSERT_EQ(source.getTotalSamples(), num_samples);
+    ASSERT_TRUE(source.setSampleFormat(SampleFormat::FLOAT32));
+    ASSERT_TRUE(source.startCapture());
+    ASSERT_TRUE(source.readSamples(span, num_samples));
+    const auto clip = [](float v) { return std::max(-1.0f, std::min(1.0f, v)); };
+    for (size_t n = 0; n < num_samples; ++n) {
+        ASSERT_NEAR(span.data[n].real(), clip(expected[n].real()), 0.5f / 127.5f + 1e-6f) << n;
+        ASSERT_NEAR(span.data[n].imag(), clip(expected[n].imag()), 0.5f / 127.5f + 1e-6f) << n;
+    }
+    source.close();
+    std::remove(u8_path.c_str());
+}
+
+TEST_F(AcquisitionTest, ParallelMatchesSerial) {
+    // Strong signals detect early in the Doppler sweep, so the pool skips
+    // bins while other workers are still searching theirs
+    const IQBuffer samples = makeSignal({satellite(3, -3700.0, 100.3, 50.0),
+                                         satellite(9, 1250.0, 512.6, 49.0),
+                                         satellite(17, -2600.0, 700.7, 47.0),
+                                         satellite(24, 4200.0, 33.1, 52.0)}, 1);
+    std::vector<int> prns;
+    for (int prn = 1; prn <= GPS_MAX_SATELLITES; ++prn) {
+        prns.push_back(prn);
+    }
+
+    SignalAcquisition serial(sample_rate_);
+    const std::vector<AcquisitionResult> expected = serial.searchAllSatellites(samples, prns);
+    ASSERT_EQ(expected.size(), prns.size());
+    for (int prn : {3, 9, 17, 24}) {
+        EXPECT_TRUE(expected[prn - 1].found) << "PRN " << prn;
+    }
+
+    SignalAcquisition parallel(sample_rate_);
+    parallel.setParallelProcessing(true);
+    parallel.setNumThreads(4);
+    for (int run = 0; run < 5; ++run) {
+        const std::vector<AcquisitionResult> results = parallel.searchAllSatellites(samples, prns);
+        ASSERT_EQ(results.size(), expected.size());
+        for (size_t i = 0; i < results.size(); ++i) {
+            expectSameResult(results[i], expected[i]);
+        }
+    }
+}
+
+TEST_F(AcquisitionTest, CodeSpectrumBankFindsSatellite) {
+    // One bank per sampling setup, shared by every engine
+    auto bank = CodeSpectrumBank::get(sample_rate_, code_samples_);
+    EXPECT_EQ(bank, CodeSpectrumBank::get(sample_rate_, code_samples_));
+    EXPECT_NE(bank, CodeSpectrumBank::get(sample_rate_, 2 * code_samples_));
+    EXPECT_THROW(bank->spectrum(0), std::invalid_argument);
+
+    // Conjugated DFT of the sampled code
+    PRNGenerator generator;
+    std::vector<float> code;
+    generator.generateCodeSampled(9, sample_rate_, code_samples_, code);
+    for (size_t k : {0u, 1u, 777u, 2047u}) {
+        std::complex<double> sum(0.0, 0.0);
+        for (size_t n = 0; n < code_samples_; ++n) {
+            sum += static_cast<double>(code[n]) * std::polar(1.0, -2.0 * M_PI * k * n / code_samples_);
+        }
+        const IQSample bin = bank->spectrum(9)[k];
+        EXPECT_NEAR(bin.real(), sum.real(), 1e-2);
+        EXPECT_NEAR(bin.imag(), -sum.imag(), 1e-2);
+    }
+
+    const IQBuffer samples = makeSignal({satellite(9, -1500.0, 512.5, 46.0)}, 1);
+    SignalAcquisition acquisition(sample_rate_);
+    const AcquisitionResult result = acquisition.searchSatellite(samples, 9);
+    EXPECT_TRUE(result.found);
+    EXPECT_EQ(result.prn, 9);
+    EXPECT_NEAR(result.code_phase, 512.5, 0.5);
+    EXPECT_NEAR(result.doppler_shift, -1500.0, DOPPLER_SEARCH_STEP / 2.0);
+
+    // Another PRN's code does not match
+    EXPECT_FALSE(acquisition.searchSatellite(samples, 10).found);
+}
+
+TEST_F(AcquisitionTest, SpectrumShiftMatchesCarrierWipeoff) {
+    // A step finer than the FFT bin leaves a residual on most bins
+    const IQBuffer samples = makeSignal({satellite(14, 2340.0, 87.0, 47.0)}, 1);
+
+    SignalAcquisition wipeoff(sample_rate_);
+    wipeoff.setDopplerSearchMode(DopplerSearchMode::CARRIER_WIPEOFF);
+    SignalAcquisition shifted(sample_rate_);
+    shifted.setDopplerSearchMode(DopplerSearchMode::SPECTRUM_SHIFT);
+
+    for (int prn : {14, 20}) {
+        const AcquisitionResult a = wipeoff.searchSatellite(samples, prn, -5000.0, 5000.0, 125.0);
+        const AcquisitionResult b = shifted.searchSatellite(samples, prn, -5000.0, 5000.0, 125.0);
+        EXPECT_EQ(a.found, b.found);
+        EXPECT_EQ(a.doppler_shift, b.doppler_shift);
+        EXPECT_NEAR(a.code_phase, b.code_phase, 1e-9);
+        EXPECT_NEAR(a.peak_ratio, b.peak_ratio, 1e-3 * a.peak_ratio);
+    }
+
+    const AcquisitionResult result = shifted.searchSatellite(samples, 14, -5000.0, 5000.0, 125.0);
+    EXPECT_TRUE(result.found);
+    EXPECT_NEAR(result.code_phase, 87.0, 0.5);
+    EXPECT_NEAR(result.doppler_shift, 2340.0, 125.0);
+}
+
+TEST_F(AcquisitionTest, DwellDetectsWeakSignal) {
+    // Too weak for one millisecond, plain for ten summed non-coherently
+    const IQBuffer weak = makeSignal({satellite(6, -820.0, 333.0, 42.0)}, 10);
+    SignalAcquisition single(sample_rate_);
+    EXPECT_FALSE(single.searchSatellite(weak, 6).found);
+
+    SignalAcquisition acquisition(sample_rate_);
+    acquisition.setNonCoherentBlocks(10);
+    acquisition.beginDwell({6, 7});
+    EXPECT_EQ(runDwell(acquisition, weak), 10);
+    ASSERT_TRUE(acquisition.isDwellComplete());
+    std::vector<AcquisitionResult> results = acquisition.getDwellResults();
+    ASSERT_EQ(results.size(), 2u);
+    EXPECT_TRUE(results[0].found);
+    EXPECT_NEAR(results[0].code_phase, 333.0, 0.5);
+    EXPECT_NEAR(results[0].doppler_shift, -820.0, DOPPLER_SEARCH_STEP / 2.0);
+    EXPECT_FALSE(results[1].found);
+
+    // 10 ms coherent blocks over data bits, starting mid-bit so every other
+    // block straddles a possible transition; pairs keep the clean one
+    SyntheticSatellite faint = satellite(6, -820.0, 333.0, 36.0);
+    faint.nav_data = true;
+    const IQBuffer bits = makeSignal({faint}, 40, 5 * code_samples_);
+    acquisition.setCoherentIntegration(10);
+    acquisition.setNonCoherentBlocks(4);
+    acquisition.beginDwell({6}, -1500.0, 0.0);
+    EXPECT_EQ(runDwell(acquisition, bits), 4);
+    results = acquisition.getDwellResults();
+    ASSERT_EQ(results.size(), 1u);
+    EXPECT_TRUE(results[0].found);
+    EXPECT_NEAR(results[0].code_phase, 333.0, 0.5);
+    EXPECT_NEAR(results[0].doppler_shift, -820.0, DOPPLER_SEARCH_STEP / 10.0 / 2.0);
+
+    // A strong signal is reported after the first block
+    const IQBuffer strong = makeSignal({satellite(6, -820.0, 333.0, 50.0)}, 10);
+    acquisition.setCoherentIntegration(1);
+    acquisition.setNonCoherentBlocks(10);
+    acquisition.beginDwell({6});
+    EXPECT_EQ(runDwell(acquisition, strong), 1);
+    results = acquisition.getDwellResults();
+    EXPECT_TRUE(results[0].found);
+    EXPECT_NEAR(results[0].code_phase, 333.0, 0.5);
+}
+
+TEST_F(AcquisitionTest, MillisecondDwellSumsEveryBlock) {
+    // 1 ms blocks sit inside a half-bit, so the default dwell is plain
+    // non-coherent summing: same peaks, same detections, block for block
+    SignalAcquisition plain(sample_rate_);
+    plain.setHalfBitCombining(false);
+    SignalAcquisition standard(sample_rate_);
+    int plain_found = 0;
+    int standard_found = 0;
+    for (uint64_t run = 0; run < 8; ++run) {
+        SyntheticSatellite sat = satellite(5, 1700.0, 512.4, 40.0);
+        sat.nav_data = true;
+        const IQBuffer samples = makeSignal({sat}, 10, run * 10 * code_samples_);
+        for (SignalAcquisition* acquisition : {&plain, &standard}) {
+            acquisition->setNonCoherentBlocks(10);
+            acquisition->setEarlyReportRatio(1e9);
+            acquisition->beginDwell({5});
+            EXPECT_EQ(runDwell(*acquisition, samples), 10);
+        }
+        const AcquisitionResult a = plain.getDwellResults()[0];
+        const AcquisitionResult b = standard.getDwellResults()[0];
+        EXPECT_EQ(a.peak_ratio, b.peak_ratio) << "run " << run;
+        expectSameResult(a, b);
+        plain_found += a.found;
+        standard_found += b.found;
+    }
+    EXPECT_GE(standard_found, plain_found);
+    EXPECT_GT(standard_found, 0);
+}
+
+TEST_F(AcquisitionTest, BatchMatchesPerPrnSearch) {
+    const IQBuffer samples = makeSignal({satellite(2, 3100.0, 45.0, 47.0),
+                                         satellite(11, -4400.0, 901.5, 49.0),
+                                         satellite(30, 600.0, 250.0, 46.0)}, 1);
+    // More PRNs than one batch group, and a last group that is not full
+    std::vector<int> prns;
+    for (int prn = 1; prn <= 2 * static_cast<int>(SignalAcquisition::BATCH_PRNS) + 3; ++prn) {
+        prns.push_back(prn);
+    }
+    prns.push_back(30);
+
+    SignalAcquisition acquisition(sample_rate_);
+    const std::vector<AcquisitionResult> expected = acquisition.searchAllSatellites(samples, prns);
+    for (bool parallel : {false, true}) {
+        acquisition.setParallelProcessing(parallel);
+        const std::vector<AcquisitionResult> results = acquisition.searchBatch(samples, prns);
+        ASSERT_EQ(results.size(), expected.size());
+        for (size_t i = 0; i < results.size(); ++i) {
+            EXPECT_EQ(results[i].prn, expected[i].prn);
+            EXPECT_EQ(results[i].found, expected[i].found) << "PRN " << expected[i].prn;
+            EXPECT_EQ(results[i].code_phase, expected[i].code_phase);
+            EXPECT_EQ(results[i].doppler_shift, expected[i].doppler_shift);
+            EXPECT_NEAR(results[i].peak_ratio, expected[i].peak_ratio, 1e-3 * expected[i].peak_ratio);
+            EXPECT_NEAR(results[i].snr_estimate, expected[i].snr_estimate, 1e-3);
+        }
+    }
+
+    for (int prn : {2, 11, 30}) {
+        EXPECT_TRUE(expected[std::find(prns.begin(), prns.end(), prn) - prns.begin()].found);
+    }
+    EXPECT_NEAR(expected[10].code_phase, 901.5, 0.5);
+    EXPECT_NEAR(expected[10].doppler_shift, -4400.0, DOPPLER_SEARCH_STEP / 2.0);
+}
+
+TEST_F(AcquisitionTest, TwoStageRefinesDoppler) {
+    // Off the 500 Hz coarse grid; the fine stage should land within tens of Hz
+    const IQBuffer samples = makeSignal({satellite(19, 1234.0, 612.25, 50.0),
+                                         satellite(27, -3077.0, 80.6, 50.0)}, 10);
+    SignalAcquisition acquisition(sample_rate_);
+    ASSERT_EQ(acquisition.getFineIntegration(), 10);
+    const std::vector<AcquisitionResult> results = acquisition.searchTwoStage(samples, {19, 27, 4});
+    ASSERT_EQ(results.size(), 3u);
+
+    EXPECT_TRUE(results[0].found);
+    EXPECT_NEAR(results[0].doppler_shift, 1234.0, 20.0);
+    EXPECT_NEAR(results[0].code_phase, 612.25, 0.5);
+    EXPECT_TRUE(results[1].found);
+    EXPECT_NEAR(results[1].doppler_shift, -3077.0, 20.0);
+    EXPECT_NEAR(results[1].code_phase, 80.6, 0.5);
+    EXPECT_FALSE(results[2].found);
+}
+
+class TrackingSchedulerTest : public AcquisitionTest {
+protected:
+    using Channels = std::vector<std::unique_ptr<TrackingChannel>>;
+
+    // Channels handed the true code phase and Doppler of each satellite
+    Channels startChannels(const std::vector<SyntheticSatellite>& satellites) {
+        Channels channels;
+        for (const SyntheticSatellite& sat : satellites) {
+            channels.push_back(std::make_unique<TrackingChannel>(sat.prn, sample_rate_));
+            const AcquisitionResult result = {true, sat.prn, sat.code_phase, sat.doppler, 0.0, 0.0};
+            EXPECT_TRUE(channels.back()->handoff(result, 0));
+        }
+        return channels;
+    }
+
+    // One epoch per code period until the scheduler has run `epochs`
+    static void track(TrackingScheduler& scheduler, const IQBuffer& samples,
+                      const Channels& channels, uint64_t epochs) {
+        std::vector<TrackingChannel*> active;
+        std::vector<size_t> last_offset(channels.size(), 0);
+        while (scheduler.getEpoch() < epochs) {
+            active.clear();
+            for (size_t i = 0; i < channels.size(); ++i) {
+                ASSERT_TRUE(channels[i]->prepareSpan(0, samples.size()));
+                // Every channel was updated before the last runEpoch() returned
+                if (scheduler.getEpoch() > 0) {
+                    EXPECT_GT(channels[i]->getSpan().offset, last_offset[i]);
+                }
+                last_offset[i] = channels[i]->getSpan().offset;
+                active.push_back(channels[i].get());
+            }
+            scheduler.runEpoch(samples.data(), samples.size(), active);
+        }
+    }
+};
+
+TEST_F(TrackingSchedulerTest, AssignsRebalancesAndMatchesOneWorker) {
+    const std::vector<SyntheticSatellite> satellites = {satellite(3, 1234.0, 102.7, 48.0),
+                                                        satellite(7, 2100.0, 880.5, 47.0),
+                                                        satellite(11, -2702.0, 695.4, 46.0),
+                                                        satellite(22, 3309.0, 11.9, 47.0),
+                                                        satellite(31, -480.0, 400.2, 45.0)};
+    const uint64_t epochs = TrackingScheduler::REBALANCE_EPOCHS;
+    const IQBuffer samples = makeSignal(satellites, epochs + 10);
+
+    TrackingSchedulerConfig config;
+    config.num_workers = 4;
+    config.pin_cores = false;
+    TrackingScheduler scheduler(sample_rate_, config);
+    config.num_workers = 1;
+    TrackingScheduler reference(sample_rate_, config);
+    const Channels channels = startChannels(satellites);
+    const Channels reference_channels = startChannels(satellites);
+
+    // Before any cost is known new channels are dealt out in turn
+    track(scheduler, samples, channels, 1);
+    std::vector<int> count(scheduler.size(), 0);
+    for (const SyntheticSatellite& sat : satellites) {
+        const int worker = scheduler.getWorker(sat.prn);
+        ASSERT_GE(worker, 0);
+        ASSERT_LT(worker, static_cast<int>(scheduler.size()));
+        ++count[worker];
+        EXPECT_GT(scheduler.getChannelCost(sat.prn), 0.0);
+    }
+    EXPECT_LE(*std::max_element(count.begin(), count.end()) - *std::min_element(count.begin(), count.end()), 1);
+    EXPECT_EQ(scheduler.getWorker(5), -1);
+
+    track(scheduler, samples, channels, epochs);
+    track(reference, samples, reference_channels, epochs);
+    ASSERT_EQ(scheduler.getEpoch(), epochs);
+
+    // Loops closed on any worker follow the ones closed on a single worker
+    for (size_t i = 0; i < satellites.size(); ++i) {
+        const SatelliteInfo info = channels[i]->getSatelliteInfo();
+        const SatelliteInfo expected = reference_channels[i]->getSatelliteInfo();
+        EXPECT_EQ(channels[i]->getState(), ChannelState::TRACKING);
+        EXPECT_NEAR(info.doppler_shift, satellites[i].doppler, 10.0);
+        EXPECT_NEAR(info.doppler_shift, expected.doppler_shift, 1.0);
+        EXPECT_NEAR(info.code_phase, expected.code_phase, 0.01);
+    }
+
+    // The rebalance just run placed the most expensive channel first, so
+    // no worker carries more than one channel's cost above another
+    std::vector<double> load(scheduler.size(), 0.0);
+    double largest = 0.0;
+    for (const SyntheticSatellite& sat : satellites) {
+        load[scheduler.getWorker(sat.prn)] += scheduler.getChannelCost(sat.prn);
+        largest = std::max(largest, scheduler.getChannelCost(sat.prn));
+    }
+    EXPECT_LE(*std::max_element(load.begin(), load.end()) - *std::min_element(load.begin(), load.end()),
+              largest + 1e-9);
+}
+
+class GPSTrackerTest : public AcquisitionTest {
+protected:
+    // Carrier state a channel reports after one code period
+    struct PeriodState {
+        double carrier_freq;
+        double carrier_phase;
+    };
+
+    static bool sameState(const PeriodState& a, const PeriodState& b) {
+        return std::abs(a.carrier_freq - b.carrier_freq) < 0.01
+            && std::abs(std::remainder(a.carrier_phase - b.carrier_phase, 2.0 * M_PI)) < 0.01;
+    }
+};
+
+TEST_F(GPSTrackerTest, BatchMatchesPerMillisecondTracking) {
+    const std::vector<int> prns = {3, 11, 22, 5};
+    const IQBuffer samples = makeSignal({satellite(3, 1234.0, 102.7, 47.0),
+                                         satellite(11, -2702.0, 695.4, 45.0),
+                                         satellite(22, 3309.0, 11.9, 46.0)}, 200);
+    TrackingSchedulerConfig config;
+    config.num_workers = 2;
+    config.pin_cores = false;
+
+    // Per-millisecond reference: the state each block leaves every channel in
+    GPSTracker stepped(sample_rate_, config);
+    stepped.initialize(prns);
+    stepped.startTracking();
+    std::map<int, std::vector<PeriodState>> expected;
+    for (size_t start = 0; start < samples.size(); start += code_samples_) {
+        stepped.processSamples(IQBuffer(samples.begin() + start, samples.begin() + start + code_samples_));
+        for (const SatelliteInfo& info : stepped.getTrackedSatellites()) {
+            std::vector<PeriodState>& states = expected[info.prn];
+            const PeriodState state = {info.doppler_shift, info.carrier_phase};
+            if (info.is_tracked && (states.empty() || !sameState(states.back(), state))) {
+                states.push_back(state);
+            }
+        }
+    }
+    // The first state is the hand-off itself, before any period
+    for (auto& entry : expected) {
+        if (!entry.second.empty()) {
+            entry.second.erase(entry.second.begin());
+        }
+    }
+    EXPECT_TRUE(expected[5].empty());
+
+    // Two spans: the first hands the satellites off part way through and
+    // tracks them over its rest, the second only tracks
+    GPSTracker batched(sample_rate_, config);
+    batched.initialize(prns);
+    batched.startTracking();
+    std::vector<TrackingEpoch> epochs;
+    std::map<int, size_t> matched;
+    const size_t span = samples.size() / 2;
+    for (size_t start = 0; start < samples.size(); start += span) {
+        batched.processBatch(samples.data() + start, span, epochs);
+
+        // Grouped by channel, in time order within a channel
+        std::vector<int> order;
+        for (size_t i = 0; i < epochs.size(); ++i) {
+            if (i == 0 || epochs[i].prn != epochs[i - 1].prn) {
+                EXPECT_EQ(std::count(order.begin(), order.end(), epochs[i].prn), 0);
+                order.push_back(epochs[i].prn);
+            } else {
+                EXPECT_GT(epochs[i].first_sample, epochs[i - 1].first_sample);
+            }
+            EXPECT_GE(epochs[i].first_sample + code_samples_, start);
+            EXPECT_LT(epochs[i].first_sample, start + span);
+        }
+        EXPECT_EQ(order.size(), 3u);
+        EXPECT_EQ(std::count(order.begin(), order.end(), 5), 0);
+
+        // Every state the stepped run passed through is a period of the
+        // batch, in the same order. The stepped run only shows the last of
+        // the two periods a block now and then completes, so a batch period
+        // may go unmatched, but only on its own
+        for (int prn : order) {
+            std::vector<PeriodState> periods;
+            uint64_t first_sample = UINT64_MAX;
+            for (const TrackingEpoch& epoch : epochs) {
+                if (epoch.prn == prn) {
+                    periods.push_back({epoch.carrier_freq, epoch.carrier_phase});
+                    first_sample = std::min(first_sample, epoch.first_sample);
+                }
+            }
+            // Handed off once the 10 ms dwell is over, then tracked in the same span
+            if (start == 0) {
+                EXPECT_GE(first_sample, 9 * code_samples_) << "PRN " << prn;
+            }
+            const std::vector<PeriodState>& states = expected[prn];
+            size_t unmatched = 0;
+            for (const PeriodState& period : periods) {
+                ASSERT_LT(matched[prn], states.size()) << "PRN " << prn;
+                if (sameState(period, states[matched[prn]])) {
+                    ++matched[prn];
+                    unmatched = 0;
+                } else {
+                    EXPECT_EQ(++unmatched, 1u) << "PRN " << prn << " span " << start / span;
+                }
+            }
+            EXPECT_EQ(unmatched, 0u) << "PRN " << prn;
+            if (start + span == samples.size()) {
+                EXPECT_EQ(matched[prn], states.size()) << "PRN " << prn;
+            }
+        }
+    }
+
+    // Both runs end in the same state
+    const std::vector<SatelliteInfo> a = stepped.getTrackedSatellites();
+    const std::vector<SatelliteInfo> b = batched.getTrackedSatellites();
+    ASSERT_EQ(a.size(), b.size());
+    for (size_t i = 0; i < a.size(); ++i) {
+        EXPECT_EQ(a[i].is_tracked, b[i].is_tracked) << "PRN " << a[i].prn;
+        EXPECT_NEAR(a[i].doppler_shift, b[i].doppler_shift, 0.01) << "PRN " << a[i].prn;
+        EXPECT_NEAR(a[i].code_phase, b[i].code_phase, 1e-3) << "PRN " << a[i].prn;
+    }
+}
+
+TEST(SeqLockTest, ReadersNeverSeeTornValues) {
+    // Every field of a store holds the same count, so a torn copy shows up
+    struct Value {
+        uint64_t words[12];
+    };
+    SeqLock<Value> lock;
+    EXPECT_EQ(lock.version(), 0u);
+
+    const uint64_t num_stores = 20000;
+    std::thread writer([&] {
+        Value value;
+        for (uint64_t n = 1; n <= num_stores; ++n) {
+            std::fill(std::begin(value.words), std::end(value.words), n);
+            lock.store(value);
+        }
+    });
+
+    uint64_t last_version = 0;
+    Value value;
+    while (last_version < num_stores) {
+        const uint64_t version = lock.load(value);
+        ASSERT_GE(version, last_version);
+        for (uint64_t word : value.words) {
+            ASSERT_EQ(word, version);
+        }
+        last_version = version;
+    }
+    writer.join();
+    EXPECT_EQ(lock.version(), num_stores);
+}
+
+TEST(RingBufferTest, MirrorWrapAndDrops) {
+    // Capacity rounds up to 16; reads of up to 8 come out contiguous
+    SpscRingBuffer<int> ring(12, 8);
+    EXPECT_EQ(ring.capacity(), 16u);
+    EXPECT_EQ(ring.maxRead(), 8u);
+    EXPECT_THROW(SpscRingBuffer<int>(8, 9), std::invalid_argument);
+
+    int next_write = 0;
+    int next_read = 0;
+    auto writeBlock = [&](size_t n) {
+        std::vector<int> block(n);
+        for (int& value : block) {
+            value = next_write++;
+        }
+        return ring.write(block.data(), n);
+    };
+    auto readBlock = [&](size_t n) {
+        SampleSpan<int> span;
+        ASSERT_TRUE(ring.readSpan(n, span));
+        ASSERT_EQ(span.size, n);
+        for (size_t i = 0; i < n; ++i) {
+            ASSERT_EQ(span.data[i], next_read + static_cast<int>(i));
+        }
+        next_read += static_cast<int>(n);
+        ring.commitRead(n);
+    };
+
+    // Walk the write position around the ring several times with blocks
+    // that split at the wrap point, so reads cross it through the mirror
+    for (int round = 0; round < 10; ++round) {
+        ASSERT_TRUE(writeBlock(7));
+        ASSERT_TRUE(writeBlock(5));
+        readBlock(8);
+        readBlock(4);
+    }
+    EXPECT_EQ(ring.size(), 0u);
+
+    // Leave 10 in the ring with the read position just before the wrap
+    ASSERT_TRUE(writeBlock(6));
+    readBlock(6);
+    ASSERT_TRUE(writeBlock(10));
+    SampleSpan<int> span;
+    EXPECT_FALSE(ring.readSpan(11, span));
+    EXPECT_FALSE(ring.readSpan(9, span));   // Longer than the mirror
+    readBlock(8);
+
+    // A block that does not fit is dropped whole and counted
+    EXPECT_EQ(ring.droppedBlocks(), 0u);
+    ASSERT_TRUE(writeBlock(12));
+    const int dropped_start = next_write;
+    EXPECT_FALSE(writeBlock(3));
+    EXPECT_FALSE(writeBlock(5));
+    EXPECT_EQ(ring.droppedBlocks(), 2u);
+    EXPECT_EQ(ring.size(), 14u);
+    ring.recordDroppedBlock();
+    EXPECT_EQ(ring.droppedBlocks(), 3u);
+
+    // What was kept reads back in order, with nothing of the dropped blocks
+    readBlock(2);
+    readBlock(8);
+    readBlock(4);
+    EXPECT_EQ(next_read, dropped_start);
+    EXPECT_EQ(ring.size(), 0u);
+}
+
+namespace {
+
+// Set a navigation message field by its ICD subframe bit number
+void setNavField(std::array<uint32_t, 10>& words, int start, int length, uint32_t value) {
+    const int word = (start - 1) / 30;
+    const int shift = 24 - (start - 1) % 30 - length;
+    const uint32_t mask = ((length == 32 ? 0u : 1u << length) - 1u) << shift;
+    words[word] = (words[word] & ~mask) | ((value << shift) & mask);
+}
+
+// Split a 32-bit field into its 8 MSBs and 24 LSBs in two words
+void setNavField32(std::array<uint32_t, 10>& words, int hi_start, int lo_start, uint32_t value) {
+    setNavField(words, hi_start, 8, value >> 24);
+    setNavField(words, lo_start, 24, value & 0xFFFFFFu);
+}
+
+// Encode 24 data bits with parity as ICD-GPS-200 20.3.5, given D29*, D30*
+uint32_t encodeNavWord(uint32_t data, uint32_t previous) {
+    const uint32_t masks[6] = {
+        0xBB1F3480, 0x5D8F9A40, 0xAEC7CD00, 0x5763E680, 0x6BB1F340, 0x8B7A89C0
+    };
+    const uint32_t source = ((previous & 3u) << 30) | (data << 6);
+    uint32_t parity = 0;
+    for (uint32_t mask : masks) {
+        parity = (parity << 1) | (__builtin_popcount(source & mask) & 1u);
+    }
+    const uint32_t sent = (previous & 1u) ? data ^ 0xFFFFFFu : data;
+    return (sent << 6) | parity;
+}
+
+
+// Parity encode subframes onto a bit stream, D1 first
+template <typename Subframes>
+void appendNavSubframes(std::vector<bool>& stream, const Subframes& subframes) {
+    uint32_t previous = 0;
+    for (const auto& words : subframes) {
+        for (uint32_t data : words) {
+            const uint32_t word = encodeNavWord(data, previous);
+            for (int bit = 29; bit >= 0; --bit) {
+                stream.push_back((word >> bit) & 1u);
+            }
+            previous = word & 3u;
+        }
+    }
+}
+
+}
+
+TEST(NavigationDecoderTest, WordParity) {
+    std::mt19937 rng(7);
+    for (int i = 0; i < 1000; ++i) {
+        const uint32_t data = rng() & 0xFFFFFFu;
+        const uint32_t previous = rng() & 3u;
+        const uint32_t word = (previous << 30) | encodeNavWord(data, previous);
+
+        uint32_t decoded = 0;
+        ASSERT_TRUE(checkWordParity(word, decoded));
+        EXPECT_EQ(decoded, data);
+        // Any single bit error is caught
+        EXPECT_FALSE(checkWordParity(word ^ (1u << (rng() % 30)), decoded));
+    }
+}
+
+TEST(NavigationDecoderTest, DecodesEphemerisFromBitStream) {
+    const int32_t m0 = -123456789;
+    const uint32_t ecc = 0x01234567;
+    const uint32_t sqrt_a = 2702035353u;
+    const int32_t omega0 = 987654321;
+    const int32_t i0 = 0x28000000;
+    const int32_t w = -55555555;
+    const uint32_t first_tow_count = 100000;
+
+    std::array<std::array<uint32_t, 10>, 5> subframes{};
+    for (int id = 1; id <= 5; ++id) {
+        auto& words = subframes[id - 1];
+        setNavField(words, 1, 8, 0x8B);
+        setNavField(words, 31, 17, first_tow_count + id);
+        setNavField(words, 50, 3, id);
+    }
+    setNavField(subframes[1], 61, 8, 42);
+    setNavField32(subframes[1], 107, 121, static_cast<uint32_t>(m0));
+    setNavField32(subframes[1], 167, 181, ecc);
+    setNavField32(subframes[1], 227, 241, sqrt_a);
+    setNavField(subframes[1], 271, 16, 450);
+    setNavField32(subframes[2], 77, 91, static_cast<uint32_t>(omega0));
+    setNavField32(subframes[2], 137, 151, static_cast<uint32_t>(i0));
+    setNavField32(subframes[2], 197, 211, static_cast<uint32_t>(w));
+    setNavField(subframes[2], 271, 8, 42);
+
+    for (bool inverted : {false, true}) {
+        std::mt19937 rng(inverted ? 3 : 5);
+        std::vector<bool> stream;
+        // Start mid-subframe so sync has to be found
+        for (int i = 0; i < 137; ++i) {
+            stream.push_back(rng() & 1u);
+        }
+        appendNavSubframes(stream, subframes);
+
+        NavigationDecoder decoder;
+        for (size_t i = 0; i < stream.size(); ++i) {
+            decoder.addNavigationBit(7, stream[i] != inverted, i * 0.02);
+        }
+
+        EphemerisData eph;
+        ASSERT_TRUE(decoder.hasValidEphemeris(7));
+        ASSERT_TRUE(decoder.getEphemeris(7, eph));
+        EXPECT_EQ(eph.prn, 7);
+        EXPECT_DOUBLE_EQ(eph.m0, m0 * std::ldexp(1.0, -31) * M_PI);
+        EXPECT_DOUBLE_EQ(eph.ecc, ecc * std::ldexp(1.0, -33));
+        EXPECT_DOUBLE_EQ(eph.sqrt_a, sqrt_a * std::ldexp(1.0, -19));
+        EXPECT_DOUBLE_EQ(eph.toe, 7200.0);
+        EXPECT_DOUBLE_EQ(eph.omega0, omega0 * std::ldexp(1.0, -31) * M_PI);
+        EXPECT_DOUBLE_EQ(eph.i0, i0 * std::ldexp(1.0, -31) * M_PI);
+        EXPECT_DOUBLE_EQ(eph.w, w * std::ldexp(1.0, -31) * M_PI);
+        EXPECT_DOUBLE_EQ(decoder.getTimeOfWeek(7), (first_tow_count + 4) * 6.0);
+        EXPECT_FALSE(decoder.hasValidEphemeris(8));
+    }
+}
+
+TEST(NavigationDecoderTest, StreamingSyncAndCallbacks) {
+    // Subframes 1-5, 1, 2 with consecutive TOW counts
+    std::vector<std::array<uint32_t, 10>> subframes(7);
+    for (size_t i = 0; i < subframes.size(); ++i) {
+        auto& words = subframes[i];
+        setNavField(words, 1, 8, 0x8B);
+        setNavField(words, 31, 17, 5000 + static_cast<uint32_t>(i));
+        setNavField(words, 50, 3, static_cast<uint32_t>(i % 5 + 1));
+    }
+    setNavField(subframes[1], 61, 8, 9);
+    setNavField(subframes[1], 271, 16, 225);
+    setNavField(subframes[2], 271, 8, 9);
+
+    std::mt19937 rng(11);
+    std::vector<bool> stream;
+    for (int i = 0; i < 209; ++i) {
+        stream.push_back(rng() & 1u);
+    }
+    // Word 10 always ends in two zeros, which the next TLM's parity covers
+    stream.push_back(false);
+    stream.push_back(false);
+    const size_t first_bit = stream.size();
+    appendNavSubframes(stream, subframes);
+    // Corrupt subframe 4, which drops the lock until 5 is confirmed by 1
+    stream[first_bit + 3 * 300 + 100] = !stream[first_bit + 3 * 300 + 100];
+
+    NavigationDecoder decoder;
+    std::vector<int> ids;
+    std::vector<double> tows;
+    int ephemerides = 0;
+    decoder.setSubframeCallback([&](int prn, const NavigationDecoder::Subframe& sf) {
+        EXPECT_EQ(prn, 12);
+        ids.push_back(sf.id);
+        tows.push_back(sf.tow);
+    });
+    decoder.setEphemerisCallback([&](const EphemerisData& eph) {
+        EXPECT_EQ(eph.prn, 12);
+        EXPECT_DOUBLE_EQ(eph.toe, 3600.0);
+        ++ephemerides;
+    });
+
+    for (size_t i = 0; i < stream.size(); ++i) {
+        decoder.addNavigationBit(12, stream[i], i * 0.02);
+        if (i + 1 == first_bit + 400) {
+            // The first subframe is only a candidate until the second follows it
+            EXPECT_EQ(decoder.getFrameSync(12), NavigationDecoder::FrameSync::VERIFY);
+            EXPECT_TRUE(ids.empty());
+        }
+    }
+
+    EXPECT_EQ(ids, (std::vector<int>{1, 2, 3, 5, 1, 2}));
+    EXPECT_EQ(tows, (std::vector<double>{29994, 30000, 30006, 30018, 30024, 30030}));
+    EXPECT_EQ(ephemerides, 1);
+    EXPECT_EQ(decoder.getFrameSync(12), NavigationDecoder::FrameSync::LOCKED);
+    EXPECT_EQ(decoder.getFrameSync(13), NavigationDecoder::FrameSync::SEARCH);
+    EXPECT_DOUBLE_EQ(decoder.getTimeOfWeek(12), 30030.0);
+}
+
+TEST(HotStartTest, RoundTripAndValidation) {
+    HotStartState state;
+    state.saved_time = 1.7e9 + 0.25;
+    state.ephemeris[4] = EphemerisData{4, 7200.0, 5153.7, 0.0123, 0.96, -2.1, 0.7, 1.3};
+    state.ephemeris_valid[4] = true;
+    state.channels[9] = SatelliteInfo{9, -2345.5, 512.25, 1.5, 44.5, true, false};
+    state.almanac[30] = AlmanacData{30, 0, 319488.0, 0.004, 0.95, -8e-9, 5153.6,
+                                    2.5, -1.2, 0.3, 1e-5, 0.0};
+    state.almanac_valid[30] = true;
+
+    const std::string path = ::testing::TempDir() + "hot_start_test.bin";
+    ASSERT_TRUE(saveHotStart(path, state));
+
+    HotStartState loaded;
+    ASSERT_TRUE(loadHotStart(path, loaded));
+    EXPECT_DOUBLE_EQ(loaded.saved_time, state.saved_time);
+    EXPECT_TRUE(loaded.ephemeris_valid[4]);
+    EXPECT_FALSE(loaded.ephemeris_valid[5]);
+    EXPECT_EQ(loaded.ephemeris[4].prn, 4);
+    EXPECT_DOUBLE_EQ(loaded.ephemeris[4].sqrt_a, 5153.7);
+    EXPECT_DOUBLE_EQ(loaded.ephemeris[4].m0, 1.3);
+    EXPECT_TRUE(loaded.channels[9].is_tracked);
+    EXPECT_FALSE(loaded.channels[10].is_tracked);
+    EXPECT_DOUBLE_EQ(loaded.channels[9].doppler_shift, -2345.5);
+    EXPECT_DOUBLE_EQ(loaded.channels[9].cn0, 44.5);
+    EXPECT_TRUE(loaded.almanac_valid[30]);
+    EXPECT_FALSE(loaded.almanac_valid[29]);
+    EXPECT_DOUBLE_EQ(loaded.almanac[30].toa, 319488.0);
+    EXPECT_DOUBLE_EQ(loaded.almanac[30].omega_dot, -8e-9);
+    EXPECT_DOUBLE_EQ(loaded.almanac[30].af0, 1e-5);
+
+    std::vector<char> bytes;
+    {
+        std::ifstream in(path, std::ios::binary);
+        bytes.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+    auto rewrite = [&](const std::vector<char>& contents) {
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        out.write(contents.data(), static_cast<std::streamsize>(contents.size()));
+    };
+
+    // A flipped payload bit, a newer format and a short file are all refused
+    std::vector<char> corrupt = bytes;
+    corrupt[100] ^= 0x10;
+    rewrite(corrupt);
+    EXPECT_FALSE(loadHotStart(path, loaded));
+
+    std::vector<char> newer = bytes;
+    newer[4] += 1;
+    rewrite(newer);
+    EXPECT_FALSE(loadHotStart(path, loaded));
+
+    rewrite(std::vector<char>(bytes.begin(), bytes.end() - 8));
+    EXPECT_FALSE(loadHotStart(path, loaded));
+    EXPECT_DOUBLE_EQ(loaded.ephemeris[4].sqrt_a, 5153.7);
+
+    EXPECT_FALSE(loadHotStart(path + ".missing", loaded));
+    std::remove(path.c_str());
+
+    const char check[] = "123456789";
+    EXPECT_EQ(crc32(check, 9), 0xCBF43926u);
+
+    // Ephemerides hold two hours either side of toe, across the week end
+    EphemerisData eph{};
+    eph.toe = 3600.0;
+    EXPECT_TRUE(ephemerisCurrent(eph, 3600.0 + 2 * 3600.0));
+    EXPECT_FALSE(ephemerisCurrent(eph, 3600.0 + 2 * 3600.0 + 1.0));
+    EXPECT_TRUE(ephemerisCurrent(eph, GPS_WEEK_SECONDS - 1800.0));
+    EXPECT_FALSE(ephemerisCurrent(eph, GPS_WEEK_SECONDS - 7200.0));
+}
+
+TEST(NavigationDecoderTest, DecodesAlmanacPage) {
+    NavigationData nav{};
+    std::array<uint32_t, 10> words{};
+    setNavField(words, 1, 8, 0x8B);
+    setNavField(words, 31, 17, 777);
+    setNavField(words, 50, 3, 5);
+    setNavField(words, 61, 2, 1);                   // Data ID
+    setNavField(words, 63, 6, 7);                   // SV ID
+    setNavField(words, 69, 16, 0x1234);             // e
+    setNavField(words, 91, 8, 144);                 // toa
+    setNavField(words, 99, 16, static_cast<uint32_t>(-1000) & 0xFFFF);
+    setNavField(words, 121, 16, static_cast<uint32_t>(-600) & 0xFFFF);
+    setNavField(words, 151, 24, 10554000);          // sqrt(A)
+    setNavField(words, 181, 24, static_cast<uint32_t>(-3000000) & 0xFFFFFF);
+    setNavField(words, 211, 24, 2500000);
+    setNavField(words, 241, 24, static_cast<uint32_t>(-123456) & 0xFFFFFF);
+    setNavField(words, 271, 8, 0x81);               // af0, 8 MSBs
+    setNavField(words, 290, 3, 0x5);                // af0, 3 LSBs
+    setNavField(words, 279, 11, 0x7FF);             // af1 = -1
+    std::copy(words.begin(), words.end(), nav.subframe[4]);
+    nav.subframe_valid[4] = true;
+
+    NavigationDecoder decoder;
+    decoder.processNavigationData(19, nav);
+
+    AlmanacData alm;
+    EXPECT_FALSE(decoder.getAlmanac(19, alm));
+    ASSERT_TRUE(decoder.getAlmanac(7, alm));
+    EXPECT_EQ(alm.prn, 7);
+    EXPECT_EQ(alm.health, 0);
+    EXPECT_DOUBLE_EQ(alm.toa, 144 * 4096.0);
+    EXPECT_DOUBLE_EQ(alm.ecc, 0x1234 * std::ldexp(1.0, -21));
+    EXPECT_DOUBLE_EQ(alm.i0, (0.3 - 1000 * std::ldexp(1.0, -19)) * M_PI);
+    EXPECT_DOUBLE_EQ(alm.omega_dot, -600 * std::ldexp(1.0, -38) * M_PI);
+    EXPECT_DOUBLE_EQ(alm.sqrt_a, 10554000 * std::ldexp(1.0, -11));
+    EXPECT_DOUBLE_EQ(alm.omega0, -3000000 * std::ldexp(1.0, -23) * M_PI);
+    EXPECT_DOUBLE_EQ(alm.w, 2500000 * std::ldexp(1.0, -23) * M_PI);
+    EXPECT_DOUBLE_EQ(alm.m0, -123456 * std::ldexp(1.0, -23) * M_PI);
+    EXPECT_DOUBLE_EQ(alm.af0, -1011 * std::ldexp(1.0, -20));
+    EXPECT_DOUBLE_EQ(alm.af1, -1 * std::ldexp(1.0, -38));
+}
+
+TEST(VisibilityPredictorTest, GeometryAndDoppler) {
+    AlmanacData alm{};
+    alm.prn = 5;
+    alm.toa = 61440.0;
+    alm.i0 = 0.3 * M_PI;
+    alm.sqrt_a = 5153.6;
+    alm.omega0 = 1.1;
+    alm.w = 0.4;
+    alm.m0 = -2.0;
+    const double tow = 65000.0;
+
+    // Directly below the satellite it is overhead and neither nearer nor further
+    const auto sat = VisibilityPredictor::satellitePosition(alm, tow);
+    const double radius = std::sqrt(sat[0] * sat[0] + sat[1] * sat[1] + sat[2] * sat[2]);
+    EXPECT_NEAR(radius, alm.sqrt_a * alm.sqrt_a, 1.0);
+    const ReceiverPosition below{std::asin(sat[2] / radius) * 180.0 / M_PI,
+                                 std::atan2(sat[1], sat[0]) * 180.0 / M_PI, 0.0};
+    VisibilityPredictor predictor;
+    auto predictions = predictor.predict({alm}, below, tow);
+    ASSERT_EQ(predictions.size(), 1u);
+    EXPECT_GT(predictions[0].elevation, 89.0);
+    EXPECT_NEAR(predictions[0].doppler, 0.0, 20.0);
+    EXPECT_GT(predictions[0].doppler_uncertainty, predictor.getConfig().clock_uncertainty);
+
+    // The far side of the Earth does not see it
+    const ReceiverPosition antipode{-below.latitude, below.longitude + 180.0, 0.0};
+    EXPECT_TRUE(predictor.predict({alm}, antipode, tow).empty());
+
+    // Off to one side the Doppler follows the change in range
+    const ReceiverPosition side{below.latitude - 40.0, below.longitude + 10.0, 300.0};
+    predictions = predictor.predict({alm}, side, tow);
+    ASSERT_EQ(predictions.size(), 1u);
+    const auto rx = VisibilityPredictor::receiverPosition(side);
+    auto range = [&](double t) {
+        const auto p = VisibilityPredictor::satellitePosition(alm, t);
+        return std::sqrt((p[0] - rx[0]) * (p[0] - rx[0]) + (p[1] - rx[1]) * (p[1] - rx[1])
+                         + (p[2] - rx[2]) * (p[2] - rx[2]));
+    };
+    const double wavelength = SPEED_OF_LIGHT / GPS_L1_FREQ_HZ;
+    const double expected = -(range(tow + 0.5) - range(tow - 0.5)) / wavelength;
+    EXPECT_GT(std::fabs(expected), 500.0);
+    EXPECT_NEAR(predictions[0].doppler, expected, 1.0);
+
+    // Known clock and position: only the almanac error and a few seconds of
+    // Doppler rate (under 1 Hz/s) are left
+    VisibilityConfig config;
+    config.clock_uncertainty = 0.0;
+    config.position_uncertainty = 0.0;
+    VisibilityPredictor narrow(config);
+    predictions = narrow.predict({alm}, side, tow);
+    ASSERT_EQ(predictions.size(), 1u);
+    EXPECT_NEAR(predictions[0].doppler_uncertainty, VisibilityPredictor::ALMANAC_DOPPLER_ERROR,
+                config.time_uncertainty);
+    config.time_uncertainty = 0.0;
+    narrow.setConfig(config);
+    predictions = narrow.predict({alm}, side, tow);
+    ASSERT_EQ(predictions.size(), 1u);
+    EXPECT_NEAR(predictions[0].doppler_uncertainty, VisibilityPredictor::ALMANAC_DOPPLER_ERROR, 1e-9);
+
+    // A tracked channel gives the oscillator offset
+    const SatelliteInfo tracked{5, predictions[0].doppler + 700.0, 0.0, 0.0, 45.0, true, false};
+    double offset = 0.0;
+    ASSERT_TRUE(predictor.estimateClockOffset(predictions, {tracked}, offset));
+    EXPECT_NEAR(offset, 700.0, 1e-9);
+
+    EXPECT_NEAR(gpsTimeOfWeek(1700000000.0), 252818.0, 1e-6);
+}
+
+TEST(NCOTest, ModesMatchReference) {
+    const double sample_rate = 2.048e6;
+    const double frequency = -4321.7;
+    const double phase = 2.9;
+    // Odd length exercises the scalar tail and carries phase across calls
+    const size_t length = 2047;
+    std::vector<float> carrier_i(length), carrier_q(length);
+    
+    for (NCOMode mode : {NCOMode::TABLE, NCOMode::ROTATOR, NCOMode::POLYNOMIAL}) {
+        const double tolerance = mode == NCOMode::TABLE ? 4e-3 : 1e-5;
+        CarrierNCO nco(sample_rate, mode);
+        nco.setPhase(phase);
+        nco.setFrequency(frequency);
+        
+        for (int block = 0; block < 3; ++block) {
+            nco.generate(length, carrier_i.data(), carrier_q.data());
+            for (size_t i = 0; i < length; ++i) {
+                double theta = phase + 2 * M_PI * frequency * (block * length + i) / sample_rate;
+                EXPECT_NEAR(carrier_i[i], std::cos(theta), tolerance);
+                EXPECT_NEAR(carrier_q[i], std::sin(theta), tolerance);
+            }
+        }
+    }
+    
+    std::vector<float> angles(1000), sines(1000), cosines(1000);
+    for (size_t i = 0; i < angles.size(); ++i) {
+        angles[i] = -20.0f + 0.04f * i;
+    }
+    CarrierNCO::sincos(angles.data(), sines.data(), cosines.data(), angles.size());
+    for (size_t i = 0; i < angles.size(); ++i) {
+        EXPECT_NEAR(sines[i], std::sin(angles[i]), 1e-5);
+        EXPECT_NEAR(cosines[i], std::cos(angles[i]), 1e-5);
+    }
+}
+
+TEST_F(PRNTest, CodeNCOMatchesChipIndexing) {
+    const double sample_rate = 2.048e6;
+    const double code_rate = GPS_CA_CODE_FREQ_HZ + 3.1;
+    const double start_phase = 1021.3;   // wraps within the first block
+    std::vector<float> code = prn_gen_->generateCodeFloat(5);
+    
+    CodeNCO nco(5, sample_rate);
+    nco.setPhase(start_phase);
+    nco.setRate(code_rate);
+    const size_t spacing = nco.spacingSamples();
+    ASSERT_EQ(spacing, 1u);
+    
+    const size_t length = 2048;
+    for (int block = 0; block < 2; ++block) {
+        nco.generate(length);
+        size_t mismatches = 0;
+        for (size_t i = 0; i < length; ++i) {
+            double chip = start_phase + (block * length + i) * code_rate / sample_rate;
+            auto at = [&](double c) {
+                long index = static_cast<long>(std::floor(c)) % GPS_CA_CODE_LENGTH;
+                return code[index < 0 ? index + GPS_CA_CODE_LENGTH : index];
+            };
+            // Fixed point may differ only on an exact chip boundary
+            mismatches += nco.prompt()[i] != at(chip);
+            EXPECT_EQ(nco.early()[i], nco.prompt()[i + spacing]);
+            EXPECT_EQ(nco.late()[i + spacing], nco.prompt()[i]);
+        }
+        EXPECT_LE(mismatches, 1u);
+    }
+}
+
 int main(int argc, char **argv) {
     ::testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();